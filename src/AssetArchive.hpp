@@ -0,0 +1,120 @@
+#ifndef ASSET_ARCHIVE
+#define ASSET_ARCHIVE
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <SFML/System/InputStream.hpp>
+#include <SFML/Graphics/Font.hpp>
+
+#include "Mesh.hpp"
+
+// Entry data starts on multiples of this so mapped assets can be read in place
+#define ARCHIVE_ALIGNMENT 16
+#define ARCHIVE_COMPRESSED 0x1
+
+/**
+ * Defines the fixed size header at the start of an archive
+*/
+struct ArchiveHeader {
+  char magic[4];
+  std::uint32_t version;
+  std::uint32_t entryCount;
+  std::uint32_t namesSize;
+};
+
+/**
+ * Defines a table of contents entry; entries are sorted by path hash for binary search
+*/
+struct ArchiveEntry {
+  std::uint64_t hash;
+  std::uint64_t offset;
+  std::uint32_t size;        // bytes once decompressed
+  std::uint32_t storedSize;  // bytes within the archive
+  std::uint32_t flags;
+  std::uint32_t nameOffset;  // offset of the null terminated path within the names table
+};
+
+/**
+ * Defines a read-only memory mapping of a whole file
+*/
+class MappedFile {
+  private:
+    const char *data = nullptr;
+    size_t size = 0;
+    void *file = nullptr, *mapping = nullptr;
+
+  public:
+    MappedFile() { };
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile() { close(); };
+    bool open(const std::string&);
+    void close();
+    const char* getData() const { return data; };
+    size_t getSize() const { return size; };
+};
+
+/**
+ * Defines an sf::InputStream reading one archive entry, straight from the mapping unless it is compressed
+*/
+class ArchiveStream : public sf::InputStream {
+  private:
+    const char *data = nullptr;
+    sf::Int64 size = 0, position = 0;
+    std::vector<char> decompressed;
+
+  public:
+    void open(const char*, size_t);
+    bool openCompressed(const char*, size_t, size_t);
+    const char* getData() const { return data; };
+    sf::Int64 read(void*, sf::Int64) override;
+    sf::Int64 seek(sf::Int64) override;
+    sf::Int64 tell() override { return position; };
+    sf::Int64 getSize() override { return size; };
+};
+
+/**
+ * Defines a packed archive of assets opened through a memory mapping
+ * Note: Streams and fonts read from the archive point into the mapping, so the archive must outlive them
+*/
+class AssetArchive {
+  private:
+    MappedFile file;
+    const ArchiveEntry *entries = nullptr;
+    const char *names = nullptr;
+    std::uint32_t entryCount = 0;
+
+    const ArchiveEntry* find(const std::string&) const;
+
+  public:
+    bool open(const std::string&);
+    bool contains(const std::string &path) const { return find(path) != nullptr; };
+    bool openStream(const std::string&, ArchiveStream&) const;
+    std::shared_ptr<ArchiveStream> openStream(const std::string&) const;
+    std::vector<std::string> list() const;
+    size_t getSize(const std::string&) const;
+
+    /**
+     * Loads any SFML resource which reads from an sf::InputStream, such as images, textures and sound buffers
+     * @tparam T The type of resource
+     * @param path The asset path
+     * @param asset The resource being loaded
+     * @return Whether the entry exists and decoded
+    */
+    template <typename T>
+    bool load(const std::string &path, T &asset) const {
+      ArchiveStream stream;
+      return openStream(path, stream) && asset.loadFromStream(stream);
+    };
+    std::shared_ptr<sf::Font> loadFont(const std::string&) const;
+    bool loadMesh(const std::string&, Mesh&, bool generateLODs=false) const;
+};
+
+int packArchive(const char*, const char*, bool);
+size_t compressLZ4(const char*, size_t, std::vector<char>&);
+bool decompressLZ4(const char*, size_t, char*, size_t);
+
+#endif
@@ -0,0 +1,82 @@
+#ifndef ASSET_CACHE
+#define ASSET_CACHE
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <SFML/Graphics.hpp>
+#include <SFML/Audio.hpp>
+
+#include "Mesh.hpp"
+#include "AssetLoader.hpp"
+
+#define DEFAULT_ASSET_BUDGET (256u << 20)
+
+/**
+ * Defines the kinds of asset held by the cache, used to break down memory usage
+*/
+enum class AssetType { Texture, Font, SoundBuffer, Mesh, Count };
+
+/**
+ * Defines a cache which loads each asset exactly once and shares it between every user
+ * Note: Assets only the cache still references are evicted, least recently used first, once over budget
+*/
+class AssetCache {
+  private:
+    /**
+     * Defines a cached asset, or one still loading when asset is null
+    */
+    struct Entry {
+      AssetType type;
+      std::string path;
+      std::shared_ptr<void> asset;
+      size_t bytes = 0;
+      unsigned long long lastUsed = 0;
+      std::shared_ptr<void> loading; // the AssetFuture of an asynchronous load in flight
+      std::vector<std::function<void()>> waiters;
+    };
+
+    std::unordered_map<std::uint64_t, Entry> entries;
+    size_t budget;
+    const AssetArchive *archive = nullptr;
+    bool generateLODs = false;
+    size_t totalBytes = 0;
+    unsigned long long clock = 0;
+
+    Entry* find(const std::string&, AssetType);
+    size_t fileSize(const std::string&) const;
+    void store(Entry&, std::shared_ptr<void>, size_t);
+    template <typename T> std::shared_ptr<T> get(const std::string&, AssetType, std::function<std::shared_ptr<T>()>);
+    template <typename T> AssetFuture<T> request(const std::string&, AssetType,
+      std::function<AssetFuture<T>(std::function<void(std::shared_ptr<T>)>)>, std::function<void(std::shared_ptr<T>)>);
+
+  public:
+    AssetCache(size_t budgetBytes=DEFAULT_ASSET_BUDGET) : budget(budgetBytes) { };
+    // Paths held by a mounted archive are read from it rather than from disk; the archive must outlive the cache
+    void mount(const AssetArchive *mounted) { archive = mounted; };
+    // Meshes loaded by getMesh without name_lodN.obj files beside them have their levels of detail generated
+    void setGenerateLODs(bool generate) { generateLODs = generate; };
+
+    std::shared_ptr<sf::Texture> getTexture(const std::string&);
+    std::shared_ptr<sf::Font> getFont(const std::string&);
+    std::shared_ptr<sf::SoundBuffer> getSoundBuffer(const std::string&);
+    std::shared_ptr<Mesh> getMesh(const std::string&);
+
+    AssetFuture<sf::Texture> loadTexture(const std::string&, AssetLoader&, std::function<void(std::shared_ptr<sf::Texture>)> callback=nullptr);
+    AssetFuture<sf::Font> loadFont(const std::string&, AssetLoader&, std::function<void(std::shared_ptr<sf::Font>)> callback=nullptr);
+    AssetFuture<Mesh> loadMesh(const std::string&, AssetLoader&, std::function<void(std::shared_ptr<Mesh>)> callback=nullptr);
+
+    void setBudget(size_t);
+    size_t evict(size_t);
+    size_t getMemoryUsage() const { return totalBytes; };
+    size_t getMemoryUsage(AssetType) const;
+    void report() const;
+};
+
+std::uint64_t hashPath(const std::string&);
+
+#endif
@@ -0,0 +1,70 @@
+#ifndef ASSET_LOADER
+#define ASSET_LOADER
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <SFML/Graphics.hpp>
+
+#include "Mesh.hpp"
+#include "AssetArchive.hpp"
+
+/**
+ * Defines a handle to an asset which may still be loading; it holds a null pointer if loading failed
+*/
+template <typename T>
+using AssetFuture = std::shared_future<std::shared_ptr<T>>;
+
+/**
+ * Defines a loader which decodes files on worker threads and finishes them on the main thread
+ * Note: Futures become ready and callbacks run inside update(), so never block on a future before calling it
+*/
+class AssetLoader {
+  private:
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> jobs;
+    std::mutex jobMutex;
+    std::condition_variable jobReady;
+    bool stopping = false;
+    const AssetArchive *archive = nullptr;
+    bool generateLODs = false;
+
+    // Completions hold the work which must run on the main thread, such as texture uploads
+    // They are swapped into ready and run from there, so neither queue is rebuilt each frame
+    std::deque<std::function<void()>> completions, ready;
+    std::mutex completionMutex;
+    int pending = 0;
+
+    void work();
+    void enqueue(std::function<void()>);
+    void complete(std::function<void()>);
+    template <typename T> AssetFuture<T> load(const std::string&, std::function<std::shared_ptr<T>()>,
+                                              std::function<bool(T&)>, std::function<void(std::shared_ptr<T>)>);
+
+  public:
+    AssetLoader(unsigned int threads=0);
+    ~AssetLoader();
+    // Paths held by a mounted archive are read from it rather than from disk; the archive must outlive the loader
+    void mount(const AssetArchive *mounted) { archive = mounted; };
+    // Meshes without name_lodN.obj files beside them have their levels of detail generated while loading
+    void setGenerateLODs(bool generate) { generateLODs = generate; };
+
+    AssetFuture<sf::Image> loadImage(const std::string&, std::function<void(std::shared_ptr<sf::Image>)> callback=nullptr);
+    AssetFuture<sf::Texture> loadTexture(const std::string&, std::function<void(std::shared_ptr<sf::Texture>)> callback=nullptr);
+    AssetFuture<sf::Font> loadFont(const std::string&, std::function<void(std::shared_ptr<sf::Font>)> callback=nullptr);
+    AssetFuture<Mesh> loadMesh(const std::string&, std::function<void(std::shared_ptr<Mesh>)> callback=nullptr);
+
+    int update();
+    void finish();
+    // Pending is only touched on the main thread, which both requests and finishes assets
+    int getPending() const { return pending; };
+};
+
+#endif
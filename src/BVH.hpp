@@ -0,0 +1,83 @@
+#ifndef BVH_TREE
+#define BVH_TREE
+
+#include <vector>
+
+#include "Mesh.hpp"
+
+// Rays per packet, matching the SSE lane count
+#define RAY_PACKET_SIZE 4
+
+/**
+ * Defines a ray segment from an origin along a direction up to a maximum distance
+ * Note: The direction does not need to be normalised; distances are in multiples of it
+*/
+struct Ray {
+  float origin[3], direction[3];
+  float maxT = 1e30f;
+
+  Ray() { };
+  Ray(const Point&, const Point&, float t=1e30f);
+  static Ray between(const Point&, const Point&);
+};
+
+/**
+ * Defines the closest intersection found along a ray
+*/
+struct RayHit {
+  float t = 1e30f;
+  float u = 0, v = 0;            // barycentric coordinates within the triangle
+  unsigned int triangle = ~0u;   // index of the triangle within the mesh triangle list
+  bool hit() const { return triangle != ~0u; }
+};
+
+/**
+ * Defines a bundle of coherent rays traced together, stored as one array per component
+*/
+struct RayPacket {
+  float origin[3][RAY_PACKET_SIZE], direction[3][RAY_PACKET_SIZE];
+  float maxT[RAY_PACKET_SIZE];
+
+  void set(int, const Ray&);
+};
+
+/**
+ * Defines a flattened node; the left child always directly follows its parent
+*/
+struct BVHNode {
+  float min[3], max[3];
+  unsigned int offset;  // the right child for internal nodes, the first triangle for leaves
+  unsigned short count; // the number of triangles in a leaf, 0 for internal nodes
+  unsigned short axis;  // the axis internal nodes were split along
+};
+
+/**
+ * Defines a bounding volume hierarchy over the triangles of a mesh built with the binned surface area heuristic
+*/
+class BVH {
+  private:
+    std::vector<BVHNode> nodes;
+    // Triangles are reordered so every leaf references a contiguous run
+    std::vector<unsigned int> order;
+    // Vertex and edge vectors per ordered triangle, precomputed for intersection
+    std::vector<float> triangleData;
+    int depth = 0;
+
+    unsigned int buildNode(std::vector<float>&, unsigned int, unsigned int, int);
+
+  public:
+    BVH() { };
+    BVH(const Mesh&);
+    void build(const std::vector<Point>&, const std::vector<unsigned int>&);
+
+    bool closestHit(const Ray&, RayHit&) const;
+    bool anyHit(const Ray&) const;
+    void closestHit(const RayPacket&, RayHit*) const;
+    bool pointInBounds(const Point&) const;
+    bool lineOfSight(const Point &from, const Point &to) const { return !anyHit(Ray::between(from, to)); };
+
+    size_t nodeCount() const { return nodes.size(); };
+    int getDepth() const { return depth; };
+};
+
+#endif
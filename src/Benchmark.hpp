@@ -0,0 +1,27 @@
+#ifndef BENCHMARK
+#define BENCHMARK
+
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * Defines the measured throughput of a single benchmark
+*/
+struct BenchmarkResult {
+  std::string name;
+  long long items = 0;   // work items processed per run
+  double seconds = 0;    // fastest run of all repeats
+  double median = 0;     // median run, steadier than the fastest when comparing commits
+  std::vector<double> samples;
+  double itemsPerSecond() const { return seconds > 0 ? items / seconds : 0; }
+};
+
+BenchmarkResult measure(const std::string&, long long, int, const std::function<void()>&);
+BenchmarkResult measure(const std::string&, long long, int, const std::function<void()>&, const std::function<void()>&);
+void printResult(const BenchmarkResult&, const BenchmarkResult *baseline=nullptr);
+int runBenchmarks(const char *filter="", const char *jsonFile=nullptr);
+const std::vector<std::pair<std::string, BenchmarkResult>>& getRecordedResults();
+
+#endif
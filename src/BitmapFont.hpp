@@ -0,0 +1,88 @@
+#ifndef BITMAP_FONT
+#define BITMAP_FONT
+
+#include <string>
+#include <vector>
+
+#include <SFML/Graphics.hpp>
+
+// Printable ASCII, from space to tilde
+#define FIRST_GLYPH 32
+#define GLYPH_COUNT 95
+#define VERTICES_PER_GLYPH 6
+
+/**
+ * Defines the metrics of a single glyph within the atlas
+*/
+struct BitmapGlyph {
+  sf::FloatRect bounds;     // relative to the pen position on the baseline
+  sf::IntRect textureRect;  // within the atlas
+  float advance = 0;
+};
+
+/**
+ * Defines a font baked once into a glyph atlas, with a ready-made quad per glyph
+*/
+class BitmapFont {
+  private:
+    sf::Image image;
+    sf::Texture texture;
+    BitmapGlyph glyphs[GLYPH_COUNT];
+    sf::Vertex quads[GLYPH_COUNT][VERTICES_PER_GLYPH];
+    unsigned int characterSize = 0;
+    float lineSpacing = 0;
+
+    void buildQuads();
+
+  public:
+    bool bake(const sf::Font&, unsigned int);
+    bool saveToFile(const std::string&) const;
+    bool loadFromFile(const std::string&);
+
+    // Characters outside printable ASCII are drawn as '?'
+    static int indexOf(char c) { return c >= FIRST_GLYPH && c < FIRST_GLYPH + GLYPH_COUNT ? c - FIRST_GLYPH : '?' - FIRST_GLYPH; };
+    const BitmapGlyph& getGlyph(char c) const { return glyphs[indexOf(c)]; };
+    const sf::Vertex* getQuad(char c) const { return quads[indexOf(c)]; };
+    const sf::Texture& getTexture() const { return texture; };
+    unsigned int getCharacterSize() const { return characterSize; };
+    float getLineSpacing() const { return lineSpacing; };
+    float measure(const std::string&) const;
+};
+
+/**
+ * Defines a batch of strings drawn from one bitmap font in a single draw call
+ * Note: Each string owns a fixed run of quads, so changing it only rewrites that run
+*/
+class TextBatch : public sf::Drawable, public sf::Transformable {
+  private:
+    /**
+     * Defines a string's run of quads within the batch
+    */
+    struct Slot {
+      size_t first, capacity, length = 0;
+      sf::Vector2f position;
+      sf::Color color;
+    };
+
+    const BitmapFont *font = nullptr;
+    std::vector<sf::Vertex> vertices;
+    std::vector<Slot> slots;
+
+    void write(Slot&, const char*, size_t);
+    void draw(sf::RenderTarget&, sf::RenderStates) const override;
+
+  public:
+    TextBatch() { };
+    TextBatch(const BitmapFont &bitmapFont) : font(&bitmapFont) { };
+    void setFont(const BitmapFont &bitmapFont) { font = &bitmapFont; };
+
+    int add(const std::string&, sf::Vector2f, sf::Color color=sf::Color::White, size_t capacity=0);
+    void set(int, const std::string&);
+    void setNumber(int, long long);
+    void setNumber(int, double, int);
+    void setColor(int, sf::Color);
+    void clear();
+    size_t getGlyphCount() const { return vertices.size() / VERTICES_PER_GLYPH; };
+};
+
+#endif
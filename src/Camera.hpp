@@ -0,0 +1,47 @@
+#ifndef CAMERA
+#define CAMERA
+
+#include <memory>
+
+#include <SFML/Graphics.hpp>
+
+#include "EntityManager.hpp"
+
+/**
+ * Defines a camera which smoothly follows an entity and supplies its view, and the world area it shows, for culling
+ * Note: Several cameras can render the same world, each into its own viewport, such as for split-screen or a minimap
+*/
+class Camera {
+  private:
+    sf::View view;
+    sf::Vector2f baseSize;
+    std::weak_ptr<Entity> target;
+    sf::Vector2f deadZone = sf::Vector2f(0, 0);  // half extents of the area the target moves in freely
+    float followRate = 5;                        // fraction of the remaining distance closed per second, as an exponential rate
+    float zoom = 1, targetZoom = 1, minZoom = 0.25f, maxZoom = 8;
+    sf::FloatRect bounds;
+    bool bounded = false;
+
+    void clampToBounds(sf::Vector2f&) const;
+
+  public:
+    Camera(const sf::FloatRect&);
+
+    void follow(std::shared_ptr<Entity> entity) { target = entity; };
+    void setDeadZone(sf::Vector2f halfSize) { deadZone = halfSize; };
+    void setFollowRate(float rate) { followRate = rate; };
+    void setCenter(sf::Vector2f);
+    void setViewport(const sf::FloatRect &viewport) { view.setViewport(viewport); };
+    void setBounds(const sf::FloatRect &area) { bounds = area; bounded = true; };
+    void setZoom(float, bool immediate=false);
+    void zoomBy(float factor) { setZoom(targetZoom * factor); };
+    void setZoomLimits(float low, float high) { minZoom = low; maxZoom = high; };
+    void resize(sf::Vector2f);
+
+    void update(float);
+    const sf::View& getView() const { return view; };
+    sf::FloatRect getVisibleRect() const;
+    float getZoom() const { return zoom; };
+};
+
+#endif
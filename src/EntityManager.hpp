@@ -2,11 +2,21 @@
 #define ENTITY_MANAGER
 
 #include <unordered_map>
+#include <vector>
 #include <iostream>
 #include <memory>
 
 #include <SFML/Graphics.hpp>
 
+#include "RenderQueue.hpp"
+#include "StaticLayer.hpp"
+#include "MemoryTracker.hpp"
+
+// Layers used by levels loaded from images; walls never move so their layer suits caching
+#define WALL_LAYER 1
+#define SPAWN_LAYER 2
+#define PLAYER_LAYER 3
+
 /**
  * A generic entity object for non-rendered requirements
 */
@@ -15,6 +25,9 @@ class Entity {
     std::string name = "id";
     sf::Vector2f position = sf::Vector2f(0, 0);
     sf::Vector2f size = sf::Vector2f(1, 1);
+    unsigned int sequence = 0;  // creation order, keeping draw order deterministic
+    unsigned char layer = 0;
+    unsigned short depth = 0;
 
   public:
     Entity() { };
@@ -22,7 +35,13 @@ class Entity {
     Entity(std::string id, sf::Vector2f pos) : name(id), position(pos) { };
     Entity(std::string id, sf::Vector2f pos, sf::Vector2f s) : name(id), position(pos), size(s) { };
     virtual void update() { };
-    virtual void render(sf::RenderWindow &window) { };
+    virtual void render(sf::RenderTarget &target) { };
+    virtual void submit(RenderQueue &queue) { };
+    virtual sf::FloatRect getBounds() const { return sf::FloatRect(position - size / 2.f, size); };
+    unsigned char getLayer() const { return layer; };
+    void setSequence(unsigned int order) { sequence = order; };
+    void setLayer(unsigned char drawLayer) { layer = drawLayer; };
+    void setDepth(unsigned short drawDepth) { depth = drawDepth; };
     virtual void print() {
       std::cout << position.x << " " << position.y << " " << size.x << " " << size.y << std::endl;
     }
@@ -41,7 +60,19 @@ class GraphicalEntity : public Entity {
     GraphicalEntity(std::string, sf::Vector2f, S);
     GraphicalEntity(std::string, sf::Vector2f, sf::Vector2f, S);
     bool intersects(const sf::FloatRect&);
-    void render(sf::RenderWindow&);
+    void render(sf::RenderTarget&);
+    void submit(RenderQueue&);
+    sf::FloatRect getBounds() const { return graphic.getGlobalBounds(); };
+};
+
+/**
+ * Defines the time spent in each phase of the last render in milliseconds
+*/
+struct RenderTimings {
+  double cull = 0;    // testing entities against the view
+  double build = 0;   // submitting visible entities and static chunks to the queue
+  double submit = 0;  // sorting, merging and drawing the queue
+  int visible = 0;
 };
 
 /**
@@ -51,6 +82,16 @@ class EntityManager {
   private:
     std::unordered_map<std::string, std::shared_ptr<Entity>> entities;
     std::string playerKey = ""; // Duplicate reference to the player entity for ease of access
+    RenderQueue queue;
+    unsigned int nextSequence = 0;
+    // Static layers are cached; entities added since the last render are checked against them then, once their layer is set
+    std::unordered_map<unsigned char, std::unique_ptr<StaticLayer>> staticLayers;
+    std::vector<std::shared_ptr<Entity>> added;
+    bool reserved = false;  // whether the queue and frame arena fit every entity being visible at once
+    RenderTimings timings;
+
+    void markDirty(const Entity&);
+    void reserveFrame();
 
   public:
     template <typename Derived = Entity, typename... Args> std::shared_ptr<Derived> addEntity(std::string, Args&&...);
@@ -62,8 +103,14 @@ class EntityManager {
     int size();
 
     void update();
-    void render(sf::RenderWindow&);
+    void render(sf::RenderTarget&);
+    void render(sf::RenderTarget&, const sf::View&);
+    const RenderQueue& getRenderQueue() const { return queue; };
+    const RenderTimings& getRenderTimings() const { return timings; };
+    void setLayerStatic(unsigned char, bool);
+    void markDirty(unsigned char, const sf::FloatRect&);
     void addFromFile(const char*, float pixelSize=32, sf::Vector2f offset=sf::Vector2f(0, 0));
+    void addFromImage(const sf::Image&, float pixelSize=32, sf::Vector2f offset=sf::Vector2f(0, 0));
     ~EntityManager();
 };
 
@@ -80,9 +127,15 @@ class EntityManager {
 */
 template <typename Derived, typename... Args>
 std::shared_ptr<Derived> EntityManager::addEntity(std::string id, Args&&... args) { 
+  MEMORY_TAG(MemoryTag::Entities);
   std::shared_ptr<Derived> newEntity = std::make_shared<Derived>(id, std::forward<Args>(args)...);
+  newEntity->setSequence(nextSequence++);
+  added.push_back(newEntity);
+  reserved = false;
   entities.insert(std::make_pair(id, newEntity));
   return newEntity;
 };
 
+sf::FloatRect viewBounds(const sf::View&);
+
 #endif
\ No newline at end of file
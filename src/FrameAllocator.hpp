@@ -0,0 +1,70 @@
+#ifndef FRAME_ALLOCATOR
+#define FRAME_ALLOCATOR
+
+#include <cstddef>
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+
+// Bytes each thread's arena starts with, allocated on first use
+#define FRAME_ARENA_INITIAL_SIZE (64 << 10)
+
+/**
+ * Defines the usage of a frame arena
+*/
+struct FrameArenaStats {
+  std::size_t capacity = 0;
+  std::size_t framePeak = 0;     // most bytes in use at once during the last frame, including overflow
+  std::size_t highWater = 0;     // most bytes in use at once during any frame
+  std::uint64_t overflows = 0;   // allocations which did not fit and went to the heap, over every frame
+  std::uint64_t frames = 0;
+};
+
+/**
+ * Defines a per-thread bump allocator for transient data, usable by std::pmr containers, which is emptied at the end of each frame
+ * Note: Freeing does nothing, the memory is reclaimed when the frame ends or an enclosing FrameArenaScope closes
+ * Note: Allocations which do not fit fall back to the heap and are counted as overflows; the arena then grows at the next reset to fit the frame or any reservation
+*/
+class FrameArena : public std::pmr::memory_resource {
+  private:
+    std::unique_ptr<char[]> buffer;
+    std::size_t capacity, offset = 0;
+    std::size_t overflowBytes = 0;  // heap bytes taken this frame, so the arena can grow to fit them
+    std::size_t peak = 0;           // most bytes in use at once this frame
+    std::size_t reserved = 0;       // capacity requested for the next frame
+    FrameArenaStats stats;
+
+    void* do_allocate(std::size_t, std::size_t) override;
+    void do_deallocate(void*, std::size_t, std::size_t) override;
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override { return this == &other; };
+
+  public:
+    FrameArena(std::size_t initialCapacity=FRAME_ARENA_INITIAL_SIZE) : capacity(initialCapacity) { stats.capacity = capacity; };
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    static FrameArena& local();
+    void reset();
+    void reserve(std::size_t bytes) { reserved = std::max(reserved, bytes); };
+    std::size_t getUsed() const { return offset; };
+    void rewind(std::size_t used) { if (used < offset) offset = used; };
+    const FrameArenaStats& getStats() const { return stats; };
+};
+
+/**
+ * Releases everything allocated from an arena within a scope when the scope ends, for work done many times a frame
+ * Note: Containers using the arena must be declared after the scope so they are destroyed before it rewinds
+*/
+class FrameArenaScope {
+  private:
+    FrameArena &arena;
+    std::size_t used;
+
+  public:
+    FrameArenaScope(FrameArena &frameArena=FrameArena::local()) : arena(frameArena), used(frameArena.getUsed()) { };
+    ~FrameArenaScope() { arena.rewind(used); };
+    FrameArena& get() { return arena; };
+};
+
+#endif
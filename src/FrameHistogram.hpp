@@ -0,0 +1,43 @@
+#ifndef FRAME_HISTOGRAM
+#define FRAME_HISTOGRAM
+
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+// Each power of two of microseconds is split into this many buckets, keeping every value within 1/64 of its bucket
+#define HISTOGRAM_SUB_BUCKETS 128
+// Frames longer than this many seconds are counted as this long
+#define HISTOGRAM_MAX_SECONDS 60
+
+/**
+ * Defines a log-linear histogram of frame times, in the style of HdrHistogram, with a fixed relative precision at any scale
+ * Note: Recording is constant time with no allocation, so every frame can be recorded
+*/
+class FrameHistogram {
+  private:
+    std::vector<std::uint64_t> counts;
+    std::uint64_t total = 0, overBudget = 0;
+    std::uint64_t maxMicroseconds = 0;
+    double sum = 0, budget;
+
+    static int indexOf(std::uint64_t);
+    static std::uint64_t highestOf(int);
+
+  public:
+    FrameHistogram(double budgetMs=1000.0 / 60);
+
+    void record(double);
+    void merge(const FrameHistogram&);
+    void reset();
+    void setBudget(double milliseconds) { budget = milliseconds; };
+
+    double percentile(double) const;
+    double getMax() const { return maxMicroseconds * 1e-3; };
+    double getMean() const { return total ? sum / total : 0; };
+    std::uint64_t getCount() const { return total; };
+    std::uint64_t getOverBudget() const { return overBudget; };
+    void log(const char*) const;
+};
+
+#endif
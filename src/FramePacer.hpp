@@ -0,0 +1,67 @@
+#ifndef FRAME_PACER
+#define FRAME_PACER
+
+#include <chrono>
+#include <vector>
+
+#include <SFML/Graphics.hpp>
+
+// The frame rate of the window's main loop
+#define TARGET_FPS 144
+#define FRAME_HISTORY 240
+// Sleeps are measured in slices of this length to calibrate how much the OS oversleeps
+#define SLEEP_SLICE_MS 1
+// Calibration weighs at most this many samples so the estimate follows changes in system load
+#define SLEEP_CALIBRATION_SAMPLES 200
+
+/**
+ * Defines how a frame pacer waits for the next frame
+*/
+enum class PacingMode {
+  Unlimited,  // never waits
+  Sleep,      // sleeps for the whole wait, using little CPU at the cost of the OS's sleep jitter
+  Hybrid      // sleeps while the calibrated sleep error allows it, then spins to the deadline
+};
+
+/**
+ * Defines the timing of the recent frames in milliseconds
+*/
+struct FrameStats {
+  int frames = 0;
+  double mean = 0, deviation = 0, min = 0, max = 0;
+  double work = 0;     // mean time spent before waiting
+  double spin = 0;     // mean time spent spinning
+  double present = 0;  // mean time spent presenting
+};
+
+/**
+ * Defines a frame limiter which ends every frame on a fixed schedule, and records how consistent the frames were
+*/
+class FramePacer {
+  private:
+    using Clock = std::chrono::steady_clock;
+
+    PacingMode mode;
+    Clock::duration period = Clock::duration::zero();
+    Clock::time_point deadline, frameStart;
+    double sleepMean = SLEEP_SLICE_MS * 1e-3, sleepM2 = 0;  // running mean and squared deviation of a slice's real length
+    int sleepSamples = 0;
+    std::vector<float> frameTimes, workTimes, spinTimes, presentTimes;
+    size_t next = 0, recorded = 0;
+
+    void calibrate(double);
+
+  public:
+    FramePacer(double fps=0, PacingMode pacing=PacingMode::Hybrid);
+
+    void setTargetFps(double);
+    void setMode(PacingMode pacing) { mode = pacing; };
+    PacingMode getMode() const { return mode; };
+
+    void wait();
+    void present(sf::RenderWindow&);
+    FrameStats getStats() const;
+    double getSleepError() const;
+};
+
+#endif
@@ -0,0 +1,63 @@
+#ifndef HEADLESS
+#define HEADLESS
+
+#include <SFML/Graphics.hpp>
+
+#include "EntityManager.hpp"
+#include "FrameHistogram.hpp"
+#include "MemoryTracker.hpp"
+#include "FrameAllocator.hpp"
+
+/**
+ * Defines a render target which accepts every draw and discards it without touching OpenGL
+ * Note: Drawing only happens once a target activates, so refusing to activate skips all GL work while the CPU side of rendering still runs
+*/
+class NullRenderTarget : public sf::RenderTarget {
+  private:
+    sf::Vector2u size;
+
+  public:
+    NullRenderTarget(unsigned int width, unsigned int height) : size(width, height) { initialize(); };
+    sf::Vector2u getSize() const override { return size; };
+    bool setActive(bool /*active*/=true) override { return false; };
+};
+
+/**
+ * Defines the scene and length of a headless run
+*/
+struct HeadlessSettings {
+  int entities = 10000;           // synthetic entities, used when no level is given
+  const char *level = nullptr;    // level image or compiled level loaded instead of synthetic entities
+  int randomLevel = 0;            // size of a random level image generated instead, or 0 for none
+  int ticks = 600, frames = 600;
+  bool offscreen = false;         // render into an sf::RenderTexture rather than the null target
+  unsigned int width = 1280, height = 960;
+  unsigned int seed = 1234;
+  AllocationGuardMode guard = AllocationGuardMode::Off;  // guards each frame after the warm-up against heap allocations
+  int warmup = 60;                // frames in which containers may still grow to their steady state size
+};
+
+/**
+ * Defines the results of a headless run, with each phase's times in milliseconds
+ * Note: The memory figures are only filled in when built with -DENABLE_MEMORY_TRACKING
+*/
+struct HeadlessReport {
+  bool loaded = true;        // whether the scene could be built; nothing is measured if not
+  bool offscreen = false;
+  int entities = 0, drawCalls = 0, commands = 0;
+  sf::FloatRect world;
+  double loadMs = 0, meanVisible = 0;
+  FrameHistogram update, cull, build, submit, present, frame;
+  std::uint64_t frameAllocations = 0, maxFrameAllocations = 0, frameBytes = 0;  // heap allocations within the measured frames
+  MemoryStats memory[(int)MemoryTag::Count + 1];                                 // each tag's use at the end of the run, then the total
+  int guardedFrames = 0, allocatingFrames = 0;
+  std::uint64_t guardedAllocations = 0;                                          // heap allocations on the main thread inside guarded frames
+  FrameArenaStats arena;                                                         // the main thread's frame arena at the end of the run
+};
+
+sf::FloatRect addSyntheticEntities(EntityManager&, int, unsigned int seed=1234);
+HeadlessSettings parseHeadlessArgs(int, char*[]);
+HeadlessReport measureHeadless(const HeadlessSettings&);
+int runHeadless(const HeadlessSettings&);
+
+#endif
@@ -0,0 +1,117 @@
+#ifndef HUD
+#define HUD
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <SFML/Graphics.hpp>
+
+#include "BitmapFont.hpp"
+
+/**
+ * Defines a piece of the HUD which is only re-rendered when its content changes
+*/
+class HudWidget {
+  protected:
+    sf::FloatRect bounds;  // the area covered when last rendered, cleared before the next render
+    bool dirty = true;
+
+  public:
+    virtual ~HudWidget() { };
+    virtual void render(sf::RenderTarget&, const BitmapFont&) = 0;
+    bool isDirty() const { return dirty; };
+    void markDirty() { dirty = true; };
+    void markClean() { dirty = false; };
+    const sf::FloatRect& getBounds() const { return bounds; };
+};
+
+/**
+ * Defines a single line of text
+*/
+class HudText : public HudWidget {
+  private:
+    TextBatch batch;
+    std::string text;
+    sf::Vector2f position;
+    sf::Color color;
+    size_t capacity;
+
+  public:
+    HudText(sf::Vector2f, size_t capacity=32, sf::Color color=sf::Color::White);
+    void render(sf::RenderTarget&, const BitmapFont&) override;
+    void setText(const char*);
+    void setText(const std::string &value) { setText(value.c_str()); };
+    void setNumber(const char*, long long);
+};
+
+/**
+ * Defines a horizontal bar filled in proportion to a value
+*/
+class HudBar : public HudWidget {
+  private:
+    sf::FloatRect area;
+    sf::Color fill, background;
+    float value = 0;
+    sf::RectangleShape backdrop, bar;  // kept between renders, so only the bar's width changes
+
+  public:
+    HudBar(sf::FloatRect, sf::Color fillColor=sf::Color::Green, sf::Color backgroundColor=sf::Color(0, 0, 0, 128));
+    void render(sf::RenderTarget&, const BitmapFont&) override;
+    void setValue(float);
+};
+
+/**
+ * Defines a line graph of the most recent samples, scrolling left as samples are pushed
+*/
+class HudGraph : public HudWidget {
+  private:
+    sf::FloatRect area;
+    sf::Color color;
+    std::vector<float> samples;
+    size_t next = 0, count = 0;
+    float minimum, maximum;
+    sf::RectangleShape backdrop;
+    sf::VertexArray line;  // rebuilt when a sample is pushed, so re-rendering only draws it
+
+  public:
+    HudGraph(sf::FloatRect, size_t, float, float, sf::Color color=sf::Color::Yellow);
+    void render(sf::RenderTarget&, const BitmapFont&) override;
+    void push(float);
+};
+
+/**
+ * Defines an overlay whose widgets are rendered into a cached texture, drawn each frame as a single quad
+ * Note: Widgets should not overlap, since a changed widget clears the area it previously covered
+*/
+class Hud : public sf::Drawable {
+  private:
+    sf::RenderTexture target;
+    sf::Sprite sprite;
+    const BitmapFont *font = nullptr;
+    std::vector<std::unique_ptr<HudWidget>> widgets;
+    sf::RectangleShape eraser;
+
+    void draw(sf::RenderTarget&, sf::RenderStates) const override;
+
+  public:
+    bool create(unsigned int, unsigned int);
+    void setFont(const BitmapFont &bitmapFont) { font = &bitmapFont; };
+    template <typename W, typename... Args> W& add(Args&&...);
+    int update();
+};
+
+/**
+ * Adds a widget to the HUD
+ * @tparam W The type of widget
+ * @tparam Args The individual arguments contained in the parameter pack
+ * @param args The arguments constructing the widget
+ * @return The widget, owned by the HUD
+*/
+template <typename W, typename... Args>
+W& Hud::add(Args&&... args) {
+  widgets.push_back(std::make_unique<W>(std::forward<Args>(args)...));
+  return static_cast<W&>(*widgets.back());
+};
+
+#endif
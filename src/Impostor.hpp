@@ -0,0 +1,61 @@
+#ifndef IMPOSTOR
+#define IMPOSTOR
+
+#include <string>
+#include <vector>
+
+#include <SFML/Graphics.hpp>
+
+#include "Mesh.hpp"
+#include "EntityManager.hpp"
+
+/**
+ * Defines the settings used when baking a mesh into impostor frames
+*/
+struct ImpostorSettings {
+  int frames = 16;          // number of yaw angles evenly spaced around a full turn
+  int frameSize = 128;      // width and height of each frame in pixels
+  int supersample = 2;      // samples per pixel along each axis, averaged for antialiasing
+  float pitch = 0.5f;       // downward tilt of the camera in radians, to suit a top-down view
+  int lod = 0;              // level of detail baked, where 0 is the full mesh; frames are small, but an offline bake keeps full detail
+  sf::Color color = sf::Color(200, 170, 140);
+};
+
+/**
+ * Defines a texture atlas holding a mesh rendered from evenly spaced yaw angles
+*/
+class ImpostorAtlas {
+  private:
+    sf::Image image;
+    sf::Texture texture;
+    std::vector<sf::IntRect> frames;
+
+  public:
+    void bake(const Mesh&, const ImpostorSettings &settings=ImpostorSettings());
+    bool saveToFile(const std::string&) const;
+    bool loadFromFile(const std::string&);
+    bool upload() { return texture.loadFromImage(image); };
+
+    int getFrameCount() const { return frames.size(); };
+    int frameFor(float) const;
+    const sf::IntRect& getFrame(int index) const { return frames[index]; };
+    const sf::Texture& getTexture() const { return texture; };
+    const sf::Image& getImage() const { return image; };
+};
+
+/**
+ * Defines a sprite entity which shows an impostor frame matching its facing
+*/
+class ImpostorEntity : public GraphicalEntity<sf::Sprite> {
+  private:
+    const ImpostorAtlas *atlas;
+    int frame = 0;
+
+  public:
+    ImpostorEntity(std::string, sf::Vector2f, const ImpostorAtlas&);
+    void setFacing(float);
+};
+
+int bakeImpostorFile(const char*, const char*, const ImpostorSettings&);
+
+#endif
@@ -0,0 +1,71 @@
+#ifndef LEVEL_GENERATOR
+#define LEVEL_GENERATOR
+
+#include <cstdint>
+#include <vector>
+
+#include <SFML/Graphics.hpp>
+
+#define LEVEL_VERSION 1
+// Largest width or height a compiled level may declare, so a corrupt header cannot request an enormous allocation
+#define LEVEL_MAX_SIZE 16384
+// Rows are generated in bands of this many, each with its own random stream, so a seed gives the same level on any number of threads
+#define LEVEL_BAND_ROWS 64
+// Smoothing passes of the cave automaton
+#define CAVE_ITERATIONS 4
+
+/**
+ * Defines the layouts a level can be generated with
+*/
+enum class LevelPattern {
+  Noise,  // walls scattered independently at the density
+  Rooms,  // a grid of rooms joined by doorways, some opened into halls, with pillars at the density
+  Maze,   // a perfect maze carved by the sidewinder algorithm, with corridors as wide as the cell size
+  Cave    // random fill at the density smoothed by a cellular automaton
+};
+
+/**
+ * Defines how a level is generated
+*/
+struct LevelSettings {
+  unsigned int width = 1024, height = 1024;
+  LevelPattern pattern = LevelPattern::Rooms;
+  float density = 0.1f;        // fraction of walls for noise and caves, or of pillars within rooms; unused by mazes
+  unsigned int cellSize = 16;  // room size, or maze corridor width, in pixels
+  unsigned int spawns = 0;     // spawn points marked on random floor pixels
+  unsigned int seed = 1234;
+  unsigned int threads = 0;    // 0 uses one per hardware thread
+};
+
+/**
+ * Defines a generated level, with one byte per pixel so bands can be written by separate threads
+*/
+struct Level {
+  unsigned int width = 0, height = 0;
+  std::vector<std::uint8_t> walls;  // 1 for a wall, row by row
+  sf::Vector2u player;
+  std::vector<sf::Vector2u> spawns;
+
+  bool isWall(unsigned int x, unsigned int y) const { return walls[(std::size_t)y * width + x]; };
+};
+
+/**
+ * Defines the fixed size header at the start of a compiled level, followed by the spawns, then the walls packed 8 pixels per byte
+*/
+struct LevelHeader {
+  char magic[4];
+  std::uint32_t version;
+  std::uint32_t width, height;
+  std::uint32_t playerX, playerY;
+  std::uint32_t spawnCount;
+};
+
+Level generateLevel(const LevelSettings&);
+sf::Image toImage(const Level&);
+bool writeCompiledLevel(const char*, const Level&);
+bool readCompiledLevel(const char*, Level&);
+bool loadLevel(const char*, sf::Image&);
+LevelSettings parseLevelArgs(int, char*[], const char**);
+int runLevelGenerator(int, char*[]);
+
+#endif
@@ -0,0 +1,188 @@
+#ifndef LOGGER
+#define LOGGER
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+
+// Records the ring holds, as a power of two; records written while it is full are dropped rather than blocking
+#define LOG_RING_SIZE 4096
+#define LOG_MAX_ARGS 8
+// Bytes of string arguments copied into each record; longer strings are truncated
+#define LOG_TEXT_BYTES 96
+#define LOG_LINE_BYTES 512
+// How long the writer thread sleeps when the ring is empty
+#define LOG_POLL_MS 2
+
+#define LOG_DEBUG(category, ...) Logger::get().write(LogLevel::Debug, category, __VA_ARGS__)
+#define LOG_INFO(category, ...) Logger::get().write(LogLevel::Info, category, __VA_ARGS__)
+#define LOG_WARN(category, ...) Logger::get().write(LogLevel::Warning, category, __VA_ARGS__)
+#define LOG_ERROR(category, ...) Logger::get().write(LogLevel::Error, category, __VA_ARGS__)
+
+enum class LogLevel : std::uint8_t {
+  Debug,
+  Info,
+  Warning,
+  Error
+};
+
+enum class LogCategory : std::uint8_t {
+  General,
+  Window,
+  Input,
+  Assets,
+  Performance,
+  Count
+};
+
+/**
+ * Defines the type an argument was captured as
+*/
+enum class LogType : std::uint8_t {
+  Signed,
+  Unsigned,
+  Double,
+  Text  // an offset into the record's text
+};
+
+/**
+ * Defines a captured argument
+*/
+union LogValue {
+  long long i;
+  unsigned long long u;
+  double d;
+};
+
+/**
+ * Defines a log message as written by a producer: the format string and its arguments, formatted later by the writer thread
+ * Note: The format must be a string literal, since only its pointer is kept; string arguments are copied
+*/
+struct alignas(64) LogRecord {
+  std::atomic<std::uint64_t> sequence{0};  // which lap of the ring the record is ready for
+  std::uint64_t time;                      // nanoseconds since the logger started
+  const char *format;
+  LogLevel level;
+  LogCategory category;
+  std::uint8_t argCount, textUsed;
+  LogType types[LOG_MAX_ARGS];
+  LogValue values[LOG_MAX_ARGS];
+  char text[LOG_TEXT_BYTES];
+};
+
+/**
+ * Defines an asynchronous logger: any thread writes fixed size records into a lock-free ring, and a background thread formats and writes them
+ * Note: Writing never allocates, locks or waits on I/O, so it is safe in the frame loop; the ring is a bounded multi-producer queue
+*/
+class Logger {
+  private:
+    LogRecord *ring;
+    alignas(64) std::atomic<std::uint64_t> writePosition{0};
+    alignas(64) std::atomic<std::uint64_t> readPosition{0};
+    std::atomic<std::uint64_t> dropped{0};
+    std::atomic<int> minimumLevel{(int)LogLevel::Info};
+    std::atomic<std::uint32_t> enabledCategories{~0u};
+    std::atomic<FILE*> output{stdout};
+    std::atomic<bool> stopping{false};
+    std::uint64_t start;
+    std::thread writer;
+
+    Logger();
+    ~Logger();
+    static std::uint64_t now();
+    LogRecord* claim(LogLevel, LogCategory);
+    void publish(LogRecord*);
+    void run();
+    bool drain();
+    void format(const LogRecord&, char*, size_t) const;
+
+    template <typename T> static void capture(LogRecord&, const T&);
+
+  public:
+    static Logger& get();
+    bool enabled(LogLevel level, LogCategory category) const {
+      return (int)level >= minimumLevel.load(std::memory_order_relaxed) && (enabledCategories.load(std::memory_order_relaxed) >> (int)category & 1);
+    };
+    template <std::size_t N, typename... Args> void write(LogLevel, LogCategory, const char (&)[N], const Args&...);
+    void setLevel(LogLevel level) { minimumLevel = (int)level; };
+    void setCategory(LogCategory category, bool enable) {
+      if (enable) enabledCategories |= 1u << (int)category;
+      else enabledCategories &= ~(1u << (int)category);
+    };
+    void setOutput(FILE *file) { output = file; };
+    void flush();
+    std::uint64_t getDropped() const { return dropped.load(std::memory_order_relaxed); };
+};
+
+/**
+ * Copies an argument into a record, keeping integers, floating point numbers and strings apart for the formatter
+ * @tparam T The argument's type
+ * @param record The record being written
+ * @param value The argument
+*/
+template <typename T>
+void Logger::capture(LogRecord &record, const T &value) {
+  if (record.argCount >= LOG_MAX_ARGS) return;
+  int index = record.argCount++;
+  if constexpr (std::is_floating_point_v<T>) {
+    record.types[index] = LogType::Double;
+    record.values[index].d = value;
+  } else if constexpr (std::is_enum_v<T>) {
+    record.types[index] = LogType::Signed;
+    record.values[index].i = (long long)value;
+  } else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>) {
+    record.types[index] = LogType::Signed;
+    record.values[index].i = value;
+  } else if constexpr (std::is_integral_v<T>) {
+    record.types[index] = LogType::Unsigned;
+    record.values[index].u = value;
+  } else if constexpr (std::is_convertible_v<const T&, std::string_view>) {
+    // Once the text is full, later strings share its final terminator and print as empty
+    record.types[index] = LogType::Text;
+    if (record.textUsed >= LOG_TEXT_BYTES) {
+      record.values[index].u = LOG_TEXT_BYTES - 1;
+      return;
+    }
+    std::string_view string(value);
+    std::size_t length = std::min<std::size_t>(string.size(), LOG_TEXT_BYTES - 1 - record.textUsed);
+    record.values[index].u = record.textUsed;
+    std::memcpy(record.text + record.textUsed, string.data(), length);
+    record.textUsed += length;
+    record.text[record.textUsed++] = '\0';
+  } else {
+    static_assert(std::is_pointer_v<T>, "Log arguments must be numbers, strings or pointers");
+    record.types[index] = LogType::Unsigned;
+    record.values[index].u = (std::uintptr_t)value;
+  }
+};
+
+/**
+ * Writes a message, formatted later with printf conventions by the writer thread
+ * Note: Costs a clock read, a compare and swap and a copy of the arguments; a message is dropped if the ring is full
+ * @tparam N The length of the format string
+ * @tparam Args The types of the arguments
+ * @param level The message's severity
+ * @param category The subsystem the message is from
+ * @param format The printf style format string literal
+ * @param args The arguments, at most LOG_MAX_ARGS
+*/
+template <std::size_t N, typename... Args>
+void Logger::write(LogLevel level, LogCategory category, const char (&format)[N], const Args&... args) {
+  static_assert(sizeof...(Args) <= LOG_MAX_ARGS, "Too many log arguments");
+  if (!enabled(level, category)) return;
+  LogRecord *record = claim(level, category);
+  if (!record) return;
+  record->format = format;
+  (capture(*record, args), ...);
+  publish(record);
+};
+
+bool parseLogLevel(const char*, LogLevel&);
+
+#endif
@@ -0,0 +1,84 @@
+#ifndef MEMORY_TRACKER
+#define MEMORY_TRACKER
+
+#include <cstdint>
+
+// Allocations are only tracked when built with -DENABLE_MEMORY_TRACKING, which replaces the global operator new and delete
+#ifdef ENABLE_MEMORY_TRACKING
+#define MEMORY_JOIN_(a, b) a##b
+#define MEMORY_JOIN(a, b) MEMORY_JOIN_(a, b)
+#define MEMORY_TAG(tag) MemoryScope MEMORY_JOIN(memoryScope, __LINE__)(tag)
+#else
+#define MEMORY_TAG(tag)
+#endif
+
+// Distinct call sites kept by the allocation guard, and the frames of stack captured for each
+#define ALLOCATION_SITE_LIMIT 32
+#define ALLOCATION_STACK_DEPTH 24
+
+/**
+ * Defines the subsystems allocations are charged to
+*/
+enum class MemoryTag : std::uint8_t {
+  Untagged,
+  Entities,
+  Mesh,
+  Assets,
+  Level,
+  Count
+};
+
+/**
+ * Defines the heap use charged to one tag
+ * Note: Memory is charged to the tag it was allocated under, even when freed under another
+*/
+struct MemoryStats {
+  std::int64_t liveBytes = 0, liveAllocations = 0;
+  std::int64_t peakBytes = 0;
+  std::uint64_t allocations = 0, allocatedBytes = 0;  // since the program started
+};
+
+/**
+ * Defines the allocations made between two frames, on every thread
+*/
+struct FrameAllocations {
+  std::uint64_t allocations = 0, bytes = 0;
+};
+
+/**
+ * Defines what the allocation guard does with heap allocations inside guarded frames
+*/
+enum class AllocationGuardMode {
+  Off,
+  Count,   // counts them
+  Report,  // counts them and keeps the stack of each distinct call site
+  Trap     // prints the stack of the first and aborts, stopping a debugger at the call site
+};
+
+/**
+ * Charges the allocations made by this thread within a scope to a tag, restoring the previous tag when it ends
+*/
+class MemoryScope {
+  private:
+    MemoryTag previous;
+
+  public:
+    MemoryScope(MemoryTag);
+    ~MemoryScope();
+};
+
+bool memoryTrackingEnabled();
+const char* memoryTagName(MemoryTag);
+MemoryStats getMemoryStats(MemoryTag);
+MemoryStats getTotalMemoryStats();
+FrameAllocations endMemoryFrame();
+void logMemoryStats();
+
+void setAllocationGuard(AllocationGuardMode);
+AllocationGuardMode getAllocationGuard();
+void beginGuardedFrame();
+std::uint64_t endGuardedFrame();
+std::uint64_t getGuardedAllocations();
+void printAllocationSites();
+
+#endif
@@ -0,0 +1,92 @@
+#ifndef PARTICLE_SYSTEM
+#define PARTICLE_SYSTEM
+
+#include <random>
+#include <vector>
+
+#include <SFML/Graphics.hpp>
+
+// Particle arrays are padded so the SIMD kernels never need a scalar tail
+#define PARTICLE_PADDING 8
+#define DEFAULT_PARTICLE_CAPACITY 4096
+#define VERTICES_PER_PARTICLE 6
+
+/**
+ * Defines the blend modes particles can be drawn with, each drawn from its own vertex array
+*/
+enum class ParticleBlend { Alpha, Add, Count };
+
+/**
+ * Defines how an emitter spawns particles
+*/
+struct EmitterSettings {
+  sf::Vector2f position;
+  float rate = 100;                       // particles per second, or 0 for bursts only
+  float angle = 0, spread = 6.2831853f;   // direction and width of the emission cone in radians
+  float minSpeed = 50, maxSpeed = 150;
+  float minLife = 0.5f, maxLife = 1.5f;   // lifetime in seconds
+  float size = 4;
+  sf::Color startColor = sf::Color::White, endColor = sf::Color::Transparent;
+  ParticleBlend blend = ParticleBlend::Alpha;
+};
+
+/**
+ * Defines a structure-of-arrays pool of live particles sharing a blend mode
+*/
+struct ParticlePool {
+  std::vector<float> x, y, vx, vy, life, invLife, size;
+  std::vector<sf::Color> startColor, endColor;
+  size_t count = 0;
+  sf::VertexArray vertices = sf::VertexArray(sf::Triangles);
+
+  void reserve(size_t);
+  size_t capacity() const { return life.empty() ? 0 : life.size() - PARTICLE_PADDING; };
+  size_t paddedCount() const { return (count + PARTICLE_PADDING - 1) / PARTICLE_PADDING * PARTICLE_PADDING; };
+  void integrate(float, sf::Vector2f, float);
+  void removeDead();
+  void buildVertices();
+};
+
+/**
+ * Defines a particle system of emitters feeding pools which are updated with SIMD and drawn with one call per blend mode
+*/
+class ParticleSystem : public sf::Drawable {
+  private:
+    /**
+     * Defines a continuous emitter
+    */
+    struct Emitter {
+      EmitterSettings settings;
+      float accumulator = 0;
+      bool active = true;
+    };
+
+    ParticlePool pools[(int)ParticleBlend::Count];
+    std::vector<Emitter> emitters;
+    std::minstd_rand rng;
+    sf::Vector2f gravity;
+    float drag = 0;
+
+    void spawn(const EmitterSettings&, int);
+    void draw(sf::RenderTarget&, sf::RenderStates) const override;
+
+  public:
+    ParticleSystem(size_t capacity=DEFAULT_PARTICLE_CAPACITY);
+
+    int addEmitter(const EmitterSettings&);
+    void removeEmitter(int index) { emitters[index].active = false; };
+    void setEmitterPosition(int index, sf::Vector2f position) { emitters[index].settings.position = position; };
+    void burst(const EmitterSettings &settings, int count) { spawn(settings, count); };
+    void setGravity(sf::Vector2f acceleration) { gravity = acceleration; };
+    void setDrag(float perSecond) { drag = perSecond; };
+
+    void update(float);
+    void simulate(float);
+    void buildVertices();
+    size_t getCount() const;
+    ParticlePool& getPool(ParticleBlend blend) { return pools[(int)blend]; };
+};
+
+const char* particleInstructionSet();
+
+#endif
@@ -0,0 +1,112 @@
+#ifndef PROFILER
+#define PROFILER
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Zones kept per thread, as a power of two; older zones are overwritten
+#define PROFILE_RING_SIZE (1 << 16)
+#define PROFILE_FRAME_HISTORY 1024
+#define PROFILE_EXPORT_FRAMES 300
+
+// Zones only exist when built with -DENABLE_PROFILER, otherwise they compile to nothing
+#ifdef ENABLE_PROFILER
+#define PROFILE_JOIN_(a, b) a##b
+#define PROFILE_JOIN(a, b) PROFILE_JOIN_(a, b)
+#define PROFILE_SCOPE(name) ProfileZone PROFILE_JOIN(profileZone, __LINE__)(name)
+#define PROFILE_THREAD(name) Profiler::get().setThreadName(name)
+#define PROFILE_FRAME() Profiler::get().endFrame()
+#else
+#define PROFILE_SCOPE(name)
+#define PROFILE_THREAD(name)
+#define PROFILE_FRAME()
+#endif
+
+/**
+ * Defines a finished zone, timed in nanoseconds
+ * Note: The name must be a string literal, since only its pointer is kept
+*/
+struct ProfileEvent {
+  const char *name;
+  std::uint64_t start, end;
+  std::uint32_t depth;
+};
+
+/**
+ * Defines the ring of zones recorded by one thread, which only that thread writes
+*/
+struct ProfileThread {
+  std::vector<ProfileEvent> events = std::vector<ProfileEvent>(PROFILE_RING_SIZE);
+  std::atomic<std::uint64_t> written{0};  // zones ever recorded, published after each is written
+  std::uint32_t depth = 0;
+  unsigned int id = 0;
+  std::string name;
+};
+
+/**
+ * Defines a zone of a frame's call tree with its time summed over every call
+*/
+struct ProfileNode {
+  const char *name;
+  int parent, depth;
+  double milliseconds = 0;
+  int calls = 0;
+};
+
+/**
+ * Defines the profiler which collects every thread's zones, aggregates each frame of the main thread into a call tree, and exports Chrome traces
+*/
+class Profiler {
+  private:
+    mutable std::mutex threadMutex;
+    std::vector<std::unique_ptr<ProfileThread>> threads;
+    std::vector<std::uint64_t> frameStarts = std::vector<std::uint64_t>(PROFILE_FRAME_HISTORY);
+    std::uint64_t frame = 0;
+    std::vector<ProfileNode> lastFrame;
+
+    Profiler();
+    ProfileThread* registerThread();
+    void collect(const ProfileThread&, std::uint64_t, std::uint64_t, std::vector<ProfileEvent>&) const;
+    void logNode(int) const;
+
+  public:
+    static Profiler& get();
+    static std::uint64_t now();
+    ProfileThread& thread() { thread_local ProfileThread *current = registerThread(); return *current; };
+    void setThreadName(const char*);
+
+    void endFrame();
+    std::uint64_t getFrame() const { return frame; };
+    const std::vector<ProfileNode>& getLastFrame() const { return lastFrame; };
+    void logLastFrame() const;
+    bool exportChromeTrace(const char*, std::uint64_t, std::uint64_t) const;
+};
+
+/**
+ * Defines a zone timed from its construction to the end of its scope
+*/
+class ProfileZone {
+  private:
+    ProfileThread &thread;
+    const char *name;
+    std::uint64_t start;
+
+  public:
+    ProfileZone(const char *zone) : thread(Profiler::get().thread()), name(zone) {
+      thread.depth++;
+      start = Profiler::now();
+    };
+    ~ProfileZone() {
+      std::uint64_t end = Profiler::now(), index = thread.written.load(std::memory_order_relaxed);
+      thread.events[index & (PROFILE_RING_SIZE - 1)] = ProfileEvent{name, start, end, --thread.depth};
+      thread.written.store(index + 1, std::memory_order_release);
+    };
+    ProfileZone(const ProfileZone&) = delete;
+    ProfileZone& operator=(const ProfileZone&) = delete;
+};
+
+#endif
@@ -0,0 +1,39 @@
+#ifndef REGRESSION
+#define REGRESSION
+
+#include <string>
+#include <vector>
+
+// A metric regresses once its median slows by this percentage...
+#define REGRESSION_THRESHOLD 10
+// ...and by more than this many standard deviations of noise, estimated from the median absolute deviation
+#define REGRESSION_NOISE_SIGMAS 3
+// Headless scenarios are repeated this many times to measure their noise
+#define REGRESSION_RUNS 5
+
+/**
+ * Defines a timed metric summarised by statistics robust to outliers
+*/
+struct RegressionMetric {
+  std::string name;
+  double median = 0, mad = 0;  // milliseconds
+  int samples = 0;
+};
+
+/**
+ * Defines how a regression check runs
+*/
+struct RegressionSettings {
+  const char *baseline = nullptr;  // the baseline JSON compared against, or written when updating
+  const char *filter = nullptr;    // a single benchmark section, or null for the default suite
+  double threshold = REGRESSION_THRESHOLD;
+  bool update = false;             // write the measured metrics as the new baseline instead of comparing
+};
+
+RegressionMetric summarise(const std::string&, std::vector<double>);
+bool readBaseline(const char*, std::vector<RegressionMetric>&);
+bool writeBaseline(const char*, const std::vector<RegressionMetric>&);
+int runRegression(const RegressionSettings&);
+RegressionSettings parseRegressionArgs(int, char*[]);
+
+#endif
@@ -0,0 +1,71 @@
+#ifndef RENDER_QUEUE
+#define RENDER_QUEUE
+
+#include <cstdint>
+#include <memory_resource>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <SFML/Graphics.hpp>
+
+// Sort key layout from the most significant bit; the sequence keeps equal states in a deterministic order
+#define KEY_LAYER_BITS 6
+#define KEY_DEPTH_BITS 16
+#define KEY_SHADER_BITS 6
+#define KEY_BLEND_BITS 2
+#define KEY_TEXTURE_BITS 12
+#define KEY_SEQUENCE_BITS 22
+
+// Sort keys paired with command indices, allocated from the frame arena while flushing
+using RenderOrder = std::pmr::vector<std::pair<std::uint64_t, std::uint32_t>>;
+
+/**
+ * Defines one submitted draw, either triangles which can be merged with neighbours or a drawable drawn alone
+*/
+struct RenderCommand {
+  std::uint64_t key;
+  const sf::Texture *texture = nullptr;
+  const sf::Shader *shader = nullptr;
+  sf::BlendMode blend;
+  size_t first = 0, count = 0;           // the range of triangle vertices within the queue
+  const sf::Drawable *drawable = nullptr;
+  sf::Transform transform;               // only used by drawables, triangles are transformed on submission
+};
+
+/**
+ * Defines a queue of draws which are sorted by key each frame, then merged into as few draw calls as possible
+ * Note: Within a layer and depth, draws are grouped by state before submission order, so overlapping
+ *       entities that must draw in a set order should be given different depths
+*/
+class RenderQueue {
+  private:
+    std::vector<RenderCommand> commands;
+    std::vector<sf::Vertex> vertices;
+    std::vector<sf::Vertex> batch;
+    std::unordered_map<const void*, std::uint32_t> stateIds;
+    int drawCalls = 0, commandCount = 0;
+
+    std::uint32_t idOf(const void*);
+    std::uint64_t makeKey(unsigned int, unsigned int, const sf::Texture*, const sf::BlendMode&, const sf::Shader*, unsigned int);
+    RenderCommand& push(unsigned int, unsigned int, unsigned int, const sf::RenderStates&);
+    void sort(RenderOrder&, RenderOrder&);
+
+  public:
+    void submit(const sf::Vertex*, size_t, const sf::RenderStates&, unsigned int, unsigned int, unsigned int);
+    void submit(const sf::Sprite&, unsigned int, unsigned int, unsigned int);
+    void submit(const sf::Shape&, unsigned int, unsigned int, unsigned int);
+    void submit(const sf::Drawable&, const sf::RenderStates&, unsigned int, unsigned int, unsigned int);
+    void flush(sf::RenderTarget&);
+    void clear();
+    void reserve(size_t, size_t);
+    bool empty() const { return commands.empty(); };
+    size_t pendingCommands() const { return commands.size(); };
+    size_t pendingVertices() const { return vertices.size(); };
+
+    // Statistics of the last flush
+    int getDrawCalls() const { return drawCalls; };
+    int getCommandCount() const { return commandCount; };
+};
+
+#endif
@@ -0,0 +1,46 @@
+#ifndef STATIC_LAYER
+#define STATIC_LAYER
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+
+#include <SFML/Graphics.hpp>
+
+#include "RenderQueue.hpp"
+
+#define STATIC_CHUNK_SIZE 512
+
+/**
+ * Defines a layer of unmoving geometry cached in render textures, tiled into square chunks
+ * Note: Only chunks overlapping a dirty region are re-rendered; every other frame just composites one quad per chunk
+*/
+class StaticLayer {
+  private:
+    /**
+     * Defines one tile of the cache
+    */
+    struct Chunk {
+      std::unique_ptr<sf::RenderTexture> texture;
+      sf::Sprite sprite;
+      bool dirty = true;
+    };
+
+    std::unordered_map<std::uint64_t, Chunk> chunks;
+    RenderQueue queue;
+    unsigned int chunkSize;
+
+    static std::uint64_t keyOf(int x, int y) { return ((std::uint64_t)(std::uint32_t)x << 32) | (std::uint32_t)y; };
+
+  public:
+    StaticLayer(unsigned int size=STATIC_CHUNK_SIZE) : chunkSize(size) { };
+
+    void markDirty(const sf::FloatRect&);
+    void markAllDirty();
+    int update(const std::function<void(const sf::FloatRect&, RenderQueue&)>&, const sf::FloatRect *visible=nullptr);
+    void submit(RenderQueue&, unsigned int, const sf::FloatRect *visible=nullptr) const;
+    size_t chunkCount() const { return chunks.size(); };
+};
+
+#endif
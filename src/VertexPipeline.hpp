@@ -0,0 +1,71 @@
+#ifndef VERTEX_PIPELINE
+#define VERTEX_PIPELINE
+
+#include <vector>
+#include <cstddef>
+
+struct Point;
+
+// Clip codes flag which clip planes a vertex lies outside of
+#define CLIP_LEFT   0x01
+#define CLIP_RIGHT  0x02
+#define CLIP_BOTTOM 0x04
+#define CLIP_TOP    0x08
+#define CLIP_NEAR   0x10
+#define CLIP_FAR    0x20
+
+// Vertex streams are padded so the SIMD kernels never need a scalar tail
+#define VERTEX_STREAM_PADDING 8
+
+/**
+ * Defines a row-major 4x4 matrix which transforms column vectors (clip = M * [x y z 1])
+*/
+struct Matrix4 {
+  float m[16];
+
+  static Matrix4 identity();
+  static Matrix4 translation(float, float, float);
+  static Matrix4 scale(float, float, float);
+  static Matrix4 rotationX(float);
+  static Matrix4 rotationY(float);
+  static Matrix4 perspective(float, float, float, float);
+  static Matrix4 orthographic(float, float, float, float, float, float);
+  Matrix4 operator*(const Matrix4&) const;
+};
+
+/**
+ * Defines the screen rectangle which normalised device coordinates are mapped onto
+*/
+struct Viewport {
+  float x = 0, y = 0, width = 1, height = 1;
+  Viewport() { };
+  Viewport(float w, float h) : width(w), height(h) { };
+  Viewport(float _x, float _y, float w, float h) : x(_x), y(_y), width(w), height(h) { };
+};
+
+/**
+ * Defines a structure-of-arrays copy of mesh vertices suited to batch transforms
+*/
+struct VertexStream {
+  std::vector<float> x, y, z;
+  size_t count = 0;
+
+  void assign(const std::vector<Point>&);
+  size_t paddedCount() const { return x.size(); }
+};
+
+/**
+ * Defines the output of the vertex pipeline in screen space
+ * Note: depth is mapped to [0, 1] and clip codes are only written when requested
+*/
+struct ScreenVertices {
+  std::vector<float> x, y, depth;
+  std::vector<unsigned char> clipCodes;
+  size_t count = 0;
+};
+
+void transformVertices(const VertexStream&, const Matrix4&, const Viewport&, ScreenVertices&, bool clipCodes=false);
+void transformVerticesNaive(const std::vector<Point>&, const Matrix4&, const Viewport&, ScreenVertices&, bool clipCodes=false);
+const char* vertexPipelineInstructionSet();
+
+#endif
@@ -0,0 +1,76 @@
+#ifndef VISIBILITY
+#define VISIBILITY
+
+#include <memory_resource>
+#include <vector>
+
+#include <SFML/Graphics.hpp>
+
+#define VISIBILITY_CELL_SIZE 128
+// Extra rays around the light's radius so unobstructed light stays round
+#define CIRCLE_SAMPLES 32
+
+/**
+ * Defines a point light
+*/
+struct Light {
+  sf::Vector2f position;
+  float radius = 300;
+  sf::Color color = sf::Color::White;
+};
+
+/**
+ * Defines a wall edge
+*/
+struct WallSegment {
+  sf::Vector2f a, b;
+};
+
+/**
+ * Defines the walls of a level merged into as few rectangles as possible, with their edges indexed in a uniform grid
+*/
+class WallMap {
+  private:
+    std::vector<sf::FloatRect> walls;
+    std::vector<WallSegment> segments;
+    // Each cell lists the segments crossing it as a run of cellSegments starting at cellStart
+    std::vector<unsigned int> cellStart, cellSegments;
+    sf::Vector2f origin;
+    int columns = 0, rows = 0;
+    float cellSize = VISIBILITY_CELL_SIZE;
+
+    void buildGrid();
+
+  public:
+    void build(const sf::Image&, float pixelSize=32, sf::Vector2f offset=sf::Vector2f(0, 0));
+    void build(const std::vector<sf::FloatRect>&);
+
+    void query(const sf::FloatRect&, std::pmr::vector<unsigned int>&) const;
+    void visibility(sf::Vector2f, float, std::vector<sf::Vector2f>&) const;
+    bool lineOfSight(sf::Vector2f, sf::Vector2f) const;
+
+    const std::vector<sf::FloatRect>& getWalls() const { return walls; };
+    size_t segmentCount() const { return segments.size(); };
+};
+
+void computeVisibility(const WallMap&, const std::vector<Light>&, std::vector<std::vector<sf::Vector2f>>&, unsigned int threads=0);
+
+/**
+ * Defines a light map which accumulates each light's visibility polygon and darkens the scene beneath it
+*/
+class LightMap : public sf::Drawable {
+  private:
+    sf::RenderTexture target;
+    sf::Sprite sprite;
+    std::vector<sf::VertexArray> masks;
+    sf::Color ambient = sf::Color(60, 60, 80);
+
+    void draw(sf::RenderTarget&, sf::RenderStates) const override;
+
+  public:
+    bool create(unsigned int, unsigned int);
+    void setAmbient(sf::Color color) { ambient = color; };
+    void update(const std::vector<Light>&, const std::vector<std::vector<sf::Vector2f>>&, const sf::View&);
+};
+
+#endif
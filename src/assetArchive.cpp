@@ -0,0 +1,465 @@
+#include "AssetArchive.hpp"
+#include "AssetCache.hpp"
+#include "MemoryTracker.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#define ARCHIVE_VERSION 1
+#define LZ4_HASH_BITS 16
+#define LZ4_MIN_MATCH 4
+#define LZ4_LAST_LITERALS 5
+#define LZ4_MATCH_LIMIT 12
+#define LZ4_MAX_OFFSET 65535
+
+// Entries only stay compressed when this saves at least a tenth of their size
+#define COMPRESSION_THRESHOLD 0.9
+
+static const char archiveMagic[4] = {'P', 'A', 'K', '1'};
+
+/**
+ * Maps a whole file into memory for reading
+ * @param filename The file being mapped
+ * @return Whether the file was mapped
+*/
+bool MappedFile::open(const std::string &filename) {
+  close();
+#ifdef _WIN32
+  HANDLE handle = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (handle == INVALID_HANDLE_VALUE) return false;
+  LARGE_INTEGER length;
+  GetFileSizeEx(handle, &length);
+  HANDLE view = length.QuadPart ? CreateFileMappingA(handle, nullptr, PAGE_READONLY, 0, 0, nullptr) : nullptr;
+  if (!view) {
+    CloseHandle(handle);
+    return false;
+  }
+  file = handle;
+  mapping = view;
+  size = length.QuadPart;
+  data = (const char*)MapViewOfFile(view, FILE_MAP_READ, 0, 0, 0);
+#else
+  int descriptor = ::open(filename.c_str(), O_RDONLY);
+  if (descriptor < 0) return false;
+  struct stat info;
+  if (fstat(descriptor, &info) != 0 || info.st_size == 0) {
+    ::close(descriptor);
+    return false;
+  }
+  size = info.st_size;
+  void *view = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+  ::close(descriptor);
+  data = view == MAP_FAILED ? nullptr : (const char*)view;
+#endif
+  if (!data) close();
+  return data != nullptr;
+}
+
+/**
+ * Unmaps the file
+*/
+void MappedFile::close() {
+#ifdef _WIN32
+  if (data) UnmapViewOfFile(data);
+  if (mapping) CloseHandle((HANDLE)mapping);
+  if (file) CloseHandle((HANDLE)file);
+#else
+  if (data) munmap((void*)data, size);
+#endif
+  data = nullptr;
+  file = mapping = nullptr;
+  size = 0;
+}
+
+/**
+ * Points the stream at stored bytes which are read in place
+ * @param bytes The entry data within the mapping
+ * @param length The number of bytes
+*/
+void ArchiveStream::open(const char *bytes, size_t length) {
+  decompressed.clear();
+  data = bytes;
+  size = length;
+  position = 0;
+}
+
+/**
+ * Decompresses an entry into memory owned by the stream
+ * @param bytes The compressed entry data within the mapping
+ * @param storedSize The number of compressed bytes
+ * @param length The number of bytes once decompressed
+ * @return Whether the entry decompressed cleanly
+*/
+bool ArchiveStream::openCompressed(const char *bytes, size_t storedSize, size_t length) {
+  MEMORY_TAG(MemoryTag::Assets);
+  decompressed.resize(length);
+  if (!decompressLZ4(bytes, storedSize, decompressed.data(), length)) {
+    open(nullptr, 0);
+    return false;
+  }
+  data = decompressed.data();
+  size = length;
+  position = 0;
+  return true;
+}
+
+sf::Int64 ArchiveStream::read(void *buffer, sf::Int64 length) {
+  sf::Int64 count = std::max<sf::Int64>(0, std::min(length, size - position));
+  std::memcpy(buffer, data + position, count);
+  position += count;
+  return count;
+}
+
+sf::Int64 ArchiveStream::seek(sf::Int64 target) {
+  if (target < 0 || target > size) return -1;
+  position = target;
+  return position;
+}
+
+/**
+ * Maps an archive and validates its table of contents
+ * Note: Every entry must lie within the file, read as many bytes as it stores and name a path ended within the names table
+ * @param filename The archive file
+ * @return Whether the archive was opened
+*/
+bool AssetArchive::open(const std::string &filename) {
+  MEMORY_TAG(MemoryTag::Assets);
+  entries = nullptr;
+  entryCount = 0;
+  if (!file.open(filename) || file.getSize() < sizeof(ArchiveHeader)) return false;
+
+  const ArchiveHeader *header = (const ArchiveHeader*)file.getData();
+  size_t tableEnd = sizeof(ArchiveHeader) + (size_t)header->entryCount * sizeof(ArchiveEntry) + header->namesSize;
+  if (std::memcmp(header->magic, archiveMagic, 4) != 0 || header->version != ARCHIVE_VERSION || tableEnd > file.getSize()) {
+    std::cout << "Invalid archive: *" << filename << "*" << std::endl;
+    file.close();
+    return false;
+  }
+
+  entries = (const ArchiveEntry*)(file.getData() + sizeof(ArchiveHeader));
+  names = (const char*)(entries + header->entryCount);
+  bool namesEnded = header->namesSize && names[header->namesSize - 1] == '\0';
+  for (std::uint32_t i = 0; i < header->entryCount; i++) {
+    const ArchiveEntry &entry = entries[i];
+    bool stored = (entry.flags & ARCHIVE_COMPRESSED) || entry.size == entry.storedSize;
+    if (entry.offset > file.getSize() || entry.storedSize > file.getSize() - entry.offset || !stored
+        || !namesEnded || entry.nameOffset >= header->namesSize) {
+      std::cout << "Invalid archive: *" << filename << "*" << std::endl;
+      file.close();
+      entries = nullptr;
+      return false;
+    }
+  }
+  entryCount = header->entryCount;
+  return true;
+}
+
+/**
+ * Finds the entry of a path by binary search on its hash
+ * @param path The asset path, such as res/Tile.png
+ * @return The entry, or null if the archive does not hold the path
+*/
+const ArchiveEntry* AssetArchive::find(const std::string &path) const {
+  if (!entries) return nullptr;
+  std::uint64_t hash = hashPath(path);
+  const ArchiveEntry *end = entries + entryCount;
+  const ArchiveEntry *entry = std::lower_bound(entries, end, hash, [](const ArchiveEntry &e, std::uint64_t h) { return e.hash < h; });
+
+  std::string normalised(path);
+  std::replace(normalised.begin(), normalised.end(), '\\', '/');
+  for (; entry != end && entry->hash == hash; entry++)
+    if (normalised == names + entry->nameOffset) return entry;
+  return nullptr;
+}
+
+/**
+ * Opens a stream over an entry
+ * @param path The asset path
+ * @param stream The stream being opened
+ * @return Whether the entry exists and could be read
+*/
+bool AssetArchive::openStream(const std::string &path, ArchiveStream &stream) const {
+  const ArchiveEntry *entry = find(path);
+  if (!entry) return false;
+  const char *bytes = file.getData() + entry->offset;
+  if (entry->flags & ARCHIVE_COMPRESSED) return stream.openCompressed(bytes, entry->storedSize, entry->size);
+  stream.open(bytes, entry->size);
+  return true;
+}
+
+/**
+ * Opens a shared stream over an entry, for assets such as fonts which read from their source for their whole life
+ * @param path The asset path
+ * @return The stream, or null if the entry could not be read
+*/
+std::shared_ptr<ArchiveStream> AssetArchive::openStream(const std::string &path) const {
+  auto stream = std::make_shared<ArchiveStream>();
+  return openStream(path, *stream) ? stream : nullptr;
+}
+
+/**
+ * Lists every path within the archive
+ * @return The paths in table of contents order
+*/
+std::vector<std::string> AssetArchive::list() const {
+  std::vector<std::string> paths;
+  for (std::uint32_t i = 0; i < entryCount; i++) paths.emplace_back(names + entries[i].nameOffset);
+  return paths;
+}
+
+/**
+ * Returns the decompressed size of an entry
+ * @param path The asset path
+ * @return The size in bytes, or 0 if the archive does not hold the path
+*/
+size_t AssetArchive::getSize(const std::string &path) const {
+  const ArchiveEntry *entry = find(path);
+  return entry ? entry->size : 0;
+}
+
+/**
+ * Loads a font from an entry
+ * Note: sf::Font keeps reading from its source, so the font owns the stream it was opened from
+ * @param path The asset path
+ * @return The font, or null if the entry could not be read
+*/
+std::shared_ptr<sf::Font> AssetArchive::loadFont(const std::string &path) const {
+  std::shared_ptr<ArchiveStream> stream = openStream(path);
+  if (!stream) return nullptr;
+  std::shared_ptr<sf::Font> font(new sf::Font(), [stream](sf::Font *font) { delete font; });
+  return font->loadFromMemory(stream->getData(), stream->getSize()) ? font : nullptr;
+}
+
+/**
+ * Parses a mesh directly from an entry without copying it, along with any levels of detail packed beside it
+ * @param path The asset path
+ * @param mesh The mesh being read
+ * @param generateLODs Whether levels of detail are generated when none are packed @def{false}
+ * @return Whether the entry exists and held vertices
+*/
+bool AssetArchive::loadMesh(const std::string &path, Mesh &mesh, bool generateLODs) const {
+  ArchiveStream stream;
+  if (!openStream(path, stream)) return false;
+  mesh.readFromMemory(stream.getData(), stream.getSize());
+  for (int level = 1; ; level++) {
+    ArchiveStream lodStream;
+    Mesh lod;
+    if (!openStream(lodFilename(path, level), lodStream)) break;
+    lod.readFromMemory(lodStream.getData(), lodStream.getSize());
+    if (!mesh.addLOD(lod)) break;
+  }
+  if (generateLODs) mesh.generateMissingLODs();
+  return !mesh.getVertices().empty();
+}
+
+/**
+ * Appends one LZ4 sequence of literals followed by a match
+*/
+static void writeSequence(std::vector<char> &out, const char *literals, size_t literalLength, size_t offset, size_t matchLength) {
+  size_t matchCode = matchLength ? matchLength - LZ4_MIN_MATCH : 0;
+  out.push_back((char)((std::min<size_t>(literalLength, 15) << 4) | std::min<size_t>(matchCode, 15)));
+  if (literalLength >= 15) {
+    size_t remaining = literalLength - 15;
+    for (; remaining >= 255; remaining -= 255) out.push_back((char)255);
+    out.push_back((char)remaining);
+  }
+  out.insert(out.end(), literals, literals + literalLength);
+  if (!matchLength) return;
+
+  out.push_back((char)(offset & 0xFF));
+  out.push_back((char)(offset >> 8));
+  if (matchCode >= 15) {
+    size_t remaining = matchCode - 15;
+    for (; remaining >= 255; remaining -= 255) out.push_back((char)255);
+    out.push_back((char)remaining);
+  }
+}
+
+static inline std::uint32_t read32(const char *p) {
+  std::uint32_t value;
+  std::memcpy(&value, p, 4);
+  return value;
+}
+
+/**
+ * Compresses a buffer into a single LZ4 block with a greedy hash table match finder
+ * @param src The bytes being compressed
+ * @param size The number of bytes
+ * @param out The compressed block
+ * @return The size of the compressed block
+*/
+size_t compressLZ4(const char *src, size_t size, std::vector<char> &out) {
+  out.clear();
+  out.reserve(size + size / 255 + 16);
+  std::vector<std::int64_t> table(1 << LZ4_HASH_BITS, -1);
+  size_t anchor = 0, i = 0;
+
+  // The format requires the last match to start 12 bytes and end 5 bytes before the block ends
+  if (size > LZ4_MATCH_LIMIT) {
+    size_t limit = size - LZ4_MATCH_LIMIT, matchEndLimit = size - LZ4_LAST_LITERALS;
+    while (i < limit) {
+      std::uint32_t sequence = read32(src + i);
+      std::uint32_t hash = (sequence * 2654435761u) >> (32 - LZ4_HASH_BITS);
+      std::int64_t candidate = table[hash];
+      table[hash] = i;
+      if (candidate < 0 || i - candidate > LZ4_MAX_OFFSET || read32(src + candidate) != sequence) {
+        i++;
+        continue;
+      }
+
+      size_t match = candidate, end = i + LZ4_MIN_MATCH;
+      while (end < matchEndLimit && src[end] == src[match + end - i]) end++;
+      while (i > anchor && match > 0 && src[i - 1] == src[match - 1]) { i--; match--; }
+      writeSequence(out, src + anchor, i - anchor, i - match, end - i);
+      i = anchor = end;
+    }
+  }
+  writeSequence(out, src + anchor, size - anchor, 0, 0);
+  return out.size();
+}
+
+/**
+ * Decompresses a single LZ4 block, checking every read and write against the buffers
+ * @param src The compressed block
+ * @param srcSize The size of the compressed block
+ * @param dst The output buffer
+ * @param dstSize The exact decompressed size
+ * @return Whether the block decompressed to exactly dstSize bytes
+*/
+bool decompressLZ4(const char *src, size_t srcSize, char *dst, size_t dstSize) {
+  const unsigned char *in = (const unsigned char*)src, *inEnd = in + srcSize;
+  char *out = dst, *outEnd = dst + dstSize;
+
+  while (in < inEnd) {
+    unsigned char token = *in++;
+    size_t literalLength = token >> 4;
+    if (literalLength == 15) {
+      unsigned char byte;
+      do {
+        if (in >= inEnd) return false;
+        byte = *in++;
+        literalLength += byte;
+      } while (byte == 255);
+    }
+    if ((size_t)(inEnd - in) < literalLength || (size_t)(outEnd - out) < literalLength) return false;
+    std::memcpy(out, in, literalLength);
+    in += literalLength;
+    out += literalLength;
+    if (in == inEnd) break;
+
+    if (inEnd - in < 2) return false;
+    size_t offset = in[0] | (in[1] << 8);
+    in += 2;
+    if (offset == 0 || offset > (size_t)(out - dst)) return false;
+    size_t matchLength = token & 15;
+    if (matchLength == 15) {
+      unsigned char byte;
+      do {
+        if (in >= inEnd) return false;
+        byte = *in++;
+        matchLength += byte;
+      } while (byte == 255);
+    }
+    matchLength += LZ4_MIN_MATCH;
+    if ((size_t)(outEnd - out) < matchLength) return false;
+
+    // Matches may overlap their own output, so copy byte by byte
+    const char *match = out - offset;
+    for (size_t i = 0; i < matchLength; i++) out[i] = match[i];
+    out += matchLength;
+  }
+  return out == outEnd;
+}
+
+/**
+ * Packs every file beneath a directory into one archive
+ * Note: Paths are stored relative to the directory's parent, so packing bin/res stores res/Tile.png
+ * @param directory The directory being packed
+ * @param output The archive file being written
+ * @param compress Whether entries are LZ4 compressed where that saves space
+ * @return The process exit code
+*/
+int packArchive(const char *directory, const char *output, bool compress) {
+  namespace fs = std::filesystem;
+  fs::path root = fs::path(directory).lexically_normal();
+  if (root.filename().empty()) root = root.parent_path();
+  if (!fs::is_directory(root)) {
+    std::cout << "Failed to read directory: *" << directory << "*" << std::endl;
+    return 1;
+  }
+
+  std::vector<ArchiveEntry> entries;
+  std::vector<std::vector<char>> contents;
+  std::string names;
+  for (auto &item : fs::recursive_directory_iterator(root)) {
+    if (!item.is_regular_file()) continue;
+    std::string name = (root.filename() / fs::relative(item.path(), root)).generic_string();
+    std::ifstream file(item.path(), std::ios::binary);
+    std::vector<char> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    ArchiveEntry entry = {hashPath(name), 0, (std::uint32_t)bytes.size(), (std::uint32_t)bytes.size(), 0, (std::uint32_t)names.size()};
+    std::vector<char> packed;
+    if (compress && !bytes.empty() && compressLZ4(bytes.data(), bytes.size(), packed) < bytes.size() * COMPRESSION_THRESHOLD) {
+      entry.storedSize = packed.size();
+      entry.flags |= ARCHIVE_COMPRESSED;
+      bytes.swap(packed);
+    }
+    names += name;
+    names += '\0';
+    entries.push_back(entry);
+    contents.push_back(std::move(bytes));
+  }
+
+  // Sort by hash for lookups, then lay out data in that order at aligned offsets
+  std::vector<size_t> order(entries.size());
+  for (size_t i = 0; i < order.size(); i++) order[i] = i;
+  std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return entries[a].hash < entries[b].hash; });
+  std::vector<ArchiveEntry> sorted;
+  std::uint64_t offset = sizeof(ArchiveHeader) + entries.size() * sizeof(ArchiveEntry) + names.size();
+  for (size_t index : order) {
+    offset = (offset + ARCHIVE_ALIGNMENT - 1) / ARCHIVE_ALIGNMENT * ARCHIVE_ALIGNMENT;
+    entries[index].offset = offset;
+    offset += entries[index].storedSize;
+    sorted.push_back(entries[index]);
+  }
+
+  std::ofstream file(output, std::ios::binary);
+  if (!file) {
+    std::cout << "Failed to write file: *" << output << "*" << std::endl;
+    return 1;
+  }
+  ArchiveHeader header;
+  std::memcpy(header.magic, archiveMagic, 4);
+  header.version = ARCHIVE_VERSION;
+  header.entryCount = sorted.size();
+  header.namesSize = names.size();
+  file.write((const char*)&header, sizeof(header));
+  file.write((const char*)sorted.data(), sorted.size() * sizeof(ArchiveEntry));
+  file.write(names.data(), names.size());
+
+  size_t stored = 0, original = 0;
+  for (size_t index : order) {
+    while ((std::uint64_t)file.tellp() < entries[index].offset) file.put('\0');
+    file.write(contents[index].data(), contents[index].size());
+    stored += entries[index].storedSize;
+    original += entries[index].size;
+  }
+  std::cout << "Packed " << sorted.size() << " files, " << original << " bytes into " << stored << " bytes" << std::endl;
+  return 0;
+}
@@ -0,0 +1,318 @@
+#include "AssetCache.hpp"
+#include "MemoryTracker.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include <SFML/Graphics.hpp>
+#include <SFML/Audio.hpp>
+
+static const char *typeNames[] = {"texture", "font", "sound buffer", "mesh"};
+
+/**
+ * Replaces Windows separators so both spellings of a path compare equal
+*/
+static std::string normalisePath(std::string path) {
+  for (char &c : path) if (c == '\\') c = '/';
+  return path;
+}
+
+/**
+ * Hashes a path with 64 bit FNV-1a, treating both separators alike
+ * @param path The path being hashed
+ * @return The hash of the path
+*/
+std::uint64_t hashPath(const std::string &path) {
+  std::uint64_t hash = 14695981039346656037ull;
+  for (char c : path) {
+    hash ^= (unsigned char)(c == '\\' ? '/' : c);
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+/**
+ * Estimates the bytes held by a file, for assets which keep their file contents in memory
+*/
+size_t AssetCache::fileSize(const std::string &path) const {
+  if (archive && archive->contains(path)) return archive->getSize(path);
+  std::ifstream file(path, std::ios::binary | std::ios::ate);
+  return file ? (size_t)file.tellg() : 0;
+}
+
+static size_t textureBytes(const sf::Texture &texture) { return texture.getSize().x * texture.getSize().y * 4; }
+static size_t soundBytes(const sf::SoundBuffer &buffer) { return buffer.getSampleCount() * sizeof(sf::Int16); }
+
+/**
+ * Finds the entry of a path, creating an empty one if it is not cached
+ * @param path The asset path
+ * @param type The kind of asset expected at the path
+ * @return The entry, or null if its hash collides with a different path or type
+*/
+AssetCache::Entry* AssetCache::find(const std::string &path, AssetType type) {
+  Entry &entry = entries[hashPath(path)];
+  if (entry.path.empty()) {
+    entry.path = normalisePath(path);
+    entry.type = type;
+  } else if (entry.type != type || entry.path != normalisePath(path)) {
+    return nullptr;
+  }
+  entry.lastUsed = ++clock;
+  return &entry;
+}
+
+/**
+ * Stores a loaded asset in its entry and evicts to keep within budget
+ * @param entry The entry of the asset
+ * @param asset The loaded asset
+ * @param bytes The estimated memory used by the asset
+*/
+void AssetCache::store(Entry &entry, std::shared_ptr<void> asset, size_t bytes) {
+  entry.asset = asset;
+  entry.bytes = bytes;
+  totalBytes += bytes;
+  if (totalBytes > budget) evict(totalBytes - budget);
+}
+
+/**
+ * Returns a cached asset, loading it on the calling thread if needed
+ * @tparam T The type of asset
+ * @param path The asset path
+ * @param type The kind of asset
+ * @param load The function loading the asset, returning null on failure
+ * @return The shared asset, or null if it failed to load
+*/
+template <typename T>
+std::shared_ptr<T> AssetCache::get(const std::string &path, AssetType type, std::function<std::shared_ptr<T>()> load) {
+  MEMORY_TAG(MemoryTag::Assets);
+  Entry *entry = find(path, type);
+  if (entry && entry->asset) return std::static_pointer_cast<T>(entry->asset);
+
+  std::shared_ptr<T> asset = load();
+  if (!asset) {
+    std::cout << "Failed to read file: *" << path << "*" << std::endl;
+    if (entry && !entry->loading) entries.erase(hashPath(path));
+    return nullptr;
+  }
+  if (!entry) return asset;
+
+  size_t bytes = 0;
+  if constexpr (std::is_same<T, sf::Texture>::value) bytes = textureBytes(*asset);
+  else if constexpr (std::is_same<T, sf::SoundBuffer>::value) bytes = soundBytes(*asset);
+  else if constexpr (std::is_same<T, Mesh>::value) bytes = asset->memoryUsage();
+  else bytes = fileSize(path);
+  store(*entry, asset, bytes);
+  return asset;
+}
+
+/**
+ * Returns a cached asset through a future, starting an asynchronous load if it is neither cached nor already loading
+ * @tparam T The type of asset
+ * @param path The asset path
+ * @param type The kind of asset
+ * @param start The function requesting the load from an AssetLoader with the given completion callback
+ * @param callback The function run on the main thread once the asset is available
+ * @return The future holding the asset
+*/
+template <typename T>
+AssetFuture<T> AssetCache::request(const std::string &path, AssetType type,
+    std::function<AssetFuture<T>(std::function<void(std::shared_ptr<T>)>)> start, std::function<void(std::shared_ptr<T>)> callback) {
+  MEMORY_TAG(MemoryTag::Assets);
+  Entry *entry = find(path, type);
+  if (entry && entry->asset) {
+    std::promise<std::shared_ptr<T>> ready;
+    std::shared_ptr<T> asset = std::static_pointer_cast<T>(entry->asset);
+    ready.set_value(asset);
+    if (callback) callback(asset);
+    return ready.get_future().share();
+  }
+
+  if (entry && entry->loading) {
+    AssetFuture<T> future = *std::static_pointer_cast<AssetFuture<T>>(entry->loading);
+    if (callback) entry->waiters.push_back([future, callback]() { callback(future.get()); });
+    return future;
+  }
+
+  if (!entry) return start(callback);
+  std::uint64_t key = hashPath(path);
+  AssetFuture<T> future = start([this, key, path](std::shared_ptr<T> asset) {
+    Entry &loaded = entries[key];
+    std::vector<std::function<void()>> waiters;
+    waiters.swap(loaded.waiters);
+    loaded.loading = nullptr;
+
+    // A synchronous get may have loaded the asset in the meantime, in which case it is kept
+    if (!asset && !loaded.asset) entries.erase(key);
+    else if (!loaded.asset) {
+      size_t bytes = 0;
+      if constexpr (std::is_same<T, sf::Texture>::value) bytes = textureBytes(*asset);
+      else if constexpr (std::is_same<T, Mesh>::value) bytes = asset->memoryUsage();
+      else bytes = fileSize(path);
+      store(loaded, asset, bytes);
+    }
+    for (auto &waiter : waiters) waiter();
+  });
+
+  entry = &entries[key];
+  entry->loading = std::make_shared<AssetFuture<T>>(future);
+  if (callback) entry->waiters.push_back([future, callback]() { callback(future.get()); });
+  return future;
+}
+
+/**
+ * Returns a shared texture, loading it on first use
+ * @param path The image file
+ * @return The texture, or null if it failed to load
+*/
+std::shared_ptr<sf::Texture> AssetCache::getTexture(const std::string &path) {
+  return get<sf::Texture>(path, AssetType::Texture, [&]() {
+    auto texture = std::make_shared<sf::Texture>();
+    bool loaded = archive && archive->contains(path) ? archive->load(path, *texture) : texture->loadFromFile(path);
+    return loaded ? texture : nullptr;
+  });
+}
+
+/**
+ * Returns a shared font, loading it on first use
+ * @param path The font file
+ * @return The font, or null if it failed to load
+*/
+std::shared_ptr<sf::Font> AssetCache::getFont(const std::string &path) {
+  return get<sf::Font>(path, AssetType::Font, [&]() {
+    if (archive && archive->contains(path)) return archive->loadFont(path);
+    auto font = std::make_shared<sf::Font>();
+    return font->loadFromFile(path) ? font : nullptr;
+  });
+}
+
+/**
+ * Returns a shared sound buffer, loading it on first use
+ * @param path The audio file
+ * @return The sound buffer, or null if it failed to load
+*/
+std::shared_ptr<sf::SoundBuffer> AssetCache::getSoundBuffer(const std::string &path) {
+  return get<sf::SoundBuffer>(path, AssetType::SoundBuffer, [&]() {
+    auto buffer = std::make_shared<sf::SoundBuffer>();
+    bool loaded = archive && archive->contains(path) ? archive->load(path, *buffer) : buffer->loadFromFile(path);
+    return loaded ? buffer : nullptr;
+  });
+}
+
+/**
+ * Returns a shared mesh, loading it on first use
+ * @param path The .obj file
+ * @return The mesh, or null if it failed to load
+*/
+std::shared_ptr<Mesh> AssetCache::getMesh(const std::string &path) {
+  return get<Mesh>(path, AssetType::Mesh, [&]() {
+    if (archive && archive->contains(path)) {
+      auto mesh = std::make_shared<Mesh>();
+      return archive->loadMesh(path, *mesh, generateLODs) ? mesh : nullptr;
+    }
+    auto mesh = std::make_shared<Mesh>(path.c_str());
+    if (mesh->getVertices().empty()) return std::shared_ptr<Mesh>();
+    mesh->loadLODs(path.c_str());
+    if (generateLODs) mesh->generateMissingLODs();
+    return mesh;
+  });
+}
+
+/**
+ * Returns a shared texture, loading it through the loader on first use
+ * @param path The image file
+ * @param loader The loader decoding on worker threads
+ * @param callback The function run on the main thread once available @def{nullptr}
+ * @return The future holding the texture
+*/
+AssetFuture<sf::Texture> AssetCache::loadTexture(const std::string &path, AssetLoader &loader, std::function<void(std::shared_ptr<sf::Texture>)> callback) {
+  return request<sf::Texture>(path, AssetType::Texture, [&](std::function<void(std::shared_ptr<sf::Texture>)> done) {
+    return loader.loadTexture(path, done);
+  }, callback);
+}
+
+/**
+ * Returns a shared font, loading it through the loader on first use
+ * @param path The font file
+ * @param loader The loader decoding on worker threads
+ * @param callback The function run on the main thread once available @def{nullptr}
+ * @return The future holding the font
+*/
+AssetFuture<sf::Font> AssetCache::loadFont(const std::string &path, AssetLoader &loader, std::function<void(std::shared_ptr<sf::Font>)> callback) {
+  return request<sf::Font>(path, AssetType::Font, [&](std::function<void(std::shared_ptr<sf::Font>)> done) {
+    return loader.loadFont(path, done);
+  }, callback);
+}
+
+/**
+ * Returns a shared mesh, loading it through the loader on first use
+ * @param path The .obj file
+ * @param loader The loader decoding on worker threads
+ * @param callback The function run on the main thread once available @def{nullptr}
+ * @return The future holding the mesh
+*/
+AssetFuture<Mesh> AssetCache::loadMesh(const std::string &path, AssetLoader &loader, std::function<void(std::shared_ptr<Mesh>)> callback) {
+  return request<Mesh>(path, AssetType::Mesh, [&](std::function<void(std::shared_ptr<Mesh>)> done) {
+    return loader.loadMesh(path, done);
+  }, callback);
+}
+
+/**
+ * Changes the memory budget, evicting immediately if it is now exceeded
+ * @param budgetBytes The new budget in bytes
+*/
+void AssetCache::setBudget(size_t budgetBytes) {
+  budget = budgetBytes;
+  if (totalBytes > budget) evict(totalBytes - budget);
+}
+
+/**
+ * Evicts unreferenced assets, least recently used first
+ * @param bytes The number of bytes to try to free
+ * @return The number of bytes freed
+*/
+size_t AssetCache::evict(size_t bytes) {
+  std::vector<std::pair<unsigned long long, std::uint64_t>> candidates;
+  for (auto &pair : entries)
+    if (pair.second.asset && pair.second.asset.use_count() == 1) candidates.emplace_back(pair.second.lastUsed, pair.first);
+  std::sort(candidates.begin(), candidates.end());
+
+  size_t freed = 0;
+  for (auto &candidate : candidates) {
+    if (freed >= bytes) break;
+    freed += entries[candidate.second].bytes;
+    entries.erase(candidate.second);
+  }
+  totalBytes -= freed;
+  return freed;
+}
+
+/**
+ * Returns the memory used by one kind of asset
+ * @param type The kind of asset
+ * @return The estimated bytes held by assets of that kind
+*/
+size_t AssetCache::getMemoryUsage(AssetType type) const {
+  size_t bytes = 0;
+  for (auto &pair : entries) if (pair.second.type == type) bytes += pair.second.bytes;
+  return bytes;
+}
+
+/**
+ * Prints the count and memory of each kind of asset against the budget
+*/
+void AssetCache::report() const {
+  for (int type = 0; type < (int)AssetType::Count; type++) {
+    int count = 0, referenced = 0;
+    for (auto &pair : entries) {
+      if ((int)pair.second.type != type || !pair.second.asset) continue;
+      count++;
+      referenced += pair.second.asset.use_count() > 1;
+    }
+    std::printf("%-14s %4i loaded %4i in use %10.2f KB\n", typeNames[type], count, referenced, getMemoryUsage((AssetType)type) / 1024.0);
+  }
+  std::printf("%-14s %31.2f KB of %.2f KB\n", "total", totalBytes / 1024.0, budget / 1024.0);
+}
@@ -0,0 +1,199 @@
+#include "AssetLoader.hpp"
+#include "Profiler.hpp"
+#include "MemoryTracker.hpp"
+
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include <SFML/Graphics.hpp>
+
+/**
+ * Starts the worker threads
+ * @param threads The number of workers, or 0 to use one per hardware thread @def{0}
+*/
+AssetLoader::AssetLoader(unsigned int threads) {
+  if (threads == 0) threads = std::max(2u, std::thread::hardware_concurrency());
+  for (unsigned int i = 0; i < threads; i++) workers.emplace_back(&AssetLoader::work, this);
+}
+
+/**
+ * Stops the workers once the jobs already queued have run
+*/
+AssetLoader::~AssetLoader() {
+  {
+    std::lock_guard<std::mutex> lock(jobMutex);
+    stopping = true;
+  }
+  jobReady.notify_all();
+  for (auto &worker : workers) worker.join();
+}
+
+/**
+ * Runs queued jobs until the loader is destroyed
+*/
+void AssetLoader::work() {
+  PROFILE_THREAD("Asset worker");
+  while (true) {
+    std::function<void()> job;
+    {
+      std::unique_lock<std::mutex> lock(jobMutex);
+      jobReady.wait(lock, [this]() { return stopping || !jobs.empty(); });
+      if (jobs.empty()) return;
+      job = std::move(jobs.front());
+      jobs.pop_front();
+    }
+    PROFILE_SCOPE("AssetLoader::job");
+    MEMORY_TAG(MemoryTag::Assets);
+    job();
+  }
+}
+
+/**
+ * Queues a job for the worker threads
+ * @param job The job being queued
+*/
+void AssetLoader::enqueue(std::function<void()> job) {
+  {
+    std::lock_guard<std::mutex> lock(jobMutex);
+    jobs.push_back(std::move(job));
+  }
+  jobReady.notify_one();
+}
+
+/**
+ * Queues work for the main thread, to be run by the next update
+ * @param completion The work being queued
+*/
+void AssetLoader::complete(std::function<void()> completion) {
+  std::lock_guard<std::mutex> lock(completionMutex);
+  completions.push_back(std::move(completion));
+}
+
+/**
+ * Decodes an asset on a worker and resolves its future on the main thread
+ * @tparam T The type of asset being loaded
+ * @param filename The file being loaded, used in failure messages
+ * @param decode The decoding run on a worker, returning null on failure
+ * @param upload The final step run on the main thread before the future resolves, or null if there is none
+ * @param callback The function run on the main thread once loaded, given null on failure
+ * @return The future holding the loaded asset
+*/
+template <typename T>
+AssetFuture<T> AssetLoader::load(const std::string &filename, std::function<std::shared_ptr<T>()> decode,
+                                 std::function<bool(T&)> upload, std::function<void(std::shared_ptr<T>)> callback) {
+  auto promise = std::make_shared<std::promise<std::shared_ptr<T>>>();
+  AssetFuture<T> future = promise->get_future().share();
+  pending++;
+
+  enqueue([this, filename, decode, upload, callback, promise]() {
+    std::shared_ptr<T> asset = decode();
+    if (!asset) std::cout << "Failed to read file: *" << filename << "*" << std::endl;
+    complete([this, asset, upload, callback, promise]() mutable {
+      if (asset && upload && !upload(*asset)) asset = nullptr;
+      promise->set_value(asset);
+      if (callback) callback(asset);
+      pending--;
+    });
+  });
+  return future;
+}
+
+/**
+ * Loads an image, decoded entirely on a worker
+ * @param filename The image file
+ * @param callback The function run on the main thread once loaded @def{nullptr}
+ * @return The future holding the image
+*/
+AssetFuture<sf::Image> AssetLoader::loadImage(const std::string &filename, std::function<void(std::shared_ptr<sf::Image>)> callback) {
+  const AssetArchive *source = archive;
+  return load<sf::Image>(filename, [filename, source]() {
+    auto image = std::make_shared<sf::Image>();
+    bool loaded = source && source->contains(filename) ? source->load(filename, *image) : image->loadFromFile(filename);
+    return loaded ? image : nullptr;
+  }, nullptr, callback);
+}
+
+/**
+ * Loads a texture, decoding the image on a worker and uploading it on the main thread
+ * @param filename The image file
+ * @param callback The function run on the main thread once uploaded @def{nullptr}
+ * @return The future holding the texture
+*/
+AssetFuture<sf::Texture> AssetLoader::loadTexture(const std::string &filename, std::function<void(std::shared_ptr<sf::Texture>)> callback) {
+  // The upload needs the GL context, so only the decoded image is produced off the main thread
+  auto image = std::make_shared<sf::Image>();
+  const AssetArchive *source = archive;
+  return load<sf::Texture>(filename, [filename, image, source]() {
+    bool loaded = source && source->contains(filename) ? source->load(filename, *image) : image->loadFromFile(filename);
+    return loaded ? std::make_shared<sf::Texture>() : nullptr;
+  }, [image](sf::Texture &texture) {
+    bool uploaded = texture.loadFromImage(*image);
+    *image = sf::Image();
+    return uploaded;
+  }, callback);
+}
+
+/**
+ * Loads a font on a worker
+ * @param filename The font file
+ * @param callback The function run on the main thread once loaded @def{nullptr}
+ * @return The future holding the font
+*/
+AssetFuture<sf::Font> AssetLoader::loadFont(const std::string &filename, std::function<void(std::shared_ptr<sf::Font>)> callback) {
+  const AssetArchive *source = archive;
+  return load<sf::Font>(filename, [filename, source]() {
+    if (source && source->contains(filename)) return source->loadFont(filename);
+    auto font = std::make_shared<sf::Font>();
+    return font->loadFromFile(filename) ? font : nullptr;
+  }, nullptr, callback);
+}
+
+/**
+ * Loads and parses a mesh on a worker
+ * @param filename The .obj file
+ * @param callback The function run on the main thread once loaded @def{nullptr}
+ * @return The future holding the mesh
+*/
+AssetFuture<Mesh> AssetLoader::loadMesh(const std::string &filename, std::function<void(std::shared_ptr<Mesh>)> callback) {
+  const AssetArchive *source = archive;
+  bool generate = generateLODs;
+  return load<Mesh>(filename, [filename, source, generate]() {
+    if (source && source->contains(filename)) {
+      auto mesh = std::make_shared<Mesh>();
+      return source->loadMesh(filename, *mesh, generate) ? mesh : nullptr;
+    }
+    auto mesh = std::make_shared<Mesh>(filename.c_str());
+    if (mesh->getVertices().empty()) return std::shared_ptr<Mesh>();
+    mesh->loadLODs(filename.c_str());
+    if (generate) mesh->generateMissingLODs();
+    return mesh;
+  }, nullptr, callback);
+}
+
+/**
+ * Finishes loaded assets on the main thread, resolving their futures and running their callbacks
+ * @return The number of assets finished
+*/
+int AssetLoader::update() {
+  PROFILE_SCOPE("AssetLoader::update");
+  MEMORY_TAG(MemoryTag::Assets);
+  {
+    std::lock_guard<std::mutex> lock(completionMutex);
+    if (completions.empty()) return 0;
+    ready.swap(completions);
+  }
+  for (auto &completion : ready) completion();
+  int finished = ready.size();
+  ready.clear();
+  return finished;
+}
+
+/**
+ * Blocks until every requested asset has finished loading
+*/
+void AssetLoader::finish() {
+  while (pending > 0) {
+    if (update() == 0) std::this_thread::yield();
+  }
+}
@@ -0,0 +1,723 @@
+#include "Benchmark.hpp"
+#include "Mesh.hpp"
+#include "BVH.hpp"
+#include "AssetArchive.hpp"
+#include "ParticleSystem.hpp"
+#include "Visibility.hpp"
+#include "FramePacer.hpp"
+#include "EntityManager.hpp"
+#include "Headless.hpp"
+#include "LevelGenerator.hpp"
+#include "Logger.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#define BENCHMARK_REPEATS 10
+// Runs of the largest inputs take seconds each, so they are repeated fewer times
+#define BENCHMARK_LARGE_REPEATS 3
+
+// Every printed result is kept under its section and group so runs can be written out and compared
+static std::vector<std::pair<std::string, BenchmarkResult>> recorded;
+static std::string section, group;
+
+/**
+ * Times a function over several repeats and keeps the fastest run
+ * @param name The benchmark name printed alongside the result
+ * @param items The number of work items processed per run
+ * @param repeats The number of timed runs
+ * @param run The function being timed
+ * @return The fastest timing
+*/
+BenchmarkResult measure(const std::string &name, long long items, int repeats, const std::function<void()> &run) {
+  return measure(name, items, repeats, nullptr, run);
+}
+
+/**
+ * Times a function over several repeats, preparing its input before each run without timing it
+ * @param name The benchmark name printed alongside the result
+ * @param items The number of work items processed per run
+ * @param repeats The number of timed runs
+ * @param setup The untimed preparation before each run, or null for none
+ * @param run The function being timed
+ * @return The fastest and median timings, and every run's time
+*/
+BenchmarkResult measure(const std::string &name, long long items, int repeats, const std::function<void()> &setup, const std::function<void()> &run) {
+  BenchmarkResult result;
+  result.name = name;
+  result.items = items;
+  if (setup) setup();
+  run(); // warm caches before timing
+
+  for (int i = 0; i < repeats; i++) {
+    if (setup) setup();
+    auto start = std::chrono::steady_clock::now();
+    run();
+    result.samples.push_back(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+  }
+  std::vector<double> sorted = result.samples;
+  std::sort(sorted.begin(), sorted.end());
+  if (!sorted.empty()) {
+    result.seconds = sorted.front();
+    size_t middle = sorted.size() / 2;
+    result.median = sorted.size() % 2 ? sorted[middle] : (sorted[middle - 1] + sorted[middle]) / 2;
+  }
+  return result;
+}
+
+/**
+ * Prints a benchmark result and its speedup relative to another result, and keeps it for the JSON output
+ * @param result The result being printed
+ * @param baseline The result to compare against @def{nullptr}
+*/
+void printResult(const BenchmarkResult &result, const BenchmarkResult *baseline) {
+  std::printf("%-40s %12.3f ms %12.3f ms median %14.2f M items/s", result.name.c_str(), result.seconds * 1e3, result.median * 1e3, result.itemsPerSecond() / 1e6);
+  if (baseline && result.seconds > 0) std::printf("  (%.2fx)", baseline->seconds / result.seconds);
+  std::printf("\n");
+  recorded.emplace_back(section + "/" + (group.empty() ? "" : group + "/") + result.name, result);
+}
+
+/**
+ * Returns every result printed so far, each named by its section, group and benchmark
+ * @return The named results
+*/
+const std::vector<std::pair<std::string, BenchmarkResult>>& getRecordedResults() {
+  return recorded;
+}
+
+/**
+ * Prints the title of a group of results, which also names them in the JSON output
+ * @param title The group's title
+*/
+static void beginGroup(const std::string &title) {
+  std::printf("%s\n", title.c_str());
+  group = title;
+}
+
+/**
+ * Checks whether a section of benchmarks is selected, starting it if so
+ * @param name The section's name
+ * @param filter The substring selecting which sections run
+ * @return Whether the section runs
+*/
+static bool selected(const char *name, const char *filter) {
+  if (!std::strstr(name, filter)) return false;
+  section = name;
+  group.clear();
+  return true;
+}
+
+/**
+ * Writes every recorded result as JSON, with each run's time so runs can be compared statistically
+ * @param filename The .json file written
+ * @return Whether the file was written
+*/
+static bool writeResults(const char *filename) {
+  std::ofstream file(filename);
+  if (!file) {
+    std::printf("Failed to write file: *%s*\n", filename);
+    return false;
+  }
+  file << "{\n  \"benchmarks\": [\n";
+  for (size_t i = 0; i < recorded.size(); i++) {
+    const BenchmarkResult &result = recorded[i].second;
+    std::string name;
+    for (char c : recorded[i].first) {
+      if (c == '"' || c == '\\') name += '\\';
+      name += c;
+    }
+    char line[256];
+    std::snprintf(line, sizeof(line), "    {\"name\": \"%s\", \"items\": %lld, \"min_ms\": %.6f, \"median_ms\": %.6f, \"samples_ms\": [",
+                  name.c_str(), result.items, result.seconds * 1e3, result.median * 1e3);
+    file << line;
+    for (size_t s = 0; s < result.samples.size(); s++) {
+      std::snprintf(line, sizeof(line), "%s%.6f", s ? ", " : "", result.samples[s] * 1e3);
+      file << line;
+    }
+    file << "]}" << (i + 1 < recorded.size() ? "," : "") << "\n";
+  }
+  file << "  ]\n}\n";
+  return true;
+}
+
+/**
+ * Compares the batch vertex pipeline against a naive per-vertex loop
+ * @param points The vertices being transformed
+ * @param label The name of the vertex set
+*/
+static void benchmarkVertexPipeline(const std::vector<Point> &points, const char *label) {
+  VertexStream stream;
+  stream.assign(points);
+  Matrix4 mvp = Matrix4::perspective(1.0f, 4.f / 3.f, 0.1f, 100.f) * Matrix4::translation(0, -3, -12) * Matrix4::rotationY(0.5f);
+  Viewport viewport(1280, 960);
+  ScreenVertices naive, batch;
+
+  BenchmarkResult base = measure(std::string("transform naive ") + label, points.size(), BENCHMARK_REPEATS,
+    [&]() { transformVerticesNaive(points, mvp, viewport, naive, true); });
+  BenchmarkResult simd = measure(std::string("transform ") + vertexPipelineInstructionSet() + " " + label, points.size(), BENCHMARK_REPEATS,
+    [&]() { transformVertices(stream, mvp, viewport, batch, true); });
+  printResult(base);
+  printResult(simd, &base);
+
+  // Both paths must agree before their timings mean anything
+  float maxError = 0;
+  int codeMismatches = 0;
+  for (size_t i = 0; i < points.size(); i++) {
+    if (naive.clipCodes[i] != batch.clipCodes[i]) codeMismatches++;
+    else if (naive.clipCodes[i] == 0) // clipped vertices may project arbitrarily far away
+      maxError = std::fmax(maxError, std::fabs(naive.x[i] - batch.x[i]) + std::fabs(naive.y[i] - batch.y[i]));
+  }
+  if (maxError > 1e-2f || codeMismatches)
+    std::printf("  WARNING: kernels disagree (max error %f px, %i clip code mismatches)\n", maxError, codeMismatches);
+}
+
+/**
+ * Generates a UV sphere for benchmarks needing larger meshes than the bundled model
+ * @param rings The number of rings from pole to pole
+ * @param segments The number of segments around each ring
+ * @return The generated mesh
+*/
+static Mesh makeSphere(int rings, int segments) {
+  std::vector<Point> points;
+  std::vector<unsigned int> indices;
+  for (int r = 0; r <= rings; r++) {
+    float phi = 3.14159265f * r / rings;
+    for (int s = 0; s < segments; s++) {
+      float theta = 2 * 3.14159265f * s / segments;
+      points.emplace_back(std::sin(phi) * std::cos(theta), std::cos(phi), std::sin(phi) * std::sin(theta));
+    }
+  }
+  for (int r = 0; r < rings; r++) {
+    for (int s = 0; s < segments; s++) {
+      unsigned int a = r * segments + s, b = r * segments + (s + 1) % segments;
+      unsigned int c = a + segments, d = b + segments;
+      indices.insert(indices.end(), {a, c, b, b, c, d});
+    }
+  }
+  return Mesh(points, indices);
+}
+
+/**
+ * Times level of detail generation and reports the resulting chain
+ * @param mesh The mesh being simplified
+ * @param label The name of the mesh
+*/
+static void benchmarkLODs(Mesh &mesh, const char *label) {
+  std::vector<float> ratios = {0.5f, 0.25f, 0.1f, 0.05f};
+  BenchmarkResult result = measure(std::string("generate LODs ") + label, mesh.getTriangles().size() / 3, 3,
+    [&]() { mesh.generateLODs(ratios); });
+  printResult(result);
+  mesh.reportLODs();
+}
+
+/**
+ * Times hierarchy construction and ray queries, checking hits against brute force on a sample
+ * @param mesh The mesh being indexed
+ * @param label The name of the mesh
+*/
+static void benchmarkBVH(const Mesh &mesh, const char *label) {
+  BVH bvh;
+  BenchmarkResult build = measure(std::string("BVH build ") + label, mesh.getTriangles().size() / 3, 3,
+    [&]() { bvh.build(mesh.getVertices(), mesh.getTriangles()); });
+  printResult(build);
+  std::printf("  %zu nodes, depth %i\n", bvh.nodeCount(), bvh.getDepth());
+
+  // Rays start on a sphere around the mesh and aim at points within its bounds, in coherent groups of four
+  const int rayCount = 1 << 18;
+  const Point &center = mesh.getBoundsCenter();
+  float radius = mesh.getBoundsRadius();
+  std::mt19937 rng(42);
+  std::uniform_real_distribution<float> unit(-1.f, 1.f), jitter(-0.02f, 0.02f);
+  std::vector<Ray> rays;
+  rays.reserve(rayCount);
+  for (int i = 0; i < rayCount; i += RAY_PACKET_SIZE) {
+    Point origin(center.x + unit(rng) * 3 * radius, center.y + unit(rng) * 3 * radius, center.z + unit(rng) * 3 * radius);
+    Point target(center.x + unit(rng) * radius / 2, center.y + unit(rng) * radius / 2, center.z + unit(rng) * radius / 2);
+    for (int lane = 0; lane < RAY_PACKET_SIZE; lane++) {
+      Point offset(target.x + jitter(rng) * radius, target.y + jitter(rng) * radius, target.z + jitter(rng) * radius);
+      rays.push_back(Ray(origin, Point(offset.x - origin.x, offset.y - origin.y, offset.z - origin.z)));
+    }
+  }
+
+  std::vector<RayHit> hits(rayCount), packetHits(rayCount);
+  int anyHits = 0;
+  printResult(measure(std::string("BVH closest hit ") + label, rayCount, 3, [&]() {
+    for (int i = 0; i < rayCount; i++) { hits[i] = RayHit(); bvh.closestHit(rays[i], hits[i]); }
+  }));
+  printResult(measure(std::string("BVH any hit ") + label, rayCount, 3, [&]() {
+    anyHits = 0;
+    for (int i = 0; i < rayCount; i++) anyHits += bvh.anyHit(rays[i]);
+  }));
+  printResult(measure(std::string("BVH packet closest hit ") + label, rayCount, 3, [&]() {
+    RayPacket packet;
+    for (int i = 0; i < rayCount; i += RAY_PACKET_SIZE) {
+      for (int lane = 0; lane < RAY_PACKET_SIZE; lane++) packet.set(lane, rays[i + lane]);
+      bvh.closestHit(packet, &packetHits[i]);
+    }
+  }));
+
+  // Brute force every triangle for a sample of rays
+  const std::vector<Point> &points = mesh.getVertices();
+  const std::vector<unsigned int> &triangles = mesh.getTriangles();
+  int mismatches = 0, closestHits = 0;
+  for (int i = 0; i < rayCount; i++) closestHits += hits[i].hit();
+  for (int i = 0; i < rayCount; i += rayCount / 16) {
+    BVH single;
+    float nearest = 1e30f;
+    for (size_t t = 0; t < triangles.size(); t += 3) {
+      single.build(points, std::vector<unsigned int>{triangles[t], triangles[t + 1], triangles[t + 2]});
+      RayHit hit;
+      if (single.closestHit(rays[i], hit)) nearest = std::min(nearest, hit.t);
+    }
+    if (std::fabs(nearest - hits[i].t) > 1e-3f * nearest || std::fabs(packetHits[i].t - hits[i].t) > 1e-3f * nearest) mismatches++;
+  }
+  std::printf("  %i / %i rays hit (%i any hit)%s\n", closestHits, rayCount, anyHits,
+    mismatches ? ", WARNING: disagrees with brute force" : "");
+}
+
+/**
+ * Compares opening and reading many small loose files against reading the same files from a packed archive
+ * @param fileCount The number of files generated
+ * @param fileSize The size of each file in bytes
+*/
+static void benchmarkArchive(int fileCount, int fileSize) {
+  namespace fs = std::filesystem;
+  fs::path root = fs::temp_directory_path() / "archive_benchmark";
+  fs::path directory = root / "res";
+  fs::create_directories(directory);
+
+  // Text-like contents compress the way .obj files do
+  std::mt19937 rng(1234);
+  std::vector<std::string> paths;
+  for (int i = 0; i < fileCount; i++) {
+    std::string name = "asset" + std::to_string(i) + ".txt";
+    std::ofstream file(directory / name, std::ios::binary);
+    for (int written = 0; written < fileSize; written += 12) file << "v " << rng() % 1000 << " 0." << rng() % 100 << "\n";
+    paths.push_back("res/" + name);
+  }
+  std::string archiveFile = (root / "res.pak").string();
+  std::string plainFile = (root / "plain.pak").string();
+  packArchive(directory.string().c_str(), archiveFile.c_str(), true);
+  packArchive(directory.string().c_str(), plainFile.c_str(), false);
+
+  std::vector<char> buffer;
+  long long bytes = 0;
+  BenchmarkResult loose = measure("loose files", fileCount, BENCHMARK_REPEATS, [&]() {
+    bytes = 0;
+    for (auto &path : paths) {
+      std::ifstream file(root / path, std::ios::binary | std::ios::ate);
+      buffer.resize(file.tellg());
+      file.seekg(0);
+      file.read(buffer.data(), buffer.size());
+      bytes += buffer.size();
+    }
+  });
+
+  AssetArchive plain, compressed;
+  plain.open(plainFile);
+  compressed.open(archiveFile);
+  auto readArchive = [&](const AssetArchive &archive) {
+    ArchiveStream stream;
+    bytes = 0;
+    for (auto &path : paths) {
+      if (!archive.openStream(path, stream)) continue;
+      buffer.resize(stream.getSize());
+      bytes += stream.read(buffer.data(), buffer.size());
+    }
+  };
+  BenchmarkResult packed = measure("archive", fileCount, BENCHMARK_REPEATS, [&]() { readArchive(plain); });
+  BenchmarkResult lz4 = measure("archive lz4", fileCount, BENCHMARK_REPEATS, [&]() { readArchive(compressed); });
+
+  beginGroup("Asset archive (" + std::to_string(fileCount) + " files of " + std::to_string(fileSize) + " bytes)");
+  printResult(loose);
+  printResult(packed, &loose);
+  printResult(lz4, &loose);
+  std::printf("  %lli bytes read per run, archives of %llu and %llu bytes\n", bytes,
+    (unsigned long long)fs::file_size(plainFile), (unsigned long long)fs::file_size(archiveFile));
+
+  std::error_code ignored;
+  fs::remove_all(root, ignored);
+}
+
+/**
+ * Compares the structure-of-arrays particle kernel against a loop over particle structs erasing dead particles
+ * @param count The number of live particles
+*/
+static void benchmarkParticles(int count) {
+  const float dt = 1 / 60.f;
+  EmitterSettings settings;
+  settings.minLife = settings.maxLife = 1e6f; // nothing expires so every run updates the same count
+  ParticleSystem system(count);
+  system.setGravity(sf::Vector2f(0, 98));
+  system.setDrag(0.1f);
+  system.burst(settings, count);
+
+  struct Particle {
+    sf::Vector2f position, velocity;
+    float life, maxLife, size;
+    sf::Color startColor, endColor;
+  };
+  std::vector<Particle> particles(count, Particle{sf::Vector2f(0, 0), sf::Vector2f(50, -20), 1e6f, 1e6f, 4, sf::Color::White, sf::Color::Transparent});
+  sf::Vector2f gravity(0, 98);
+  float damping = 1 - 0.1f * dt;
+
+  BenchmarkResult naive = measure("naive struct update", count, BENCHMARK_REPEATS, [&]() {
+    for (auto &particle : particles) {
+      particle.position += particle.velocity * dt;
+      particle.velocity = particle.velocity * damping + gravity * dt;
+      particle.life -= dt;
+    }
+    particles.erase(std::remove_if(particles.begin(), particles.end(), [](const Particle &p) { return p.life <= 0; }), particles.end());
+  });
+  BenchmarkResult simd = measure(std::string("SoA update (") + particleInstructionSet() + ")", count, BENCHMARK_REPEATS, [&]() {
+    system.simulate(dt);
+  });
+  BenchmarkResult vertices = measure("vertex build", count, BENCHMARK_REPEATS, [&]() { system.buildVertices(); });
+
+  beginGroup("Particles (" + std::to_string(count) + " live)");
+  printResult(naive);
+  printResult(simd, &naive);
+  printResult(vertices);
+  std::printf("  %zu particles remain\n", system.getCount());
+}
+
+/**
+ * Times visibility polygons for increasing numbers of lights in a random level, on one thread and on all of them
+ * @param levelSize The width and height of the level image in pixels
+*/
+static void benchmarkVisibility(int levelSize) {
+  std::mt19937 rng(1234);
+  sf::Image level;
+  level.create(levelSize, levelSize, sf::Color::White);
+  for (int y = 0; y < levelSize; y++)
+    for (int x = 0; x < levelSize; x++)
+      if (rng() % 100 < 15) level.setPixel(x, y, sf::Color::Black);
+  WallMap walls;
+  walls.build(level);
+
+  beginGroup("Visibility (" + std::to_string(levelSize) + "x" + std::to_string(levelSize) + " level)");
+  std::printf("  %zu merged walls, %zu segments\n", walls.getWalls().size(), walls.segmentCount());
+  std::uniform_real_distribution<float> coordinate(0, levelSize * 32.f);
+  std::vector<std::vector<sf::Vector2f>> polygons;
+  for (int count : {16, 64, 256}) {
+    std::vector<Light> lights(count);
+    for (auto &light : lights) light.position = sf::Vector2f(coordinate(rng), coordinate(rng));
+    BenchmarkResult single = measure(std::to_string(count) + " lights, 1 thread", count, BENCHMARK_REPEATS, [&]() {
+      computeVisibility(walls, lights, polygons, 1);
+    });
+    BenchmarkResult parallel = measure(std::to_string(count) + " lights, all threads", count, BENCHMARK_REPEATS, [&]() {
+      computeVisibility(walls, lights, polygons);
+    });
+    printResult(single);
+    printResult(parallel, &single);
+  }
+}
+
+/**
+ * Paces idle frames at several rates in each waiting mode, comparing frame time consistency against time spent spinning
+ * @param frames The number of frames paced at each rate
+*/
+static void benchmarkPacing(int frames) {
+  std::printf("Frame pacing (%i frames each)\n", frames);
+  for (PacingMode mode : {PacingMode::Sleep, PacingMode::Hybrid}) {
+    for (double fps : {60.0, 144.0, 240.0}) {
+      FramePacer pacer(fps, mode);
+      for (int i = 0; i < frames; i++) pacer.wait();
+      FrameStats stats = pacer.getStats();
+      std::printf("%-6s %5.0f fps: mean %8.3f ms  deviation %7.3f ms  min %8.3f ms  max %8.3f ms  spin %6.3f ms\n",
+                  mode == PacingMode::Sleep ? "sleep" : "hybrid", fps, stats.mean, stats.deviation, stats.min, stats.max, stats.spin);
+    }
+  }
+}
+
+/**
+ * Times writing log messages, then checks that strings longer than a record's text are truncated without touching the next record
+ * @return Whether every message was written intact
+*/
+static bool benchmarkLogging() {
+  namespace fs = std::filesystem;
+  fs::path path = fs::temp_directory_path() / "logging_benchmark.txt";
+  FILE *file = std::fopen(path.string().c_str(), "w+");
+  if (!file) {
+    std::printf("Failed to open file: *%s*\n", path.string().c_str());
+    return false;
+  }
+  Logger &logger = Logger::get();
+  logger.setOutput(file);
+
+  // Each run fits in the ring, and is written out before the next so none are dropped
+  const int messages = LOG_RING_SIZE / 2;
+  beginGroup("Logging (" + std::to_string(messages) + " messages)");
+  printResult(measure("numbers", messages, BENCHMARK_REPEATS, [&]() { logger.flush(); }, [&]() {
+    for (int i = 0; i < messages; i++) LOG_INFO(LogCategory::Performance, "Frame %i: %.3f ms", i, 16.6);
+  }));
+  std::string name = "res/Person_model.obj";
+  printResult(measure("strings", messages, BENCHMARK_REPEATS, [&]() { logger.flush(); }, [&]() {
+    for (int i = 0; i < messages; i++) LOG_INFO(LogCategory::Assets, "Loaded %s in %i ms", name, i);
+  }));
+  logger.setLevel(LogLevel::Warning);
+  printResult(measure("filtered", messages, BENCHMARK_REPEATS, [&]() {
+    for (int i = 0; i < messages; i++) LOG_INFO(LogCategory::Performance, "Frame %i: %.3f ms", i, 16.6);
+  }));
+  logger.setLevel(LogLevel::Info);
+
+  // Strings past the text's end are cut short, then printed empty once it is full
+  std::string first(200, 'a'), second(100, 'b'), third(50, 'c');
+  logger.flush();
+  std::fflush(file);
+  long start = std::ftell(file);
+  LOG_INFO(LogCategory::General, "[%s|%s|%s]", first, second, third);
+  LOG_INFO(LogCategory::General, "after %i", 1);
+  logger.flush();
+  logger.setOutput(stdout);
+  std::fseek(file, start, SEEK_SET);
+  char line[LOG_LINE_BYTES] = "", expected[LOG_LINE_BYTES];
+  std::snprintf(expected, sizeof(expected), "[%s||]\n", std::string(LOG_TEXT_BYTES - 1, 'a').c_str());
+  bool truncated = std::fgets(line, sizeof(line), file) && std::strstr(line, expected);
+  bool after = truncated && std::fgets(line, sizeof(line), file) && std::strstr(line, "after 1\n");
+  std::fclose(file);
+  std::error_code ignored;
+  fs::remove(path, ignored);
+  if (!truncated || !after) std::printf("Failed to truncate long log strings: *%s*\n", line);
+  return truncated && after;
+}
+
+/**
+ * Times generating levels of each pattern, up to 16384x16384
+*/
+static void benchmarkLevelGeneration() {
+  const char *names[] = {"noise", "rooms", "maze", "cave"};
+  beginGroup("Level generation");
+  for (unsigned int size : {1024u, 4096u, 16384u}) {
+    for (LevelPattern pattern : {LevelPattern::Noise, LevelPattern::Rooms, LevelPattern::Maze, LevelPattern::Cave}) {
+      LevelSettings settings;
+      settings.width = settings.height = size;
+      settings.pattern = pattern;
+      settings.density = pattern == LevelPattern::Cave ? 0.45f : 0.1f;
+      settings.spawns = 1000;
+      Level level;
+      BenchmarkResult result = measure(std::string(names[(int)pattern]) + " " + std::to_string(size) + "x" + std::to_string(size), (long long)size * size,
+        size >= 4096 ? BENCHMARK_LARGE_REPEATS : BENCHMARK_REPEATS, [&]() { level = generateLevel(settings); });
+      printResult(result);
+    }
+  }
+}
+
+/**
+ * Times building entities from level images and compiled levels, from the bundled level up to 8192x8192, decoding included
+ * Note: Generated levels are walled in and sparsely filled with 1 wall per 400 pixels, so memory stays bounded at the largest size
+*/
+static void benchmarkLevels() {
+  namespace fs = std::filesystem;
+  fs::path root = fs::temp_directory_path() / "level_benchmark";
+  fs::create_directories(root);
+  std::vector<std::string> files = {"res/simpleScene.png"};
+  for (unsigned int size : {256u, 1024u, 4096u, 8192u}) {
+    LevelSettings settings;
+    settings.width = settings.height = size;
+    settings.pattern = LevelPattern::Noise;
+    settings.density = 1 / 400.f;
+    Level level = generateLevel(settings);
+    std::string name = (root / ("level" + std::to_string(size))).string();
+    files.push_back(name + ".png");
+    toImage(level).saveToFile(files.back());
+    files.push_back(name + ".lvl");
+    writeCompiledLevel(files.back().c_str(), level);
+  }
+
+  beginGroup("Level loading");
+  for (auto &file : files) {
+    sf::Image level;
+    if (!loadLevel(file.c_str(), level)) continue;
+    sf::Vector2u size = level.getSize();
+    std::unique_ptr<EntityManager> manager;
+    BenchmarkResult result = measure("addFromFile " + std::to_string(size.x) + "x" + std::to_string(size.y) + " " + fs::path(file).extension().string(), (long long)size.x * size.y,
+      size.x >= 4096 ? BENCHMARK_LARGE_REPEATS : BENCHMARK_REPEATS,
+      [&]() { manager = std::make_unique<EntityManager>(); }, [&]() { manager->addFromFile(file.c_str()); });
+    printResult(result);
+    std::printf("  %i entities\n", manager->size());
+  }
+
+  std::error_code ignored;
+  fs::remove_all(root, ignored);
+}
+
+/**
+ * Times adding, finding and removing entities by name
+ * @param count The number of entities
+*/
+static void benchmarkEntities(int count) {
+  int repeats = count >= 1000000 ? BENCHMARK_LARGE_REPEATS : BENCHMARK_REPEATS;
+  std::vector<std::string> names(count);
+  for (int i = 0; i < count; i++) names[i] = "entity_" + std::to_string(i);
+  std::vector<int> order(count);
+  for (int i = 0; i < count; i++) order[i] = i;
+  std::shuffle(order.begin(), order.end(), std::mt19937(1234));
+
+  std::unique_ptr<EntityManager> manager;
+  auto fresh = [&]() { manager = std::make_unique<EntityManager>(); };
+  auto fill = [&]() {
+    fresh();
+    for (auto &name : names) manager->addEntity(name);
+  };
+  BenchmarkResult add = measure("addEntity", count, repeats, fresh, [&]() { for (auto &name : names) manager->addEntity(name); });
+  fill();
+  size_t found = 0;
+  BenchmarkResult get = measure("getEntity", count, repeats, [&]() {
+    found = 0;
+    for (int i : order) found += manager->getEntity(names[i]) != nullptr;
+  });
+  BenchmarkResult remove = measure("removeEntity", count, repeats, fill, [&]() { for (int i : order) manager->removeEntity(names[i]); });
+
+  beginGroup("Entities (" + std::to_string(count) + ")");
+  printResult(add);
+  printResult(get);
+  printResult(remove);
+  if (found != (size_t)count) std::printf("  WARNING: found %zu of %i entities\n", found, count);
+}
+
+/**
+ * Times updating every entity and submitting them for rendering to a null target, with the whole scene and one screen in view
+ * @param count The number of entities
+*/
+static void benchmarkManager(int count) {
+  int repeats = count >= 1000000 ? BENCHMARK_LARGE_REPEATS : BENCHMARK_REPEATS;
+  EntityManager manager;
+  sf::FloatRect world = addSyntheticEntities(manager, count);
+  NullRenderTarget target(1280, 960);
+  sf::View whole(world), screen(sf::FloatRect(world.left + world.width / 2 - 640, world.top + world.height / 2 - 480, 1280, 960));
+
+  BenchmarkResult update = measure("update", count, repeats, [&]() { manager.update(); });
+  BenchmarkResult all = measure("render submission, all in view", count, repeats, [&]() { manager.render(target, whole); });
+  BenchmarkResult one = measure("render submission, one screen", count, repeats, [&]() { manager.render(target, screen); });
+
+  beginGroup("EntityManager (" + std::to_string(count) + " entities)");
+  printResult(update);
+  printResult(all);
+  printResult(one);
+  std::printf("  %i entities on one screen in %i draw calls\n", manager.getRenderTimings().visible, manager.getRenderQueue().getDrawCalls());
+}
+
+/**
+ * Writes a UV sphere as .obj text, the same shape makeSphere builds
+ * @param filename The file written
+ * @param rings The number of rings from pole to pole
+ * @param segments The number of segments around each ring
+*/
+static void writeSphereObj(const std::string &filename, int rings, int segments) {
+  std::ofstream file(filename);
+  char line[96];
+  for (int r = 0; r <= rings; r++) {
+    float phi = 3.14159265f * r / rings;
+    for (int s = 0; s < segments; s++) {
+      float theta = 2 * 3.14159265f * s / segments;
+      std::snprintf(line, sizeof(line), "v %f %f %f\n", std::sin(phi) * std::cos(theta), std::cos(phi), std::sin(phi) * std::sin(theta));
+      file << line;
+    }
+  }
+  for (int r = 0; r < rings; r++) {
+    for (int s = 0; s < segments; s++) {
+      int a = r * segments + s + 1, b = r * segments + (s + 1) % segments + 1;
+      std::snprintf(line, sizeof(line), "f %i %i %i\nf %i %i %i\n", a, a + segments, b, b, a + segments, b + segments);
+      file << line;
+    }
+  }
+}
+
+/**
+ * Times parsing .obj files, the bundled model and generated spheres, with throughput in bytes
+*/
+static void benchmarkMeshRead() {
+  namespace fs = std::filesystem;
+  fs::path root = fs::temp_directory_path() / "mesh_benchmark";
+  fs::create_directories(root);
+  std::vector<std::pair<std::string, std::string>> files = {{"Person_model", "res/Person_model.obj"}};
+  for (auto [rings, segments] : {std::pair<int, int>(256, 512), std::pair<int, int>(1024, 1024)}) {
+    std::string label = "sphere " + std::to_string(rings) + "x" + std::to_string(segments);
+    std::string file = (root / ("sphere" + std::to_string(rings) + "x" + std::to_string(segments) + ".obj")).string();
+    writeSphereObj(file, rings, segments);
+    files.emplace_back(label, file);
+  }
+
+  beginGroup("Mesh::readFromFile (items are bytes)");
+  for (auto &[label, file] : files) {
+    std::error_code missing;
+    long long bytes = fs::file_size(file, missing);
+    if (missing) continue;
+    std::unique_ptr<Mesh> mesh;
+    BenchmarkResult result = measure("read " + label, bytes, bytes > (32 << 20) ? BENCHMARK_LARGE_REPEATS : BENCHMARK_REPEATS,
+      [&]() { mesh = std::make_unique<Mesh>(); }, [&]() { mesh->readFromFile(file.c_str()); });
+    printResult(result);
+    std::printf("  %zu vertices, %zu triangles\n", mesh->getVertices().size(), mesh->getTriangles().size() / 3);
+  }
+
+  std::error_code ignored;
+  fs::remove_all(root, ignored);
+}
+
+/**
+ * Runs every benchmark whose name contains the filter
+ * @param filter The substring selecting which benchmarks run @def{""}
+ * @param jsonFile The file every result is written to as JSON, or null for none @def{nullptr}
+ * @return The process exit code
+*/
+int runBenchmarks(const char *filter, const char *jsonFile) {
+  if (selected("vertex", filter)) {
+    Mesh person("res/Person_model.obj");
+    benchmarkVertexPipeline(person.getVertices(), "Person_model");
+
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> coordinate(-10.f, 10.f);
+    std::vector<Point> cloud;
+    cloud.reserve(1 << 20);
+    for (int i = 0; i < (1 << 20); i++) cloud.emplace_back(coordinate(rng), coordinate(rng), coordinate(rng));
+    benchmarkVertexPipeline(cloud, "1M random");
+  }
+  if (selected("lod", filter)) {
+    Mesh person("res/Person_model.obj");
+    benchmarkLODs(person, "Person_model");
+    Mesh sphere = makeSphere(256, 512);
+    benchmarkLODs(sphere, "sphere 256x512");
+  }
+  if (selected("bvh", filter)) {
+    Mesh person("res/Person_model.obj");
+    benchmarkBVH(person, "Person_model");
+    benchmarkBVH(makeSphere(256, 512), "sphere 256x512");
+    benchmarkBVH(makeSphere(1024, 1024), "sphere 1024x1024");
+  }
+  if (selected("particles", filter)) {
+    benchmarkParticles(100000);
+    benchmarkParticles(1 << 20);
+  }
+  if (selected("visibility", filter)) {
+    benchmarkVisibility(64);
+    benchmarkVisibility(256);
+  }
+  if (selected("archive", filter)) {
+    benchmarkArchive(500, 4096);
+    benchmarkArchive(100, 256 << 10);
+  }
+  if (selected("pacing", filter)) benchmarkPacing(240);
+  bool passed = true;
+  if (selected("logging", filter)) passed = benchmarkLogging() && passed;
+  if (selected("level", filter)) benchmarkLevels();
+  if (selected("generator", filter)) benchmarkLevelGeneration();
+  if (selected("entities", filter))
+    for (int count : {1000, 10000, 100000, 1000000}) benchmarkEntities(count);
+  if (selected("manager", filter)) {
+    benchmarkManager(10000);
+    benchmarkManager(100000);
+  }
+  if (selected("mesh", filter)) benchmarkMeshRead();
+  if (jsonFile && !writeResults(jsonFile)) return 1;
+  return passed ? 0 : 1;
+}
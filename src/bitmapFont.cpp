@@ -0,0 +1,207 @@
+#include "BitmapFont.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+
+/**
+ * Bakes the printable ASCII glyphs of a font at one size into an atlas owned by this font
+ * Note: The atlas is copied out of the sf::Font, so the font may be released afterwards
+ * @param font The font being baked
+ * @param size The character size in pixels
+ * @return Whether the atlas was uploaded
+*/
+bool BitmapFont::bake(const sf::Font &font, unsigned int size) {
+  for (int i = 0; i < GLYPH_COUNT; i++) {
+    const sf::Glyph &glyph = font.getGlyph(FIRST_GLYPH + i, size, false);
+    glyphs[i].bounds = glyph.bounds;
+    glyphs[i].textureRect = glyph.textureRect;
+    glyphs[i].advance = glyph.advance;
+  }
+  // Copied after every glyph is requested, since the font's texture grows as glyphs are added
+  image = font.getTexture(size).copyToImage();
+  characterSize = size;
+  lineSpacing = font.getLineSpacing(size);
+  buildQuads();
+  return texture.loadFromImage(image);
+}
+
+/**
+ * Saves the atlas image alongside a metadata file listing each glyph's metrics
+ * @param filename The image path; the metadata is written to the same path with .txt appended
+ * @return Whether both files were written
+*/
+bool BitmapFont::saveToFile(const std::string &filename) const {
+  if (!image.saveToFile(filename)) return false;
+  std::ofstream file(filename + ".txt");
+  if (!file) return false;
+  file << characterSize << " " << lineSpacing << "\n";
+  for (auto &glyph : glyphs) {
+    file << glyph.advance << " " << glyph.bounds.left << " " << glyph.bounds.top << " " << glyph.bounds.width << " " << glyph.bounds.height
+         << " " << glyph.textureRect.left << " " << glyph.textureRect.top << " " << glyph.textureRect.width << " " << glyph.textureRect.height << "\n";
+  }
+  return true;
+}
+
+/**
+ * Loads an atlas image and its metadata, then uploads the texture
+ * @param filename The image path as given to saveToFile
+ * @return Whether the font was loaded
+*/
+bool BitmapFont::loadFromFile(const std::string &filename) {
+  std::ifstream file(filename + ".txt");
+  if (!file || !(file >> characterSize >> lineSpacing) || !image.loadFromFile(filename)) return false;
+  for (auto &glyph : glyphs) {
+    if (!(file >> glyph.advance >> glyph.bounds.left >> glyph.bounds.top >> glyph.bounds.width >> glyph.bounds.height
+               >> glyph.textureRect.left >> glyph.textureRect.top >> glyph.textureRect.width >> glyph.textureRect.height)) return false;
+  }
+  buildQuads();
+  return texture.loadFromImage(image);
+}
+
+/**
+ * Builds two triangles per glyph positioned relative to a pen at the origin, so laying out text is a copy and an offset
+*/
+void BitmapFont::buildQuads() {
+  for (int i = 0; i < GLYPH_COUNT; i++) {
+    const sf::FloatRect &b = glyphs[i].bounds;
+    const sf::IntRect &r = glyphs[i].textureRect;
+    float left = b.left, top = b.top, right = b.left + b.width, bottom = b.top + b.height;
+    float u0 = r.left, v0 = r.top, u1 = r.left + r.width, v1 = r.top + r.height;
+    sf::Vertex *quad = quads[i];
+    quad[0] = sf::Vertex(sf::Vector2f(left, top), sf::Color::White, sf::Vector2f(u0, v0));
+    quad[1] = sf::Vertex(sf::Vector2f(right, top), sf::Color::White, sf::Vector2f(u1, v0));
+    quad[2] = sf::Vertex(sf::Vector2f(left, bottom), sf::Color::White, sf::Vector2f(u0, v1));
+    quad[3] = quad[2];
+    quad[4] = quad[1];
+    quad[5] = sf::Vertex(sf::Vector2f(right, bottom), sf::Color::White, sf::Vector2f(u1, v1));
+  }
+}
+
+/**
+ * Measures the width of a string, taking the widest line
+ * @param text The string being measured
+ * @return The width in pixels
+*/
+float BitmapFont::measure(const std::string &text) const {
+  float width = 0, line = 0;
+  for (char c : text) {
+    line = c == '\n' ? 0 : line + getGlyph(c).advance;
+    width = std::max(width, line);
+  }
+  return width;
+}
+
+/**
+ * Adds a string to the batch
+ * @param text The initial string
+ * @param position The pen position of the first character on the baseline
+ * @param color The text colour @def{sf::Color::White}
+ * @param capacity The most characters the string can later hold, at least its initial length @def{0}
+ * @return The slot used to change the string
+*/
+int TextBatch::add(const std::string &text, sf::Vector2f position, sf::Color color, size_t capacity) {
+  Slot slot;
+  slot.first = getGlyphCount();
+  slot.capacity = std::max(capacity, text.size());
+  slot.position = position;
+  slot.color = color;
+  vertices.resize(vertices.size() + slot.capacity * VERTICES_PER_GLYPH);
+  slots.push_back(slot);
+  write(slots.back(), text.data(), text.size());
+  return slots.size() - 1;
+}
+
+/**
+ * Copies each glyph's quad into a slot, collapsing any quads left over from a longer string
+ * @param slot The slot being written
+ * @param text The characters
+ * @param length The number of characters, truncated to the slot's capacity
+*/
+void TextBatch::write(Slot &slot, const char *text, size_t length) {
+  if (!font) return;
+  length = std::min(length, slot.capacity);
+  sf::Vertex *out = &vertices[slot.first * VERTICES_PER_GLYPH];
+  sf::Vector2f pen = slot.position;
+
+  for (size_t i = 0; i < length; i++, out += VERTICES_PER_GLYPH) {
+    if (text[i] == '\n') {
+      std::fill(out, out + VERTICES_PER_GLYPH, sf::Vertex());
+      pen = sf::Vector2f(slot.position.x, pen.y + font->getLineSpacing());
+      continue;
+    }
+    std::memcpy(out, font->getQuad(text[i]), sizeof(sf::Vertex) * VERTICES_PER_GLYPH);
+    for (int v = 0; v < VERTICES_PER_GLYPH; v++) {
+      out[v].position += pen;
+      out[v].color = slot.color;
+    }
+    pen.x += font->getGlyph(text[i]).advance;
+  }
+  if (length < slot.length) std::fill(out, out + (slot.length - length) * VERTICES_PER_GLYPH, sf::Vertex());
+  slot.length = length;
+}
+
+/**
+ * Replaces the string in a slot
+ * @param slot The slot returned by add
+ * @param text The new string, truncated to the slot's capacity
+*/
+void TextBatch::set(int slot, const std::string &text) {
+  write(slots[slot], text.data(), text.size());
+}
+
+/**
+ * Replaces the string in a slot with an integer, without allocating
+ * @param slot The slot returned by add
+ * @param value The number shown
+*/
+void TextBatch::setNumber(int slot, long long value) {
+  char buffer[24];
+  char *end = std::to_chars(buffer, buffer + sizeof(buffer), value).ptr;
+  write(slots[slot], buffer, end - buffer);
+}
+
+/**
+ * Replaces the string in a slot with a fixed point number, without allocating
+ * @param slot The slot returned by add
+ * @param value The number shown
+ * @param decimals The digits shown after the decimal point
+*/
+void TextBatch::setNumber(int slot, double value, int decimals) {
+  char buffer[32];
+  int length = std::snprintf(buffer, sizeof(buffer), "%.*f", decimals, value);
+  write(slots[slot], buffer, std::clamp(length, 0, (int)sizeof(buffer) - 1));
+}
+
+/**
+ * Recolours the string in a slot
+ * @param slot The slot returned by add
+ * @param color The new colour
+*/
+void TextBatch::setColor(int slot, sf::Color color) {
+  Slot &target = slots[slot];
+  target.color = color;
+  sf::Vertex *begin = &vertices[target.first * VERTICES_PER_GLYPH];
+  for (sf::Vertex *v = begin; v != begin + target.length * VERTICES_PER_GLYPH; v++) v->color = color;
+}
+
+/**
+ * Removes every string from the batch
+*/
+void TextBatch::clear() {
+  vertices.clear();
+  slots.clear();
+}
+
+/**
+ * Draws every string in the batch with one draw call
+*/
+void TextBatch::draw(sf::RenderTarget &target, sf::RenderStates states) const {
+  if (!font || vertices.empty()) return;
+  states.transform *= getTransform();
+  states.texture = &font->getTexture();
+  target.draw(vertices.data(), vertices.size(), sf::Triangles, states);
+}
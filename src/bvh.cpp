@@ -0,0 +1,494 @@
+#include "BVH.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define BVH_SSE
+#endif
+
+#define SAH_BINS 16
+#define MIN_LEAF_SIZE 2
+#define MAX_LEAF_SIZE 16
+#define TRAVERSAL_COST 1.f
+#define MAX_STACK 64
+// Deeper runs are halved instead of binned, so 32 more levels split any triangle count and a traversal stack never overflows
+#define MAX_SAH_DEPTH (MAX_STACK - 32)
+
+/**
+ * Constructs a ray from an origin and direction
+ * @param origin The start of the ray
+ * @param dir The direction of the ray
+ * @param t The furthest distance along the direction to report hits at @def{1e30}
+*/
+Ray::Ray(const Point &origin, const Point &dir, float t) : maxT(t) {
+  this->origin[0] = origin.x; this->origin[1] = origin.y; this->origin[2] = origin.z;
+  direction[0] = dir.x; direction[1] = dir.y; direction[2] = dir.z;
+}
+
+/**
+ * Constructs the segment between two points, for line of sight tests
+ * @param from The start point
+ * @param to The end point, reached at t = 1
+ * @return The ray segment
+*/
+Ray Ray::between(const Point &from, const Point &to) {
+  return Ray(from, Point(to.x - from.x, to.y - from.y, to.z - from.z), 1.f);
+}
+
+/**
+ * Copies a ray into one lane of the packet
+ * @param lane The lane being written
+ * @param ray The ray being copied
+*/
+void RayPacket::set(int lane, const Ray &ray) {
+  for (int axis = 0; axis < 3; axis++) {
+    origin[axis][lane] = ray.origin[axis];
+    direction[axis][lane] = ray.direction[axis];
+  }
+  maxT[lane] = ray.maxT;
+}
+
+/**
+ * Builds the hierarchy over a mesh's triangles
+ * @param mesh The mesh being indexed
+*/
+BVH::BVH(const Mesh &mesh) {
+  build(mesh.getVertices(), mesh.getTriangles());
+}
+
+static float surfaceArea(const float *min, const float *max) {
+  float dx = max[0] - min[0], dy = max[1] - min[1], dz = max[2] - min[2];
+  return dx < 0 ? 0 : 2 * (dx*dy + dy*dz + dz*dx);
+}
+
+static void growBounds(float *min, float *max, const float *otherMin, const float *otherMax) {
+  for (int axis = 0; axis < 3; axis++) {
+    min[axis] = std::min(min[axis], otherMin[axis]);
+    max[axis] = std::max(max[axis], otherMax[axis]);
+  }
+}
+
+/**
+ * Builds the hierarchy from vertices and a triangle list
+ * @param points The mesh vertices
+ * @param triangles Three vertex indices per triangle
+*/
+void BVH::build(const std::vector<Point> &points, const std::vector<unsigned int> &triangles) {
+  unsigned int count = triangles.size() / 3;
+  nodes.clear();
+  order.resize(count);
+  depth = 0;
+  if (count == 0) return;
+
+  // Bounds hold the min, max and centroid of each triangle
+  std::vector<float> bounds(count * 9);
+  for (unsigned int t = 0; t < count; t++) {
+    float *b = &bounds[t * 9];
+    const Point &a = points[triangles[t*3]], &c = points[triangles[t*3 + 1]], &d = points[triangles[t*3 + 2]];
+    b[0] = std::min({a.x, c.x, d.x}); b[1] = std::min({a.y, c.y, d.y}); b[2] = std::min({a.z, c.z, d.z});
+    b[3] = std::max({a.x, c.x, d.x}); b[4] = std::max({a.y, c.y, d.y}); b[5] = std::max({a.z, c.z, d.z});
+    for (int axis = 0; axis < 3; axis++) b[6 + axis] = (b[axis] + b[3 + axis]) / 2;
+    order[t] = t;
+  }
+
+  nodes.reserve(count * 2);
+  buildNode(bounds, 0, count, 1);
+
+  triangleData.resize(count * 9);
+  for (unsigned int i = 0; i < count; i++) {
+    const Point &a = points[triangles[order[i]*3]], &b = points[triangles[order[i]*3 + 1]], &c = points[triangles[order[i]*3 + 2]];
+    float data[9] = {a.x, a.y, a.z, b.x - a.x, b.y - a.y, b.z - a.z, c.x - a.x, c.y - a.y, c.z - a.z};
+    std::copy(data, data + 9, &triangleData[i * 9]);
+  }
+}
+
+/**
+ * Recursively builds a node, splitting at the cheapest of the binned candidate planes
+ * Note: Traversal holds at most one pending node per level, so the depth is kept within MAX_STACK
+ * @param bounds The per-triangle bounds and centroids
+ * @param first The first entry of the triangle order within this node
+ * @param count The number of triangles within this node
+ * @param level The depth of this node
+ * @return The index of the node
+*/
+unsigned int BVH::buildNode(std::vector<float> &bounds, unsigned int first, unsigned int count, int level) {
+  unsigned int index = nodes.size();
+  nodes.emplace_back();
+  depth = std::max(depth, level);
+
+  float min[3] = {1e30f, 1e30f, 1e30f}, max[3] = {-1e30f, -1e30f, -1e30f};
+  float centroidMin[3] = {1e30f, 1e30f, 1e30f}, centroidMax[3] = {-1e30f, -1e30f, -1e30f};
+  for (unsigned int i = first; i < first + count; i++) {
+    const float *b = &bounds[order[i] * 9];
+    growBounds(min, max, b, b + 3);
+    growBounds(centroidMin, centroidMax, b + 6, b + 6);
+  }
+  BVHNode &node = nodes[index];
+  std::copy(min, min + 3, node.min);
+  std::copy(max, max + 3, node.max);
+  node.offset = first;
+  node.count = count;
+  node.axis = 0;
+  if (count <= MIN_LEAF_SIZE) return index;
+
+  // Evaluate every bin boundary on every axis
+  float bestCost = 1e30f;
+  int bestAxis = -1, bestSplit = 0;
+  for (int axis = 0; axis < 3; axis++) {
+    float extent = centroidMax[axis] - centroidMin[axis];
+    if (extent <= 0) continue;
+    float binMin[SAH_BINS][3], binMax[SAH_BINS][3];
+    int binCount[SAH_BINS] = {0};
+    for (int bin = 0; bin < SAH_BINS; bin++) {
+      std::fill(binMin[bin], binMin[bin] + 3, 1e30f);
+      std::fill(binMax[bin], binMax[bin] + 3, -1e30f);
+    }
+    float scale = SAH_BINS / extent;
+    for (unsigned int i = first; i < first + count; i++) {
+      const float *b = &bounds[order[i] * 9];
+      int bin = std::min(SAH_BINS - 1, (int)((b[6 + axis] - centroidMin[axis]) * scale));
+      binCount[bin]++;
+      growBounds(binMin[bin], binMax[bin], b, b + 3);
+    }
+
+    // Sweep from the right to find the cost of everything beyond each boundary
+    float rightArea[SAH_BINS];
+    int rightCount[SAH_BINS];
+    float sweepMin[3] = {1e30f, 1e30f, 1e30f}, sweepMax[3] = {-1e30f, -1e30f, -1e30f};
+    int sweepCount = 0;
+    for (int bin = SAH_BINS - 1; bin > 0; bin--) {
+      growBounds(sweepMin, sweepMax, binMin[bin], binMax[bin]);
+      sweepCount += binCount[bin];
+      rightArea[bin] = surfaceArea(sweepMin, sweepMax);
+      rightCount[bin] = sweepCount;
+    }
+    std::fill(sweepMin, sweepMin + 3, 1e30f);
+    std::fill(sweepMax, sweepMax + 3, -1e30f);
+    sweepCount = 0;
+    for (int bin = 0; bin < SAH_BINS - 1; bin++) {
+      growBounds(sweepMin, sweepMax, binMin[bin], binMax[bin]);
+      sweepCount += binCount[bin];
+      if (sweepCount == 0 || rightCount[bin + 1] == 0) continue;
+      float cost = sweepCount * surfaceArea(sweepMin, sweepMax) + rightCount[bin + 1] * rightArea[bin + 1];
+      if (cost < bestCost) {
+        bestCost = cost;
+        bestAxis = axis;
+        bestSplit = bin;
+      }
+    }
+  }
+
+  float leafCost = count * surfaceArea(min, max);
+  float splitCost = TRAVERSAL_COST * surfaceArea(min, max) + bestCost;
+  bool deep = level >= MAX_SAH_DEPTH;
+  if (deep || bestAxis < 0 || (splitCost >= leafCost && count <= MAX_LEAF_SIZE)) {
+    if (count <= MAX_LEAF_SIZE) return index;
+
+    // Identical centroids cannot be binned and deep runs must stop growing the stack, so halve the run to bound leaf sizes
+    unsigned int half = count / 2;
+    nodes[index].count = 0;
+    buildNode(bounds, first, half, level + 1);
+    nodes[index].offset = buildNode(bounds, first + half, count - half, level + 1);
+    return index;
+  }
+
+  float scale = SAH_BINS / (centroidMax[bestAxis] - centroidMin[bestAxis]);
+  unsigned int *middle = std::partition(&order[first], &order[first] + count, [&](unsigned int t) {
+    int bin = std::min(SAH_BINS - 1, (int)((bounds[t*9 + 6 + bestAxis] - centroidMin[bestAxis]) * scale));
+    return bin <= bestSplit;
+  });
+  unsigned int leftCount = middle - &order[first];
+
+  nodes[index].count = 0;
+  nodes[index].axis = bestAxis;
+  buildNode(bounds, first, leftCount, level + 1);
+  unsigned int right = buildNode(bounds, first + leftCount, count - leftCount, level + 1);
+  nodes[index].offset = right;
+  return index;
+}
+
+/**
+ * Defines a ray with its reciprocal direction cached for slab tests
+*/
+struct TraversalRay {
+  float origin[3], inverse[3];
+  float maxT;
+#ifdef BVH_SSE
+  __m128 origin4, inverse4, mask4, zero4;
+#endif
+
+  TraversalRay(const Ray &ray, float t) : maxT(t) {
+    for (int axis = 0; axis < 3; axis++) {
+      origin[axis] = ray.origin[axis];
+      inverse[axis] = 1.f / ray.direction[axis];
+    }
+#ifdef BVH_SSE
+    origin4 = _mm_set_ps(0, origin[2], origin[1], origin[0]);
+    inverse4 = _mm_set_ps(0, inverse[2], inverse[1], inverse[0]);
+    mask4 = _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1));
+    zero4 = _mm_setzero_ps();
+#endif
+  }
+
+  // Returns the entry distance into a box, or a negative value on a miss
+  float enter(const BVHNode &node) const {
+#ifdef BVH_SSE
+    // The fourth lane carries the ray interval itself so one horizontal reduction covers everything
+    __m128 t1 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node.min), origin4), inverse4);
+    __m128 t2 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node.max), origin4), inverse4);
+    __m128 tNear = _mm_min_ps(t1, t2), tFar = _mm_max_ps(t1, t2);
+    tNear = _mm_or_ps(_mm_and_ps(mask4, tNear), _mm_andnot_ps(mask4, zero4));
+    tFar = _mm_or_ps(_mm_and_ps(mask4, tFar), _mm_andnot_ps(mask4, _mm_set1_ps(maxT)));
+    tNear = _mm_max_ps(tNear, _mm_shuffle_ps(tNear, tNear, _MM_SHUFFLE(1, 0, 3, 2)));
+    tNear = _mm_max_ps(tNear, _mm_shuffle_ps(tNear, tNear, _MM_SHUFFLE(2, 3, 0, 1)));
+    tFar = _mm_min_ps(tFar, _mm_shuffle_ps(tFar, tFar, _MM_SHUFFLE(1, 0, 3, 2)));
+    tFar = _mm_min_ps(tFar, _mm_shuffle_ps(tFar, tFar, _MM_SHUFFLE(2, 3, 0, 1)));
+    float entry = _mm_cvtss_f32(tNear), exit = _mm_cvtss_f32(tFar);
+#else
+    float entry = 0, exit = maxT;
+    for (int axis = 0; axis < 3; axis++) {
+      float t1 = (node.min[axis] - origin[axis]) * inverse[axis];
+      float t2 = (node.max[axis] - origin[axis]) * inverse[axis];
+      entry = std::max(entry, std::min(t1, t2));
+      exit = std::min(exit, std::max(t1, t2));
+    }
+#endif
+    return entry <= exit ? entry : -1.f;
+  }
+};
+
+/**
+ * Intersects a ray with a triangle through the Moller-Trumbore test
+ * @return The distance along the ray, or a negative value on a miss
+*/
+static inline float intersectTriangle(const float *tri, const float *origin, const float *dir, float &u, float &v) {
+  const float *e1 = tri + 3, *e2 = tri + 6;
+  float p[3] = {dir[1]*e2[2] - dir[2]*e2[1], dir[2]*e2[0] - dir[0]*e2[2], dir[0]*e2[1] - dir[1]*e2[0]};
+  float det = e1[0]*p[0] + e1[1]*p[1] + e1[2]*p[2];
+  if (std::fabs(det) < 1e-12f) return -1.f;
+  float inv = 1.f / det;
+  float s[3] = {origin[0] - tri[0], origin[1] - tri[1], origin[2] - tri[2]};
+  u = (s[0]*p[0] + s[1]*p[1] + s[2]*p[2]) * inv;
+  if (u < 0 || u > 1) return -1.f;
+  float q[3] = {s[1]*e1[2] - s[2]*e1[1], s[2]*e1[0] - s[0]*e1[2], s[0]*e1[1] - s[1]*e1[0]};
+  v = (dir[0]*q[0] + dir[1]*q[1] + dir[2]*q[2]) * inv;
+  if (v < 0 || u + v > 1) return -1.f;
+  return (e2[0]*q[0] + e2[1]*q[1] + e2[2]*q[2]) * inv;
+}
+
+/**
+ * Finds the nearest triangle along a ray
+ * @param ray The ray being traced
+ * @param hit The nearest hit, left untouched on a miss
+ * @return Whether anything was hit
+*/
+bool BVH::closestHit(const Ray &ray, RayHit &hit) const {
+  if (nodes.empty()) return false;
+  TraversalRay traversal(ray, std::min(ray.maxT, hit.t));
+  unsigned int stack[MAX_STACK];
+  int stackSize = 0;
+  unsigned int current = 0;
+  bool found = false;
+  if (traversal.enter(nodes[0]) < 0) return false;
+
+  while (true) {
+    const BVHNode &node = nodes[current];
+    if (node.count) {
+      for (unsigned int i = node.offset; i < node.offset + node.count; i++) {
+        float u, v;
+        float t = intersectTriangle(&triangleData[i * 9], ray.origin, ray.direction, u, v);
+        if (t > 0 && t < traversal.maxT) {
+          traversal.maxT = t;
+          hit.t = t; hit.u = u; hit.v = v;
+          hit.triangle = order[i];
+          found = true;
+        }
+      }
+    } else {
+      // Visit the nearer child first so the far one is often culled by the shrinking interval
+      unsigned int left = current + 1, right = node.offset;
+      float leftEntry = traversal.enter(nodes[left]), rightEntry = traversal.enter(nodes[right]);
+      if (leftEntry >= 0 && rightEntry >= 0) {
+        if (rightEntry < leftEntry) std::swap(left, right);
+        stack[stackSize++] = right;
+        current = left;
+        continue;
+      } else if (leftEntry >= 0) {
+        current = left;
+        continue;
+      } else if (rightEntry >= 0) {
+        current = right;
+        continue;
+      }
+    }
+
+    // Skip popped nodes the ray can no longer reach closer than the current hit
+    do {
+      if (stackSize == 0) return found;
+      current = stack[--stackSize];
+    } while (traversal.enter(nodes[current]) < 0);
+  }
+}
+
+/**
+ * Checks whether anything lies along a ray, stopping at the first hit found
+ * @param ray The ray being traced
+ * @return Whether any triangle was hit
+*/
+bool BVH::anyHit(const Ray &ray) const {
+  if (nodes.empty()) return false;
+  TraversalRay traversal(ray, ray.maxT);
+  unsigned int stack[MAX_STACK];
+  int stackSize = 0;
+  stack[stackSize++] = 0;
+
+  while (stackSize) {
+    const BVHNode &node = nodes[stack[--stackSize]];
+    if (traversal.enter(node) < 0) continue;
+    if (node.count) {
+      for (unsigned int i = node.offset; i < node.offset + node.count; i++) {
+        float u, v;
+        float t = intersectTriangle(&triangleData[i * 9], ray.origin, ray.direction, u, v);
+        if (t > 0 && t < ray.maxT) return true;
+      }
+    } else {
+      stack[stackSize++] = node.offset;
+      stack[stackSize++] = &node - &nodes[0] + 1;
+    }
+  }
+  return false;
+}
+
+/**
+ * Finds the nearest triangle along each ray of a packet, testing every box and triangle against all lanes at once
+ * @param packet The rays being traced
+ * @param hits The nearest hit per lane, RAY_PACKET_SIZE entries
+*/
+void BVH::closestHit(const RayPacket &packet, RayHit *hits) const {
+  for (int lane = 0; lane < RAY_PACKET_SIZE; lane++) hits[lane] = RayHit();
+  if (nodes.empty()) return;
+  unsigned int stack[MAX_STACK];
+  int stackSize = 0;
+  stack[stackSize++] = 0;
+
+#ifdef BVH_SSE
+  __m128 origin[3], direction[3], inverse[3];
+  for (int axis = 0; axis < 3; axis++) {
+    origin[axis] = _mm_loadu_ps(packet.origin[axis]);
+    direction[axis] = _mm_loadu_ps(packet.direction[axis]);
+    inverse[axis] = _mm_div_ps(_mm_set1_ps(1.f), direction[axis]);
+  }
+  __m128 best = _mm_loadu_ps(packet.maxT);
+  __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.f), epsilon = _mm_set1_ps(1e-12f);
+  __m128i bestTriangle = _mm_set1_epi32(-1);
+  __m128 bestU = zero, bestV = zero;
+
+  while (stackSize) {
+    const BVHNode &node = nodes[stack[--stackSize]];
+
+    // Slab test of the box against all four rays
+    __m128 entry = zero, exit = best;
+    for (int axis = 0; axis < 3; axis++) {
+      __m128 t1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.min[axis]), origin[axis]), inverse[axis]);
+      __m128 t2 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.max[axis]), origin[axis]), inverse[axis]);
+      entry = _mm_max_ps(entry, _mm_min_ps(t1, t2));
+      exit = _mm_min_ps(exit, _mm_max_ps(t1, t2));
+    }
+    if (_mm_movemask_ps(_mm_cmple_ps(entry, exit)) == 0) continue;
+
+    // Coherent rays share a direction, so the first ray decides which child is nearer
+    if (node.count == 0) {
+      unsigned int nearChild = &node - &nodes[0] + 1, farChild = node.offset;
+      if (packet.direction[node.axis][0] < 0) std::swap(nearChild, farChild);
+      stack[stackSize++] = farChild;
+      stack[stackSize++] = nearChild;
+      continue;
+    }
+
+    for (unsigned int i = node.offset; i < node.offset + node.count; i++) {
+      const float *tri = &triangleData[i * 9];
+      __m128 e1[3] = {_mm_set1_ps(tri[3]), _mm_set1_ps(tri[4]), _mm_set1_ps(tri[5])};
+      __m128 e2[3] = {_mm_set1_ps(tri[6]), _mm_set1_ps(tri[7]), _mm_set1_ps(tri[8])};
+      __m128 p[3] = {
+        _mm_sub_ps(_mm_mul_ps(direction[1], e2[2]), _mm_mul_ps(direction[2], e2[1])),
+        _mm_sub_ps(_mm_mul_ps(direction[2], e2[0]), _mm_mul_ps(direction[0], e2[2])),
+        _mm_sub_ps(_mm_mul_ps(direction[0], e2[1]), _mm_mul_ps(direction[1], e2[0]))
+      };
+      __m128 det = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e1[0], p[0]), _mm_mul_ps(e1[1], p[1])), _mm_mul_ps(e1[2], p[2]));
+      __m128 absDet = _mm_andnot_ps(_mm_set1_ps(-0.f), det);
+      __m128 inv = _mm_div_ps(one, det);
+      __m128 s[3] = {
+        _mm_sub_ps(origin[0], _mm_set1_ps(tri[0])), _mm_sub_ps(origin[1], _mm_set1_ps(tri[1])), _mm_sub_ps(origin[2], _mm_set1_ps(tri[2]))
+      };
+      __m128 u = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(s[0], p[0]), _mm_mul_ps(s[1], p[1])), _mm_mul_ps(s[2], p[2])), inv);
+      __m128 q[3] = {
+        _mm_sub_ps(_mm_mul_ps(s[1], e1[2]), _mm_mul_ps(s[2], e1[1])),
+        _mm_sub_ps(_mm_mul_ps(s[2], e1[0]), _mm_mul_ps(s[0], e1[2])),
+        _mm_sub_ps(_mm_mul_ps(s[0], e1[1]), _mm_mul_ps(s[1], e1[0]))
+      };
+      __m128 v = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(direction[0], q[0]), _mm_mul_ps(direction[1], q[1])), _mm_mul_ps(direction[2], q[2])), inv);
+      __m128 t = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(e2[0], q[0]), _mm_mul_ps(e2[1], q[1])), _mm_mul_ps(e2[2], q[2])), inv);
+
+      __m128 valid = _mm_and_ps(_mm_cmpgt_ps(absDet, epsilon), _mm_cmpge_ps(u, zero));
+      valid = _mm_and_ps(valid, _mm_and_ps(_mm_cmpge_ps(v, zero), _mm_cmple_ps(_mm_add_ps(u, v), one)));
+      valid = _mm_and_ps(valid, _mm_and_ps(_mm_cmpgt_ps(t, zero), _mm_cmplt_ps(t, best)));
+      if (_mm_movemask_ps(valid) == 0) continue;
+
+      best = _mm_or_ps(_mm_and_ps(valid, t), _mm_andnot_ps(valid, best));
+      bestU = _mm_or_ps(_mm_and_ps(valid, u), _mm_andnot_ps(valid, bestU));
+      bestV = _mm_or_ps(_mm_and_ps(valid, v), _mm_andnot_ps(valid, bestV));
+      __m128i validInt = _mm_castps_si128(valid);
+      bestTriangle = _mm_or_si128(_mm_and_si128(validInt, _mm_set1_epi32(order[i])), _mm_andnot_si128(validInt, bestTriangle));
+    }
+  }
+
+  float t[RAY_PACKET_SIZE], u[RAY_PACKET_SIZE], v[RAY_PACKET_SIZE];
+  unsigned int triangle[RAY_PACKET_SIZE];
+  _mm_storeu_ps(t, best);
+  _mm_storeu_ps(u, bestU);
+  _mm_storeu_ps(v, bestV);
+  _mm_storeu_si128((__m128i*)triangle, bestTriangle);
+  for (int lane = 0; lane < RAY_PACKET_SIZE; lane++) {
+    if (triangle[lane] == ~0u) continue;
+    hits[lane].t = t[lane]; hits[lane].u = u[lane]; hits[lane].v = v[lane];
+    hits[lane].triangle = triangle[lane];
+  }
+#else
+  for (int lane = 0; lane < RAY_PACKET_SIZE; lane++) {
+    Ray ray;
+    for (int axis = 0; axis < 3; axis++) {
+      ray.origin[axis] = packet.origin[axis][lane];
+      ray.direction[axis] = packet.direction[axis][lane];
+    }
+    ray.maxT = packet.maxT[lane];
+    closestHit(ray, hits[lane]);
+  }
+#endif
+}
+
+/**
+ * Checks whether a point lies within the bounds of any leaf, a tight broad phase for containment queries
+ * @param point The point being tested
+ * @return Whether any leaf bounds contain the point
+*/
+bool BVH::pointInBounds(const Point &point) const {
+  if (nodes.empty()) return false;
+  float p[3] = {point.x, point.y, point.z};
+  unsigned int stack[MAX_STACK];
+  int stackSize = 0;
+  stack[stackSize++] = 0;
+
+  while (stackSize) {
+    const BVHNode &node = nodes[stack[--stackSize]];
+    bool inside = true;
+    for (int axis = 0; axis < 3; axis++) inside &= p[axis] >= node.min[axis] && p[axis] <= node.max[axis];
+    if (!inside) continue;
+    if (node.count) return true;
+    stack[stackSize++] = node.offset;
+    stack[stackSize++] = &node - &nodes[0] + 1;
+  }
+  return false;
+}
@@ -0,0 +1,85 @@
+#include "Camera.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+/**
+ * Constructs a camera showing a world area
+ * @param area The world area shown at a zoom of 1
+*/
+Camera::Camera(const sf::FloatRect &area) : view(area), baseSize(area.width, area.height) { }
+
+/**
+ * Moves the camera immediately, keeping it within its bounds
+ * @param center The world position at the centre of the view
+*/
+void Camera::setCenter(sf::Vector2f center) {
+  clampToBounds(center);
+  view.setCenter(center);
+}
+
+/**
+ * Sets the zoom the camera eases towards, where 2 shows twice the width and height of the world
+ * @param factor The zoom, clamped to the zoom limits
+ * @param immediate Whether the zoom is applied without easing @def{false}
+*/
+void Camera::setZoom(float factor, bool immediate) {
+  targetZoom = std::clamp(factor, minZoom, maxZoom);
+  if (!immediate) return;
+  zoom = targetZoom;
+  view.setSize(baseSize * zoom);
+  setCenter(view.getCenter());
+}
+
+/**
+ * Changes the world area shown at a zoom of 1, normally after the window or viewport is resized
+ * @param size The width and height shown at a zoom of 1
+*/
+void Camera::resize(sf::Vector2f size) {
+  baseSize = size;
+  view.setSize(baseSize * zoom);
+  setCenter(view.getCenter());
+}
+
+/**
+ * Eases the zoom towards its target and the centre towards the followed entity
+ * Note: The target only pulls the camera once it leaves the dead zone, and easing is exponential so it is independent of frame rate
+ * @param dt The time step in seconds
+*/
+void Camera::update(float dt) {
+  float blend = 1 - std::exp(-followRate * dt);
+  zoom += (targetZoom - zoom) * blend;
+  view.setSize(baseSize * zoom);
+
+  sf::Vector2f center = view.getCenter();
+  if (std::shared_ptr<Entity> entity = target.lock()) {
+    sf::FloatRect bounds = entity->getBounds();
+    sf::Vector2f offset = sf::Vector2f(bounds.left + bounds.width / 2, bounds.top + bounds.height / 2) - center;
+    sf::Vector2f pull(0, 0);
+    if (std::abs(offset.x) > deadZone.x) pull.x = offset.x - std::copysign(deadZone.x, offset.x);
+    if (std::abs(offset.y) > deadZone.y) pull.y = offset.y - std::copysign(deadZone.y, offset.y);
+    center += pull * blend;
+  }
+  setCenter(center);
+}
+
+/**
+ * Keeps the view within the camera's bounds, centring it on any axis where the bounds are smaller than the view
+ * @param center The centre being clamped
+*/
+void Camera::clampToBounds(sf::Vector2f &center) const {
+  if (!bounded) return;
+  sf::Vector2f half = view.getSize() / 2.f;
+  if (bounds.width <= half.x * 2) center.x = bounds.left + bounds.width / 2;
+  else center.x = std::clamp(center.x, bounds.left + half.x, bounds.left + bounds.width - half.x);
+  if (bounds.height <= half.y * 2) center.y = bounds.top + bounds.height / 2;
+  else center.y = std::clamp(center.y, bounds.top + half.y, bounds.top + bounds.height - half.y);
+}
+
+/**
+ * Returns the world area the camera shows, used to cull everything outside it
+ * @return The axis aligned bounds of the view
+*/
+sf::FloatRect Camera::getVisibleRect() const {
+  return viewBounds(view);
+}
@@ -1,6 +1,10 @@
 #include "EntityManager.hpp"
+#include "Profiler.hpp"
+#include "LevelGenerator.hpp"
+#include "FrameAllocator.hpp"
 
 #include <unordered_map>
+#include <chrono>
 #include <fstream>
 #include <string>
 #include <vector>
@@ -53,12 +57,21 @@ bool GraphicalEntity<S>::intersects(const sf::FloatRect &bounds) {
 };
 
 /**
- * Renders the graphical entity
- * @param window The render window
+ * Renders the graphical entity immediately
+ * @param target The render target
 */
 template <typename S>
-void GraphicalEntity<S>::render(sf::RenderWindow &window) { 
-  window.draw(graphic); 
+void GraphicalEntity<S>::render(sf::RenderTarget &target) { 
+  target.draw(graphic); 
+};
+
+/**
+ * Submits the graphical entity to be drawn in key order with the rest of the frame
+ * @param queue The render queue
+*/
+template <typename S>
+void GraphicalEntity<S>::submit(RenderQueue &queue) {
+  queue.submit(graphic, layer, depth, sequence);
 };
 
 template class GraphicalEntity<sf::Sprite>;
@@ -88,6 +101,8 @@ std::shared_ptr<Entity> EntityManager::getEntity(std::string id) {
  * Find and remove the player entity from the manager
 */
 void EntityManager::removePlayer() {
+  auto found = entities.find(playerKey);
+  if (found != entities.end() && found->second) markDirty(*found->second);
   entities.erase(playerKey);
   playerKey = "";
 }
@@ -97,6 +112,8 @@ void EntityManager::removePlayer() {
  * @param index The stored index of the entity to be removed
 */
 void EntityManager::removeEntity(std::string id) {
+  auto found = entities.find(id);
+  if (found != entities.end() && found->second) markDirty(*found->second);
   entities.erase(id); 
 };
 
@@ -112,32 +129,147 @@ int EntityManager::size() {
  * Updates all entities in the manager
 */
 void EntityManager::update() { 
+  PROFILE_SCOPE("EntityManager::update");
+  MEMORY_TAG(MemoryTag::Entities);
   for (auto it = entities.begin(); it != entities.end(); it++) 
     it->second->update(); 
 };
 
 /**
- * Renders all entities in the manager
- * @param window The render window
+ * Renders the entities within the target's current view
+ * @param target The render target
 */
-void EntityManager::render(sf::RenderWindow &window) { 
+void EntityManager::render(sf::RenderTarget &target) { 
+  sf::View view = target.getView();
+  render(target, view);
+};
+
+/**
+ * Renders the entities within a view, sorted by layer, depth, render states and creation order
+ * Note: Static layers are composited from their cache, re-rendering only the visible chunks marked dirty
+ * Note: Each camera renders through its own view, so entities are culled once per camera
+ * @param target The render target
+ * @param view The view rendered through, whose world area culls every entity outside it
+*/
+void EntityManager::render(sf::RenderTarget &target, const sf::View &view) { 
+  PROFILE_SCOPE("EntityManager::render");
+  MEMORY_TAG(MemoryTag::Entities);
+  // The visible list only lives for this call, so it comes from the frame arena
+  FrameArenaScope scratch;
+  std::pmr::vector<Entity*> visibleEntities(&scratch.get());
+  for (auto &entity : added) markDirty(*entity);
+  added.clear();
+  if (!reserved) reserveFrame();
+  visibleEntities.reserve(entities.size());
+
+  using Clock = std::chrono::steady_clock;
+  Clock::time_point start = Clock::now();
+  target.setView(view);
+  sf::FloatRect visible = viewBounds(view);
   for (auto it = entities.begin(); it != entities.end(); it++) 
-    it->second->render(window); 
-  
+    if (it->second && !staticLayers.count(it->second->getLayer()) && it->second->getBounds().intersects(visible))
+      visibleEntities.push_back(it->second.get());
+  Clock::time_point culled = Clock::now();
+
+  for (auto &pair : staticLayers) {
+    unsigned char layer = pair.first;
+    pair.second->update([&](const sf::FloatRect &region, RenderQueue &chunkQueue) {
+      for (auto &entity : entities)
+        if (entity.second && entity.second->getLayer() == layer && entity.second->getBounds().intersects(region))
+          entity.second->submit(chunkQueue);
+    }, &visible);
+    pair.second->submit(queue, layer, &visible);
+  }
+
+  for (Entity *entity : visibleEntities) entity->submit(queue);
+  Clock::time_point built = Clock::now();
+  queue.flush(target);
+
+  timings.cull = std::chrono::duration<double, std::milli>(culled - start).count();
+  timings.build = std::chrono::duration<double, std::milli>(built - culled).count();
+  timings.submit = std::chrono::duration<double, std::milli>(Clock::now() - built).count();
+  timings.visible = visibleEntities.size();
 };
 
+/**
+ * Sizes the render queue and this thread's frame arena for every entity being visible at once, so panning never allocates in a frame
+ * Note: Submits every drawn entity once to count its commands and vertices, so it only runs after entities are added or layers change
+*/
+void EntityManager::reserveFrame() {
+  for (auto &entity : entities)
+    if (entity.second && !staticLayers.count(entity.second->getLayer())) entity.second->submit(queue);
+  size_t chunks = 0;
+  for (auto &pair : staticLayers) chunks += pair.second->chunkCount();
+  size_t commands = queue.pendingCommands() + chunks, vertices = queue.pendingVertices() + chunks * 6;
+  queue.clear();
+  queue.reserve(commands, vertices);
+
+  // The visible list and the flush's two sort buffers, with room for the largest shape's points and outline
+  FrameArena::local().reserve(entities.size() * sizeof(Entity*) + commands * 2 * sizeof(RenderOrder::value_type) + FRAME_ARENA_INITIAL_SIZE);
+  reserved = true;
+}
+
+/**
+ * Marks a layer as static, caching it in render textures, or returns it to being drawn every frame
+ * @param layer The layer
+ * @param isStatic Whether the layer is cached
+*/
+void EntityManager::setLayerStatic(unsigned char layer, bool isStatic) {
+  MEMORY_TAG(MemoryTag::Entities);
+  reserved = false;
+  if (!isStatic) {
+    staticLayers.erase(layer);
+    return;
+  }
+  if (staticLayers.count(layer)) return;
+  auto cache = std::make_unique<StaticLayer>();
+  for (auto &entity : entities)
+    if (entity.second && entity.second->getLayer() == layer) cache->markDirty(entity.second->getBounds());
+  staticLayers[layer] = std::move(cache);
+}
+
+/**
+ * Marks an area of a static layer for re-rendering, needed whenever an entity within it moves or changes
+ * @param layer The layer
+ * @param region The world space area which changed
+*/
+void EntityManager::markDirty(unsigned char layer, const sf::FloatRect &region) {
+  auto found = staticLayers.find(layer);
+  if (found != staticLayers.end()) found->second->markDirty(region);
+}
+
+/**
+ * Marks the area an entity covers for re-rendering, if it is on a static layer
+ * @param entity The entity
+*/
+void EntityManager::markDirty(const Entity &entity) {
+  markDirty(entity.getLayer(), entity.getBounds());
+}
+
 /**
  * Adds entities at positions respective of a position file
- * @param filename The filename of the image being read
+ * @param filename The filename of the image or compiled .lvl level being read
  * @param pixelSize The scale factor for instantiated entities @def{32}
  * @param offset The offset origin to begin instantiating objects from @def{(0,0)}
- * @return A list of entities which have been added to the entity manager
- * 
- * TODO: Expand upon this implementation to account for indefinite instances
 */
 void EntityManager::addFromFile(const char* filename, float pixelSize, sf::Vector2f offset) {
+  MEMORY_TAG(MemoryTag::Level);
   sf::Image img;
-  img.loadFromFile(filename);
+  loadLevel(filename, img);
+  addFromImage(img, pixelSize, offset);
+}
+
+/**
+ * Adds entities at positions respective of the pixels of an already decoded image
+ * @param img The level image
+ * @param pixelSize The scale factor for instantiated entities @def{32}
+ * @param offset The offset origin to begin instantiating objects from @def{(0,0)}
+ * 
+ * TODO: Expand upon this implementation to account for indefinite instances
+*/
+void EntityManager::addFromImage(const sf::Image &img, float pixelSize, sf::Vector2f offset) {
+  PROFILE_SCOPE("EntityManager::addFromImage");
+  MEMORY_TAG(MemoryTag::Level);
   sf::Vector2u size = img.getSize();
   sf::Vector2f pos;
   std::string name;
@@ -169,19 +301,36 @@ void EntityManager::addFromFile(const char* filename, float pixelSize, sf::Vecto
         shape.setPosition(pos);
         std::snprintf(buffer, BUFFER_SIZE, "wall_%i\0", ++entityCount["wall"]);
         name.assign(buffer);
-        addEntity<GraphicalEntity<sf::RectangleShape>>(name, pos, shape);
+        addEntity<GraphicalEntity<sf::RectangleShape>>(name, pos, shape)->setLayer(WALL_LAYER);
 
       // Creates a player instance
       } else if (color == sf::Color::Blue) {
         sf::CircleShape circleShape(pixelSize / 2);
         circleShape.setFillColor(sf::Color::Blue);
         definePlayer("Player");
-        addEntity<GraphicalEntity<sf::CircleShape>>(playerKey, pos, circleShape);
+        addEntity<GraphicalEntity<sf::CircleShape>>(playerKey, pos, circleShape)->setLayer(PLAYER_LAYER);
+
+      // Creates a spawn instance, as marked by the level generator
+      } else if (color == sf::Color::Red) {
+        sf::CircleShape circleShape(pixelSize / 2);
+        circleShape.setFillColor(sf::Color::Red);
+        std::snprintf(buffer, BUFFER_SIZE, "spawn_%i", ++entityCount["spawn"]);
+        name.assign(buffer);
+        addEntity<GraphicalEntity<sf::CircleShape>>(name, pos, circleShape)->setLayer(SPAWN_LAYER);
       }
     }
   }
 }
 
+/**
+ * Returns the world area a view shows, including any rotation
+ * @param view The view
+ * @return The axis aligned bounds of the view
+*/
+sf::FloatRect viewBounds(const sf::View &view) {
+  return view.getInverseTransform().transformRect(sf::FloatRect(-1, -1, 2, 2));
+}
+
 /**
  * Destructs all existing entities
 */
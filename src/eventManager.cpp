@@ -1,6 +1,12 @@
 #include "Header.hpp"
 
-void manageEvents(sf::RenderWindow &window) {
+/**
+ * Handles the window's pending events
+ * @param window The window
+ * @param camera The camera zoomed by the mouse wheel and resized with the window, if any @def{nullptr}
+*/
+void manageEvents(sf::RenderWindow &window, Camera *camera) {
+  PROFILE_SCOPE("manageEvents");
   sf::Event event;
   int width, height;
   while (window.pollEvent(event))
@@ -18,37 +24,39 @@ void manageEvents(sf::RenderWindow &window) {
       case sf::Event::Resized:
         width = event.size.width;
         height = event.size.height;
-        std::cout << "New Window Size: (" << width << ", " << height << ")" << std::endl;
+        LOG_INFO(LogCategory::Window, "New Window Size: (%i, %i)", width, height);
+        if (camera) camera->resize(sf::Vector2f(width, height));
         break;
 
       case sf::Event::LostFocus:
-        std::cout << "Lost Focus" << std::endl;
+        LOG_INFO(LogCategory::Window, "Lost Focus");
         break;
 
       case sf::Event::GainedFocus:
-        std::cout << "Gained Focus" << std::endl;
+        LOG_INFO(LogCategory::Window, "Gained Focus");
         break;
 
       case sf::Event::MouseEntered:
-        std::cout << "Mouse Entered The Screen" << std::endl;
+        LOG_DEBUG(LogCategory::Input, "Mouse Entered The Screen");
         break;
 
       case sf::Event::MouseLeft:
-        std::cout << "Mouse Left The Screen" << std::endl;
+        LOG_DEBUG(LogCategory::Input, "Mouse Left The Screen");
         break;
 
       case sf::Event::TextEntered:
         if (event.text.unicode < 128)
-          std::cout << static_cast<char>(event.text.unicode);
+          LOG_DEBUG(LogCategory::Input, "Text Entered: %c", static_cast<char>(event.text.unicode));
         break;
 
       case sf::Event::MouseWheelScrolled:
-        std::cout << "New Mouse Position: (" << event.mouseWheelScroll.x << ", " << event.mouseWheelScroll.y << ")" << std::endl;
+        LOG_DEBUG(LogCategory::Input, "Mouse Wheel Scrolled At: (%i, %i)", event.mouseWheelScroll.x, event.mouseWheelScroll.y);
+        if (camera) camera->zoomBy(std::pow(0.9f, event.mouseWheelScroll.delta));
         break;
 
       case sf::Event::MouseButtonPressed:
         if (event.mouseButton.button == sf::Mouse::Right)
-          std::cout << "Mouse Pressed At: (" << event.mouseButton.x << ", " << event.mouseButton.y << ")" << std::endl;
+          LOG_INFO(LogCategory::Input, "Mouse Pressed At: (%i, %i)", event.mouseButton.x, event.mouseButton.y);
         break;
 
       case sf::Event::MouseMoved:
@@ -56,15 +64,15 @@ void manageEvents(sf::RenderWindow &window) {
 
       case sf::Event::JoystickMoved:
         if (event.joystickMove.axis == sf::Joystick::X)
-          std::cout << "Joystick " << event.joystickMove.joystickId << " moved to " << event.joystickMove.position << std::endl;
+          LOG_DEBUG(LogCategory::Input, "Joystick %u moved to %.1f", event.joystickMove.joystickId, event.joystickMove.position);
         break;
 
       case sf::Event::JoystickConnected:
-        std::cout << "Joystick " << event.joystickConnect.joystickId << " connected" << std::endl;
+        LOG_INFO(LogCategory::Input, "Joystick %u connected", event.joystickConnect.joystickId);
         break;
 
       case sf::Event::JoystickDisconnected:
-        std::cout << "Joystick " << event.joystickConnect.joystickId << " disconnected" << std::endl;
+        LOG_INFO(LogCategory::Input, "Joystick %u disconnected", event.joystickConnect.joystickId);
         break;
 
       default:
@@ -0,0 +1,67 @@
+#include "FrameAllocator.hpp"
+
+#include <algorithm>
+#include <cstdio>
+
+/**
+ * Returns the calling thread's arena
+ * @return The arena
+*/
+FrameArena& FrameArena::local() {
+  thread_local FrameArena arena;
+  return arena;
+}
+
+/**
+ * Takes memory from the arena, or from the heap when the arena is full
+ * @param bytes The bytes requested
+ * @param alignment The alignment required
+ * @return The memory
+*/
+void* FrameArena::do_allocate(std::size_t bytes, std::size_t alignment) {
+  if (!buffer) buffer = std::make_unique<char[]>(capacity);
+  std::uintptr_t base = (std::uintptr_t)buffer.get();
+  std::size_t start = ((base + offset + alignment - 1) & ~(std::uintptr_t)(alignment - 1)) - base;
+  if (start + bytes <= capacity) {
+    offset = start + bytes;
+    peak = std::max(peak, offset + overflowBytes);
+    return buffer.get() + start;
+  }
+
+  stats.overflows++;
+  overflowBytes += bytes + alignment;
+  peak = std::max(peak, offset + overflowBytes);
+  return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+}
+
+/**
+ * Returns memory to the heap if it overflowed there; memory within the arena is only reclaimed by a reset or rewind
+ * @param memory The memory
+ * @param bytes The bytes requested when allocated
+ * @param alignment The alignment requested when allocated
+*/
+void FrameArena::do_deallocate(void *memory, std::size_t bytes, std::size_t alignment) {
+  char *address = (char*)memory;
+  if (buffer && address >= buffer.get() && address < buffer.get() + capacity) return;
+  std::pmr::new_delete_resource()->deallocate(memory, bytes, alignment);
+}
+
+/**
+ * Ends the frame, emptying the arena and growing it if the frame overflowed or more was reserved
+ * Note: Nothing allocated from the arena may still be in use
+*/
+void FrameArena::reset() {
+  stats.frames++;
+  stats.framePeak = peak;
+  stats.highWater = std::max(stats.highWater, peak);
+  if (overflowBytes > 0 || reserved > capacity) {
+    std::size_t grown = capacity;
+    while (grown < std::max(peak, reserved)) grown *= 2;
+    if (overflowBytes > 0) std::fprintf(stderr, "Frame arena overflowed by %zu bytes, growing from %zu to %zu bytes\n", overflowBytes, capacity, grown);
+    capacity = stats.capacity = grown;
+    buffer = std::make_unique<char[]>(capacity);
+  }
+  offset = 0;
+  overflowBytes = 0;
+  peak = 0;
+}
@@ -0,0 +1,102 @@
+#include "FrameHistogram.hpp"
+#include "Logger.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+/**
+ * Counts the bits needed to hold a value
+ * @param value The value
+ * @return The position of its highest set bit plus one, or 0 for 0
+*/
+static int bitWidth(std::uint64_t value) {
+  int width = 0;
+  for (; value; value >>= 1) width++;
+  return width;
+}
+
+/**
+ * Returns the bucket a value falls in: values below the sub-bucket count have their own bucket,
+ * then each power of two above shares the upper half of the sub-buckets at a coarser step
+ * @param value The value in microseconds
+ * @return The bucket index
+*/
+int FrameHistogram::indexOf(std::uint64_t value) {
+  int shift = std::max(0, bitWidth(value) - bitWidth(HISTOGRAM_SUB_BUCKETS - 1));
+  return shift * (HISTOGRAM_SUB_BUCKETS / 2) + (int)(value >> shift);
+}
+
+/**
+ * Returns the largest value sharing a bucket
+ * @param index The bucket index
+ * @return The value in microseconds
+*/
+std::uint64_t FrameHistogram::highestOf(int index) {
+  int shift = index < HISTOGRAM_SUB_BUCKETS ? 0 : index / (HISTOGRAM_SUB_BUCKETS / 2) - 1;
+  std::uint64_t sub = index - shift * (HISTOGRAM_SUB_BUCKETS / 2);
+  return ((sub + 1) << shift) - 1;
+}
+
+/**
+ * Constructs an empty histogram
+ * @param budgetMs The frame time in milliseconds beyond which a frame counts as over budget @def{1000.0 / 60}
+*/
+FrameHistogram::FrameHistogram(double budgetMs) : counts(indexOf((std::uint64_t)HISTOGRAM_MAX_SECONDS * 1000000) + 1), budget(budgetMs) { }
+
+/**
+ * Records a frame
+ * @param milliseconds The frame time
+*/
+void FrameHistogram::record(double milliseconds) {
+  std::uint64_t value = std::min<std::uint64_t>(std::llround(std::max(0.0, milliseconds) * 1e3), (std::uint64_t)HISTOGRAM_MAX_SECONDS * 1000000);
+  counts[indexOf(value)]++;
+  total++;
+  sum += milliseconds;
+  maxMicroseconds = std::max(maxMicroseconds, value);
+  if (milliseconds > budget) overBudget++;
+}
+
+/**
+ * Adds another histogram's frames to this one, such as each second's into the session's
+ * @param other The histogram being added
+*/
+void FrameHistogram::merge(const FrameHistogram &other) {
+  for (size_t i = 0; i < counts.size(); i++) counts[i] += other.counts[i];
+  total += other.total;
+  overBudget += other.overBudget;
+  sum += other.sum;
+  maxMicroseconds = std::max(maxMicroseconds, other.maxMicroseconds);
+}
+
+/**
+ * Removes every recorded frame
+*/
+void FrameHistogram::reset() {
+  std::fill(counts.begin(), counts.end(), 0);
+  total = overBudget = maxMicroseconds = 0;
+  sum = 0;
+}
+
+/**
+ * Returns the frame time which a percentage of frames did not exceed, to within the histogram's precision
+ * @param percent The percentile, from 0 to 100
+ * @return The frame time in milliseconds
+*/
+double FrameHistogram::percentile(double percent) const {
+  if (total == 0) return 0;
+  std::uint64_t rank = std::max<std::uint64_t>(1, std::ceil(std::clamp(percent, 0.0, 100.0) / 100 * total)), seen = 0;
+  for (size_t i = 0; i < counts.size(); i++) {
+    seen += counts[i];
+    if (seen >= rank) return std::min(highestOf(i), maxMicroseconds) * 1e-3;
+  }
+  return getMax();
+}
+
+/**
+ * Logs the percentiles, maximum and over budget count on one line
+ * @param label The name logged before the figures
+*/
+void FrameHistogram::log(const char *label) const {
+  LOG_INFO(LogCategory::Performance, "%s: %llu frames, p50 %.2f ms, p90 %.2f ms, p99 %.2f ms, max %.2f ms, %llu over %.2f ms budget", label,
+           (unsigned long long)total, percentile(50), percentile(90), percentile(99), getMax(), (unsigned long long)overBudget, budget);
+}
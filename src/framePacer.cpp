@@ -0,0 +1,139 @@
+#include "FramePacer.hpp"
+#include "Profiler.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include <SFML/System.hpp>
+
+/**
+ * Returns the length of a duration in seconds
+ * @param duration The duration
+ * @return The number of seconds
+*/
+static double seconds(std::chrono::steady_clock::duration duration) {
+  return std::chrono::duration<double>(duration).count();
+}
+
+/**
+ * Constructs a frame pacer
+ * @param fps The target frame rate, or 0 for no limit @def{0}
+ * @param pacing How the pacer waits @def{PacingMode::Hybrid}
+*/
+FramePacer::FramePacer(double fps, PacingMode pacing) : mode(pacing), frameTimes(FRAME_HISTORY), workTimes(FRAME_HISTORY), spinTimes(FRAME_HISTORY), presentTimes(FRAME_HISTORY) {
+  frameStart = Clock::now();
+  setTargetFps(fps);
+}
+
+/**
+ * Sets the frame rate and restarts the schedule from now
+ * @param fps The target frame rate, or 0 for no limit
+*/
+void FramePacer::setTargetFps(double fps) {
+  period = fps > 0 ? std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1 / fps)) : Clock::duration::zero();
+  deadline = Clock::now() + period;
+}
+
+/**
+ * Folds the measured length of a sleep slice into the running estimate of the OS's sleep error
+ * Note: The sample count is capped so old measurements fade and the estimate adapts to the current load
+ * @param observed The real length of the slice in seconds
+*/
+void FramePacer::calibrate(double observed) {
+  sleepSamples = std::min(sleepSamples + 1, SLEEP_CALIBRATION_SAMPLES);
+  double delta = observed - sleepMean;
+  sleepMean += delta / sleepSamples;
+  sleepM2 += delta * (observed - sleepMean);
+  if (sleepSamples == SLEEP_CALIBRATION_SAMPLES) sleepM2 *= (double)(sleepSamples - 1) / sleepSamples;
+}
+
+/**
+ * Returns the pessimistic length of a sleep slice, one standard deviation above its mean
+ * @return The time in seconds a slice may take
+*/
+double FramePacer::getSleepError() const {
+  double variance = sleepSamples > 1 ? sleepM2 / (sleepSamples - 1) : 0;
+  return sleepMean + std::sqrt(variance);
+}
+
+/**
+ * Waits until the frame's deadline and records its timing
+ * Note: Deadlines advance by whole periods so rounding never drifts, but a late frame restarts the schedule rather than rushing the next frames to catch up
+*/
+void FramePacer::wait() {
+  PROFILE_SCOPE("FramePacer::wait");
+  Clock::time_point now = Clock::now();
+  double work = seconds(now - frameStart), spin = 0;
+
+  if (mode != PacingMode::Unlimited && period > Clock::duration::zero()) {
+    if (now >= deadline) {
+      deadline = now + period;
+    } else if (mode == PacingMode::Sleep) {
+      sf::sleep(sf::microseconds(std::chrono::duration_cast<std::chrono::microseconds>(deadline - now).count()));
+      deadline += period;
+    } else {
+      // Sleep in short slices while even a slow slice would wake before the deadline, then spin the remainder
+      while (seconds(deadline - now) > getSleepError()) {
+        sf::sleep(sf::milliseconds(SLEEP_SLICE_MS));
+        Clock::time_point woke = Clock::now();
+        // Slices longer than a frame were preempted rather than overslept, and would inflate the estimate
+        if (woke - now < period) calibrate(seconds(woke - now));
+        now = woke;
+      }
+      Clock::time_point spinStart = now;
+      while (now < deadline) now = Clock::now();
+      spin = seconds(now - spinStart);
+      deadline += period;
+    }
+  }
+
+  now = Clock::now();
+  frameTimes[next] = seconds(now - frameStart) * 1e3;
+  workTimes[next] = work * 1e3;
+  spinTimes[next] = spin * 1e3;
+  presentTimes[next] = 0;
+  next = (next + 1) % FRAME_HISTORY;
+  recorded = std::min(recorded + 1, (size_t)FRAME_HISTORY);
+  frameStart = now;
+}
+
+/**
+ * Waits until the frame's deadline then displays the window, so frames are presented on schedule
+ * @param window The window being presented
+*/
+void FramePacer::present(sf::RenderWindow &window) {
+  wait();
+  PROFILE_SCOPE("window.display");
+  Clock::time_point start = Clock::now();
+  window.display();
+  presentTimes[(next + FRAME_HISTORY - 1) % FRAME_HISTORY] = seconds(Clock::now() - start) * 1e3;
+}
+
+/**
+ * Summarises the recorded frames
+ * Note: A frame's presentation is counted within the following frame's time and work
+ * @return The frame time statistics
+*/
+FrameStats FramePacer::getStats() const {
+  FrameStats stats;
+  stats.frames = recorded;
+  if (recorded == 0) return stats;
+  stats.min = stats.max = frameTimes[0];
+  double sum = 0, squares = 0;
+  for (size_t i = 0; i < recorded; i++) {
+    double frame = frameTimes[i];
+    sum += frame;
+    squares += frame * frame;
+    stats.min = std::min(stats.min, frame);
+    stats.max = std::max(stats.max, frame);
+    stats.work += workTimes[i];
+    stats.spin += spinTimes[i];
+    stats.present += presentTimes[i];
+  }
+  stats.mean = sum / recorded;
+  stats.deviation = std::sqrt(std::max(0.0, squares / recorded - stats.mean * stats.mean));
+  stats.work /= recorded;
+  stats.spin /= recorded;
+  stats.present /= recorded;
+  return stats;
+}
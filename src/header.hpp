@@ -4,6 +4,9 @@
 #include <unordered_map>
 #include <iostream>
 #include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <cmath>
 #include <vector>
 #include <memory>
 
@@ -11,9 +14,30 @@
 #include <SFML/Window.hpp>
 
 #include "Mesh.hpp"
+#include "RenderQueue.hpp"
+#include "StaticLayer.hpp"
 #include "EntityManager.hpp"
+#include "Benchmark.hpp"
+#include "Impostor.hpp"
+#include "BitmapFont.hpp"
+#include "Hud.hpp"
+#include "ParticleSystem.hpp"
+#include "Visibility.hpp"
+#include "Camera.hpp"
+#include "FramePacer.hpp"
+#include "FrameHistogram.hpp"
+#include "Headless.hpp"
+#include "Regression.hpp"
+#include "LevelGenerator.hpp"
+#include "MemoryTracker.hpp"
+#include "FrameAllocator.hpp"
+#include "Profiler.hpp"
+#include "AssetArchive.hpp"
+#include "AssetLoader.hpp"
+#include "AssetCache.hpp"
+#include "Logger.hpp"
 
 // Declare functions
-void manageEvents(sf::RenderWindow &window);
+void manageEvents(sf::RenderWindow &window, Camera *camera=nullptr);
 
 #endif
\ No newline at end of file
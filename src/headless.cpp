@@ -0,0 +1,256 @@
+#include "Headless.hpp"
+#include "EntityManager.hpp"
+#include "FrameHistogram.hpp"
+#include "LevelGenerator.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+
+#define SYNTHETIC_SPACING 48
+
+/**
+ * Reads the options following --headless
+ * Options: --entities N, --level <image or .lvl>, --random-level N, --ticks N, --frames N, --offscreen, --size W H, --seed N,
+ * --assert-no-alloc, --trap-alloc, --warmup N
+ * @param argc The argument count
+ * @param argv The arguments, starting with the program and --headless
+ * @return The settings
+*/
+HeadlessSettings parseHeadlessArgs(int argc, char *argv[]) {
+  HeadlessSettings settings;
+  for (int i = 2; i < argc; i++) {
+    bool value = i + 1 < argc;
+    if (std::strcmp(argv[i], "--entities") == 0 && value) settings.entities = std::atoi(argv[++i]);
+    else if (std::strcmp(argv[i], "--level") == 0 && value) settings.level = argv[++i];
+    else if (std::strcmp(argv[i], "--random-level") == 0 && value) settings.randomLevel = std::atoi(argv[++i]);
+    else if (std::strcmp(argv[i], "--ticks") == 0 && value) settings.ticks = std::atoi(argv[++i]);
+    else if (std::strcmp(argv[i], "--frames") == 0 && value) settings.frames = std::atoi(argv[++i]);
+    else if (std::strcmp(argv[i], "--seed") == 0 && value) settings.seed = std::atoi(argv[++i]);
+    else if (std::strcmp(argv[i], "--warmup") == 0 && value) settings.warmup = std::atoi(argv[++i]);
+    else if (std::strcmp(argv[i], "--offscreen") == 0) settings.offscreen = true;
+    else if (std::strcmp(argv[i], "--assert-no-alloc") == 0) settings.guard = AllocationGuardMode::Report;
+    else if (std::strcmp(argv[i], "--trap-alloc") == 0) settings.guard = AllocationGuardMode::Trap;
+    else if (std::strcmp(argv[i], "--size") == 0 && i + 2 < argc) {
+      settings.width = std::atoi(argv[++i]);
+      settings.height = std::atoi(argv[++i]);
+    } else {
+      std::fprintf(stderr, "Unknown headless option: *%s*\n", argv[i]);
+    }
+  }
+  return settings;
+}
+
+/**
+ * Scatters walls and circles uniformly over a square sized to keep their density constant
+ * Note: Every fourth entity is a circle on the player layer, the rest are walls on the wall layer
+ * @param entityManager The manager being filled
+ * @param count The number of entities added
+ * @param seed The seed of their positions
+ * @return The world area the entities cover
+*/
+sf::FloatRect addSyntheticEntities(EntityManager &entityManager, int count, unsigned int seed) {
+  std::mt19937 rng(seed);
+  float side = std::ceil(std::sqrt((float)count)) * SYNTHETIC_SPACING;
+  std::uniform_real_distribution<float> coordinate(0, side);
+  sf::RectangleShape wall(sf::Vector2f(32, 32));
+  wall.setFillColor(sf::Color::Black);
+  wall.setOutlineThickness(1);
+  wall.setOutlineColor(sf::Color::White);
+  sf::CircleShape circle(16);
+  circle.setFillColor(sf::Color::Blue);
+  for (int i = 0; i < count; i++) {
+    sf::Vector2f pos(coordinate(rng), coordinate(rng));
+    std::string name = "entity_" + std::to_string(i);
+    if (i % 4 == 0) entityManager.addEntity<GraphicalEntity<sf::CircleShape>>(name, pos, circle)->setLayer(PLAYER_LAYER);
+    else entityManager.addEntity<GraphicalEntity<sf::RectangleShape>>(name, pos, wall)->setLayer(WALL_LAYER);
+  }
+  return sf::FloatRect(0, 0, side, side);
+}
+
+/**
+ * Fills the manager with the run's scene: a level image, a random level, or synthetic entities
+ * @param entityManager The manager being filled
+ * @param settings The run's settings
+ * @param world Set to the world area the scene covers
+ * @return Whether the scene was built, which fails if the level cannot be loaded
+*/
+static bool buildScene(EntityManager &entityManager, const HeadlessSettings &settings, sf::FloatRect &world) {
+  if (settings.level || settings.randomLevel > 0) {
+    sf::Image level;
+    if (settings.level) {
+      if (!loadLevel(settings.level, level)) {
+        std::fprintf(stderr, "Failed to load level: *%s*\n", settings.level);
+        return false;
+      }
+    } else {
+      LevelSettings random;
+      random.width = random.height = settings.randomLevel;
+      random.pattern = LevelPattern::Noise;
+      random.density = 0.15f;
+      random.seed = settings.seed;
+      level = toImage(generateLevel(random));
+    }
+    entityManager.addFromImage(level);
+    world = sf::FloatRect(0, 0, level.getSize().x * 32.f, level.getSize().y * 32.f);
+    return true;
+  }
+  world = addSyntheticEntities(entityManager, settings.entities, settings.seed);
+  return true;
+}
+
+/**
+ * Prints a phase's timings as a JSON object
+ * @param name The phase
+ * @param phase The histogram of the phase's times
+ * @param last Whether this is the last phase printed
+*/
+static void printPhase(const char *name, const FrameHistogram &phase, bool last) {
+  std::printf("    \"%s\": {\"count\": %llu, \"mean\": %.4f, \"p50\": %.4f, \"p90\": %.4f, \"p99\": %.4f, \"max\": %.4f}%s\n",
+              name, (unsigned long long)phase.getCount(), phase.getMean(), phase.percentile(50), phase.percentile(90),
+              phase.percentile(99), phase.getMax(), last ? "" : ",");
+}
+
+/**
+ * Runs the entity manager without a window, timing a fixed number of ticks and frames
+ * Note: The view pans over the whole scene so culling sees a changing set of entities, identically on every run
+ * Note: With an allocation guard, each frame after the warm-up is guarded against heap allocations on this thread
+ * @param settings The run's settings
+ * @return The timings
+*/
+HeadlessReport measureHeadless(const HeadlessSettings &settings) {
+  using Clock = std::chrono::steady_clock;
+  HeadlessReport report;
+  EntityManager entityManager;
+
+  // Static layers cache into render textures, which need a GL context
+  sf::RenderTexture texture;
+  bool offscreen = report.offscreen = settings.offscreen && texture.create(settings.width, settings.height);
+  if (settings.offscreen && !offscreen) std::fprintf(stderr, "No GL context for an offscreen target, using the null target\n");
+  if (offscreen) entityManager.setLayerStatic(WALL_LAYER, true);
+  NullRenderTarget nullTarget(settings.width, settings.height);
+  sf::RenderTarget &target = offscreen ? (sf::RenderTarget&)texture : (sf::RenderTarget&)nullTarget;
+
+  Clock::time_point start = Clock::now();
+  if (!buildScene(entityManager, settings, report.world)) {
+    report.loaded = false;
+    return report;
+  }
+  sf::FloatRect world = report.world;
+  report.loadMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+  FrameHistogram &update = report.update, &cull = report.cull, &build = report.build;
+  FrameHistogram &submit = report.submit, &present = report.present, &frame = report.frame;
+  long long visible = 0;
+  AllocationGuardMode previousGuard = getAllocationGuard();
+  setAllocationGuard(settings.guard);
+  endMemoryFrame();
+  sf::View view(sf::FloatRect(0, 0, settings.width, settings.height));
+  int iterations = std::max(settings.ticks, settings.frames);
+  for (int i = 0; i < iterations; i++) {
+    bool guardFrame = settings.guard != AllocationGuardMode::Off && i >= settings.warmup;
+    if (guardFrame) beginGuardedFrame();
+    Clock::time_point frameStart = Clock::now();
+    if (i < settings.ticks) {
+      entityManager.update();
+      update.record(std::chrono::duration<double, std::milli>(Clock::now() - frameStart).count());
+    }
+    if (i < settings.frames) {
+      float t = (float)i / std::max(1, settings.frames);
+      view.setCenter(world.left + world.width * (0.5f + 0.5f * std::sin(6.2831853f * t)),
+                     world.top + world.height * (0.5f + 0.5f * std::sin(6.2831853f * 2 * t)));
+      target.clear();
+      entityManager.render(target, view);
+      const RenderTimings &timings = entityManager.getRenderTimings();
+      cull.record(timings.cull);
+      build.record(timings.build);
+      submit.record(timings.submit);
+      visible += timings.visible;
+
+      Clock::time_point presentStart = Clock::now();
+      if (offscreen) texture.display();
+      present.record(std::chrono::duration<double, std::milli>(Clock::now() - presentStart).count());
+    }
+    frame.record(std::chrono::duration<double, std::milli>(Clock::now() - frameStart).count());
+    if (guardFrame) {
+      std::uint64_t allocated = endGuardedFrame();
+      report.guardedFrames++;
+      report.guardedAllocations += allocated;
+      report.allocatingFrames += allocated > 0;
+    }
+    FrameArena::local().reset();
+    FrameAllocations allocations = endMemoryFrame();
+    report.frameAllocations += allocations.allocations;
+    report.frameBytes += allocations.bytes;
+    report.maxFrameAllocations = std::max(report.maxFrameAllocations, allocations.allocations);
+  }
+  setAllocationGuard(previousGuard);
+
+  const RenderQueue &queue = entityManager.getRenderQueue();
+  report.entities = entityManager.size();
+  report.meanVisible = settings.frames > 0 ? (double)visible / settings.frames : 0.0;
+  report.drawCalls = queue.getDrawCalls();
+  report.commands = queue.getCommandCount();
+  for (int tag = 0; tag <= (int)MemoryTag::Count; tag++) report.memory[tag] = getMemoryStats((MemoryTag)tag);
+  report.arena = FrameArena::local().getStats();
+  return report;
+}
+
+/**
+ * Runs the entity manager without a window and prints the timings as JSON
+ * Note: With --assert-no-alloc, any heap allocation in a frame after the warm-up fails the run, printing each call site's stack to stderr
+ * @param settings The run's settings
+ * @return The process exit code: 1 if the level could not be loaded or a guarded frame allocated, 2 if the guard was requested without memory tracking
+*/
+int runHeadless(const HeadlessSettings &settings) {
+  if (settings.guard != AllocationGuardMode::Off && !memoryTrackingEnabled()) {
+    std::fprintf(stderr, "Allocation guards need memory tracking, build with -DENABLE_MEMORY_TRACKING\n");
+    return 2;
+  }
+  HeadlessReport report = measureHeadless(settings);
+  if (!report.loaded) return 1;
+  std::printf("{\n  \"target\": \"%s\",\n  \"entities\": %i,\n  \"world\": [%.0f, %.0f],\n", report.offscreen ? "offscreen" : "null", report.entities,
+              report.world.width, report.world.height);
+  std::printf("  \"ticks\": %i,\n  \"frames\": %i,\n  \"load_ms\": %.3f,\n", settings.ticks, settings.frames, report.loadMs);
+  std::printf("  \"mean_visible\": %.1f,\n  \"draw_calls\": %i,\n  \"commands\": %i,\n", report.meanVisible, report.drawCalls, report.commands);
+  std::printf("  \"frame_arena\": {\"capacity\": %zu, \"high_water\": %zu, \"overflows\": %llu},\n", report.arena.capacity,
+              report.arena.highWater, (unsigned long long)report.arena.overflows);
+  std::printf("  \"phases_ms\": {\n");
+  printPhase("update", report.update, false);
+  printPhase("cull", report.cull, false);
+  printPhase("build", report.build, false);
+  printPhase("submit", report.submit, false);
+  printPhase("present", report.present, false);
+  printPhase("frame", report.frame, true);
+  std::printf("  },\n");
+
+  int iterations = std::max(1, std::max(settings.ticks, settings.frames));
+  std::printf("  \"memory\": {\n    \"tracked\": %s,\n", memoryTrackingEnabled() ? "true" : "false");
+  std::printf("    \"frame_allocations\": {\"mean\": %.2f, \"max\": %llu, \"bytes_mean\": %.1f},\n", (double)report.frameAllocations / iterations,
+              (unsigned long long)report.maxFrameAllocations, (double)report.frameBytes / iterations);
+  if (settings.guard != AllocationGuardMode::Off)
+    std::printf("    \"guarded\": {\"frames\": %i, \"allocating_frames\": %i, \"allocations\": %llu},\n", report.guardedFrames,
+                report.allocatingFrames, (unsigned long long)report.guardedAllocations);
+  std::printf("    \"tags\": {\n");
+  for (int tag = 0; tag <= (int)MemoryTag::Count; tag++) {
+    const MemoryStats &stats = report.memory[tag];
+    std::printf("      \"%s\": {\"live_bytes\": %lld, \"live_allocations\": %lld, \"peak_bytes\": %lld, \"allocations\": %llu}%s\n",
+                memoryTagName((MemoryTag)tag), (long long)stats.liveBytes, (long long)stats.liveAllocations, (long long)stats.peakBytes,
+                (unsigned long long)stats.allocations, tag < (int)MemoryTag::Count ? "," : "");
+  }
+  std::printf("    }\n  }\n}\n");
+
+  if (settings.guard == AllocationGuardMode::Off) return 0;
+  if (report.guardedFrames == 0) {
+    std::fprintf(stderr, "No frames were guarded, run more than the %i warm-up frames\n", settings.warmup);
+    return 2;
+  }
+  if (report.guardedAllocations == 0) return 0;
+  printAllocationSites();
+  return 1;
+}
@@ -0,0 +1,179 @@
+#include "Hud.hpp"
+#include "Profiler.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+
+/**
+ * Constructs a line of text
+ * @param pos The pen position of the first character on the baseline
+ * @param maxLength The most characters the text can hold @def{32}
+ * @param textColor The text colour @def{sf::Color::White}
+*/
+HudText::HudText(sf::Vector2f pos, size_t maxLength, sf::Color textColor) : position(pos), color(textColor), capacity(maxLength) {
+  text.reserve(capacity);
+}
+
+/**
+ * Draws the text, adding its glyphs on the first render and replacing them afterwards
+ * @param target The HUD texture
+ * @param font The font the glyphs are drawn from
+*/
+void HudText::render(sf::RenderTarget &target, const BitmapFont &font) {
+  batch.setFont(font);
+  if (batch.getGlyphCount() == 0) batch.add(text, position, color, capacity);
+  else batch.set(0, text);
+  target.draw(batch);
+
+  // Covers the tallest glyphs above the baseline and the descenders below it
+  float size = font.getCharacterSize();
+  bounds = sf::FloatRect(position.x, position.y - size, font.measure(text) + 1, font.getLineSpacing());
+}
+
+/**
+ * Changes the text, marking the widget dirty only if it differs
+ * @param value The new text, truncated to the widget's capacity
+*/
+void HudText::setText(const char *value) {
+  size_t length = std::min(std::strlen(value), capacity);
+  if (text.compare(0, std::string::npos, value, length) == 0) return;
+  text.assign(value, length);
+  dirty = true;
+}
+
+/**
+ * Changes the text to a label followed by a number, without allocating
+ * @param label The text before the number
+ * @param value The number shown
+*/
+void HudText::setNumber(const char *label, long long value) {
+  char buffer[64];
+  size_t length = std::min(std::strlen(label), sizeof(buffer) - 24);
+  std::memcpy(buffer, label, length);
+  *std::to_chars(buffer + length, buffer + sizeof(buffer) - 1, value).ptr = '\0';
+  setText(buffer);
+}
+
+/**
+ * Constructs a bar
+ * @param rect The area of the bar
+ * @param fillColor The colour of the filled part @def{sf::Color::Green}
+ * @param backgroundColor The colour of the empty part @def{sf::Color(0, 0, 0, 128)}
+*/
+HudBar::HudBar(sf::FloatRect rect, sf::Color fillColor, sf::Color backgroundColor)
+  : area(rect), fill(fillColor), background(backgroundColor), backdrop(sf::Vector2f(rect.width, rect.height)), bar(sf::Vector2f(0, rect.height)) {
+  backdrop.setPosition(area.left, area.top);
+  backdrop.setFillColor(background);
+  bar.setPosition(area.left, area.top);
+  bar.setFillColor(fill);
+}
+
+/**
+ * Draws the background, then the filled part over it
+ * @param target The HUD texture
+*/
+void HudBar::render(sf::RenderTarget &target, const BitmapFont& /*font*/) {
+  bar.setSize(sf::Vector2f(area.width * value, area.height));
+  target.draw(backdrop);
+  target.draw(bar);
+  bounds = area;
+}
+
+/**
+ * Changes the filled proportion, marking the widget dirty only if the fill moves by a whole pixel
+ * @param fraction The proportion filled, clamped between 0 and 1
+*/
+void HudBar::setValue(float fraction) {
+  fraction = std::clamp(fraction, 0.f, 1.f);
+  if ((int)(fraction * area.width) != (int)(value * area.width)) dirty = true;
+  value = fraction;
+}
+
+/**
+ * Constructs a graph
+ * @param rect The area of the graph
+ * @param sampleCount The number of samples shown across its width
+ * @param minValue The value drawn along the bottom edge
+ * @param maxValue The value drawn along the top edge
+ * @param lineColor The colour of the line @def{sf::Color::Yellow}
+*/
+HudGraph::HudGraph(sf::FloatRect rect, size_t sampleCount, float minValue, float maxValue, sf::Color lineColor)
+  : area(rect), color(lineColor), samples(std::max<size_t>(sampleCount, 2)), minimum(minValue), maximum(maxValue),
+    backdrop(sf::Vector2f(rect.width, rect.height)), line(sf::LineStrip) {
+  backdrop.setPosition(area.left, area.top);
+  backdrop.setFillColor(sf::Color(0, 0, 0, 128));
+}
+
+/**
+ * Draws the backdrop and the line built when the last sample was pushed
+ * @param target The HUD texture
+*/
+void HudGraph::render(sf::RenderTarget &target, const BitmapFont& /*font*/) {
+  target.draw(backdrop);
+  target.draw(line);
+  bounds = area;
+}
+
+/**
+ * Appends a sample, dropping the oldest once the graph is full, and rebuilds the line
+ * @param sample The value being added
+*/
+void HudGraph::push(float sample) {
+  samples[next] = sample;
+  next = (next + 1) % samples.size();
+  count = std::min(count + 1, samples.size());
+  dirty = true;
+
+  // Oldest sample on the left, values outside the range are clamped to the edges
+  line.resize(count);
+  float step = area.width / (samples.size() - 1);
+  for (size_t i = 0; i < count; i++) {
+    float value = samples[(next + samples.size() - count + i) % samples.size()];
+    float height = std::clamp((value - minimum) / (maximum - minimum), 0.f, 1.f) * area.height;
+    line[i] = sf::Vertex(sf::Vector2f(area.left + (samples.size() - count + i) * step, area.top + area.height - height), color);
+  }
+}
+
+/**
+ * Creates the cached texture the widgets are rendered into
+ * @param width The width of the overlay in pixels
+ * @param height The height of the overlay in pixels
+ * @return Whether the texture was created
+*/
+bool Hud::create(unsigned int width, unsigned int height) {
+  if (!target.create(width, height)) return false;
+  target.clear(sf::Color::Transparent);
+  target.display();
+  sprite.setTexture(target.getTexture(), true);
+  eraser.setFillColor(sf::Color::Transparent);
+  for (auto &widget : widgets) widget->markDirty();
+  return true;
+}
+
+/**
+ * Re-renders the widgets which changed since the last update
+ * @return The number of widgets re-rendered
+*/
+int Hud::update() {
+  PROFILE_SCOPE("Hud::update");
+  if (!font) return 0;
+  int rendered = 0;
+  for (auto &widget : widgets) {
+    if (!widget->isDirty()) continue;
+    // Replacing rather than blending clears the area the widget last covered back to transparent
+    const sf::FloatRect &previous = widget->getBounds();
+    eraser.setPosition(previous.left, previous.top);
+    eraser.setSize(sf::Vector2f(previous.width, previous.height));
+    target.draw(eraser, sf::BlendNone);
+    widget->render(target, *font);
+    widget->markClean();
+    rendered++;
+  }
+  if (rendered) target.display();
+  return rendered;
+}
+
+void Hud::draw(sf::RenderTarget &window, sf::RenderStates states) const {
+  window.draw(sprite, states);
+}
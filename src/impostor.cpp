@@ -0,0 +1,217 @@
+#include "Impostor.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <SFML/Graphics.hpp>
+
+#define TWO_PI 6.28318531f
+#define AMBIENT_LIGHT 0.35f
+
+/**
+ * Rasterises one frame of the mesh into a supersampled colour and depth buffer
+ * Note: Triangles are flat shaded with a fixed light, and drawn two sided since .obj winding varies
+ * @param mesh The mesh being drawn
+ * @param level The level of detail drawn, where 0 is the full detail mesh
+ * @param modelView The rotation and centring applied to the mesh
+ * @param mvp The model-view-projection matrix
+ * @param settings The baking settings
+ * @param size The width and height of the buffers in samples
+ * @param colour The RGBA sample buffer being written
+*/
+static void rasterise(const Mesh &mesh, int level, const Matrix4 &modelView, const Matrix4 &mvp, const ImpostorSettings &settings,
+                      int size, std::vector<float> &colour) {
+  const LODLevel *lod = level > 0 ? &mesh.getLOD(level) : nullptr;
+  ScreenVertices screen;
+  transformVertices(lod ? lod->stream : mesh.getVertexStream(), mvp, Viewport(size, size), screen);
+  std::vector<float> depth(size * size, 1e30f);
+  std::fill(colour.begin(), colour.end(), 0.f);
+
+  const std::vector<Point> &points = lod ? lod->vertices : mesh.getVertices();
+  const std::vector<unsigned int> &triangles = lod ? lod->triangles : mesh.getTriangles();
+  const float *m = modelView.m;
+  float light[3] = {-0.4f, 0.6f, 0.7f};
+  float lightLength = std::sqrt(light[0]*light[0] + light[1]*light[1] + light[2]*light[2]);
+
+  for (size_t t = 0; t + 2 < triangles.size(); t += 3) {
+    unsigned int a = triangles[t], b = triangles[t + 1], c = triangles[t + 2];
+
+    // Shade from the face normal rotated into view space
+    const Point &pa = points[a], &pb = points[b], &pc = points[c];
+    float e1[3] = {pb.x - pa.x, pb.y - pa.y, pb.z - pa.z}, e2[3] = {pc.x - pa.x, pc.y - pa.y, pc.z - pa.z};
+    float n[3] = {e1[1]*e2[2] - e1[2]*e2[1], e1[2]*e2[0] - e1[0]*e2[2], e1[0]*e2[1] - e1[1]*e2[0]};
+    float view[3] = {
+      m[0]*n[0] + m[1]*n[1] + m[2]*n[2], m[4]*n[0] + m[5]*n[1] + m[6]*n[2], m[8]*n[0] + m[9]*n[1] + m[10]*n[2]
+    };
+    float length = std::sqrt(view[0]*view[0] + view[1]*view[1] + view[2]*view[2]);
+    if (length == 0) continue;
+    float diffuse = std::fabs(view[0]*light[0] + view[1]*light[1] + view[2]*light[2]) / (length * lightLength);
+    float shade = AMBIENT_LIGHT + (1 - AMBIENT_LIGHT) * diffuse;
+
+    float x0 = screen.x[a], y0 = screen.y[a], x1 = screen.x[b], y1 = screen.y[b], x2 = screen.x[c], y2 = screen.y[c];
+    float area = (x1 - x0) * (y2 - y0) - (x2 - x0) * (y1 - y0);
+    if (std::fabs(area) < 1e-8f) continue;
+    int minX = std::max(0, (int)std::floor(std::min({x0, x1, x2})));
+    int maxX = std::min(size - 1, (int)std::ceil(std::max({x0, x1, x2})));
+    int minY = std::max(0, (int)std::floor(std::min({y0, y1, y2})));
+    int maxY = std::min(size - 1, (int)std::ceil(std::max({y0, y1, y2})));
+
+    // Edge functions evaluated at sample centres, normalised so either winding is inside
+    for (int y = minY; y <= maxY; y++) {
+      for (int x = minX; x <= maxX; x++) {
+        float px = x + 0.5f, py = y + 0.5f;
+        float w0 = ((x1 - px) * (y2 - py) - (x2 - px) * (y1 - py)) / area;
+        float w1 = ((x2 - px) * (y0 - py) - (x0 - px) * (y2 - py)) / area;
+        float w2 = 1 - w0 - w1;
+        if (w0 < 0 || w1 < 0 || w2 < 0) continue;
+        float z = w0 * screen.depth[a] + w1 * screen.depth[b] + w2 * screen.depth[c];
+        int index = y * size + x;
+        if (z >= depth[index]) continue;
+        depth[index] = z;
+        float *sample = &colour[index * 4];
+        sample[0] = settings.color.r * shade;
+        sample[1] = settings.color.g * shade;
+        sample[2] = settings.color.b * shade;
+        sample[3] = 255;
+      }
+    }
+  }
+}
+
+/**
+ * Renders the mesh from every yaw angle on the CPU and packs the frames into a square grid
+ * @param mesh The mesh being baked
+ * @param settings The baking settings @def{ImpostorSettings()}
+*/
+void ImpostorAtlas::bake(const Mesh &mesh, const ImpostorSettings &settings) {
+  int columns = std::ceil(std::sqrt((float)settings.frames));
+  int rows = (settings.frames + columns - 1) / columns;
+  int samples = settings.frameSize * settings.supersample;
+  image.create(columns * settings.frameSize, rows * settings.frameSize, sf::Color::Transparent);
+  frames.clear();
+
+  // An orthographic volume around the bounding sphere keeps every angle the same scale
+  const Point &center = mesh.getBoundsCenter();
+  float radius = std::max(mesh.getBoundsRadius(), 1e-6f);
+  Matrix4 projection = Matrix4::orthographic(-radius, radius, -radius, radius, -radius, radius);
+  std::vector<float> colour(samples * samples * 4);
+  float weight = 1.f / (settings.supersample * settings.supersample);
+  int level = std::min(std::max(settings.lod, 0), std::max(mesh.getLODCount() - 1, 0));
+
+  for (int frame = 0; frame < settings.frames; frame++) {
+    float yaw = TWO_PI * frame / settings.frames;
+    Matrix4 modelView = Matrix4::rotationX(settings.pitch) * Matrix4::rotationY(-yaw)
+                      * Matrix4::translation(-center.x, -center.y, -center.z);
+    rasterise(mesh, level, modelView, projection * modelView, settings, samples, colour);
+
+    // Average each block of samples down into a pixel of the atlas
+    sf::IntRect rect((frame % columns) * settings.frameSize, (frame / columns) * settings.frameSize, settings.frameSize, settings.frameSize);
+    for (int y = 0; y < settings.frameSize; y++) {
+      for (int x = 0; x < settings.frameSize; x++) {
+        float sum[4] = {0, 0, 0, 0};
+        for (int sy = 0; sy < settings.supersample; sy++) {
+          for (int sx = 0; sx < settings.supersample; sx++) {
+            const float *sample = &colour[((y * settings.supersample + sy) * samples + x * settings.supersample + sx) * 4];
+            for (int channel = 0; channel < 4; channel++) sum[channel] += sample[channel];
+          }
+        }
+        // Colour is averaged over covered samples only so edges fade out rather than darken
+        float coverage = sum[3] / 255;
+        if (coverage == 0) continue;
+        image.setPixel(rect.left + x, rect.top + y, sf::Color(sum[0] / coverage, sum[1] / coverage, sum[2] / coverage, sum[3] * weight));
+      }
+    }
+    frames.push_back(rect);
+  }
+}
+
+/**
+ * Saves the atlas image alongside a metadata file listing each frame rectangle
+ * @param filename The image path; the metadata is written to the same path with .txt appended
+ * @return Whether both files were written
+*/
+bool ImpostorAtlas::saveToFile(const std::string &filename) const {
+  if (!image.saveToFile(filename)) return false;
+  std::ofstream file(filename + ".txt");
+  if (!file) return false;
+  file << frames.size() << "\n";
+  for (auto &rect : frames) file << rect.left << " " << rect.top << " " << rect.width << " " << rect.height << "\n";
+  return true;
+}
+
+/**
+ * Loads an atlas image and its metadata, then uploads the texture
+ * @param filename The image path as given to saveToFile
+ * @return Whether the atlas was loaded
+*/
+bool ImpostorAtlas::loadFromFile(const std::string &filename) {
+  std::ifstream file(filename + ".txt");
+  size_t count = 0;
+  if (!file || !(file >> count) || !image.loadFromFile(filename)) return false;
+  frames.clear();
+  for (size_t i = 0; i < count; i++) {
+    sf::IntRect rect;
+    if (!(file >> rect.left >> rect.top >> rect.width >> rect.height)) return false;
+    frames.push_back(rect);
+  }
+  return upload();
+}
+
+/**
+ * Finds the frame baked nearest to a facing
+ * @param facing The yaw in radians, matching the angles the frames were baked at
+ * @return The frame index
+*/
+int ImpostorAtlas::frameFor(float facing) const {
+  if (frames.empty()) return 0;
+  int count = frames.size();
+  int frame = (int)std::lround(facing / TWO_PI * count) % count;
+  return frame < 0 ? frame + count : frame;
+}
+
+/**
+ * Constructs an impostor sprite showing the first frame of an atlas
+ * @param id The unique identifier for the entity
+ * @param pos The 2D position vector
+ * @param impostors The baked atlas, which must outlive the entity and have been uploaded
+*/
+ImpostorEntity::ImpostorEntity(std::string id, sf::Vector2f pos, const ImpostorAtlas &impostors)
+  : GraphicalEntity<sf::Sprite>(id, pos, sf::Sprite(impostors.getTexture(), impostors.getFrame(0))), atlas(&impostors) { }
+
+/**
+ * Turns the impostor to show the frame nearest to a facing
+ * @param facing The yaw in radians
+*/
+void ImpostorEntity::setFacing(float facing) {
+  int next = atlas->frameFor(facing);
+  if (next == frame) return;
+  frame = next;
+  graphic.setTextureRect(atlas->getFrame(frame));
+}
+
+/**
+ * Bakes an impostor atlas offline from an .obj file
+ * @param meshFile The mesh being baked
+ * @param imageFile The atlas image being written, with its metadata beside it
+ * @param settings The baking settings
+ * @return The process exit code
+*/
+int bakeImpostorFile(const char *meshFile, const char *imageFile, const ImpostorSettings &settings) {
+  if (settings.frames < 1 || settings.frameSize < 1) {
+    std::cout << "Failed to bake impostor: *" << settings.frames << " frames of " << settings.frameSize << " pixels*" << std::endl;
+    return 1;
+  }
+  Mesh mesh(meshFile);
+  if (mesh.getTriangles().empty()) return 1;
+  mesh.loadLODs(meshFile);
+  ImpostorAtlas atlas;
+  atlas.bake(mesh, settings);
+  if (!atlas.saveToFile(imageFile)) {
+    std::cout << "Failed to write file: *" << imageFile << "*" << std::endl;
+    return 1;
+  }
+  return 0;
+}
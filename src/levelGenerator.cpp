@@ -0,0 +1,435 @@
+#include "LevelGenerator.hpp"
+#include "Profiler.hpp"
+#include "MemoryTracker.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+static const char levelMagic[4] = {'L', 'V', 'L', '1'};
+
+/**
+ * Mixes a value into a well distributed hash (splitmix64), so any pixel or room can draw its own random numbers
+ * @param value The value
+ * @return The hash
+*/
+static inline std::uint64_t mix(std::uint64_t value) {
+  value += 0x9E3779B97F4A7C15ull;
+  value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+  value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+  return value ^ (value >> 31);
+}
+
+/**
+ * Hashes a seed with two coordinates and a channel
+ * @param seed The level's seed
+ * @param x The first coordinate
+ * @param y The second coordinate
+ * @param channel Separates independent draws at the same coordinates @def{0}
+ * @return The hash
+*/
+static inline std::uint64_t hash(std::uint64_t seed, std::uint64_t x, std::uint64_t y, std::uint64_t channel=0) {
+  return mix(mix(mix(seed ^ (channel << 48)) ^ x) ^ y);
+}
+
+/**
+ * Returns a hash as a uniform number in [0, 1)
+ * @param value The hash
+ * @return The number
+*/
+static inline float unit(std::uint64_t value) {
+  return (value >> 40) * (1.f / (1 << 24));
+}
+
+/**
+ * Runs a function over every band of rows, with the calling thread taking bands alongside the workers
+ * Note: Which thread runs a band does not affect what it generates, as each band seeds its own random stream
+ * @param rows The number of rows
+ * @param threads The number of threads, or 0 to use one per hardware thread
+ * @param band The function, given each band's first and last (exclusive) row
+*/
+static void forEachBand(unsigned int rows, unsigned int threads, const std::function<void(unsigned int, unsigned int)> &band) {
+  unsigned int bands = (rows + LEVEL_BAND_ROWS - 1) / LEVEL_BAND_ROWS;
+  if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+  threads = std::min(threads, bands);
+  std::atomic<unsigned int> next(0);
+  auto work = [&]() {
+    for (unsigned int i = next++; i < bands; i = next++) band(i * LEVEL_BAND_ROWS, std::min(rows, (i + 1) * LEVEL_BAND_ROWS));
+  };
+  std::vector<std::thread> workers;
+  for (unsigned int t = 1; t < threads; t++) workers.emplace_back(work);
+  work();
+  for (auto &worker : workers) worker.join();
+}
+
+/**
+ * Scatters walls independently
+ * @param level The level, sized
+ * @param settings The generator's settings
+*/
+static void generateNoise(Level &level, const LevelSettings &settings) {
+  forEachBand(level.height, settings.threads, [&](unsigned int first, unsigned int last) {
+    for (unsigned int y = first; y < last; y++)
+      for (unsigned int x = 0; x < level.width; x++)
+        level.walls[(std::size_t)y * level.width + x] = unit(hash(settings.seed, x, y)) < settings.density;
+  });
+}
+
+/**
+ * Lays out a grid of rooms, each with a doorway in its top and left walls
+ * Note: Every pixel is decided from hashes of its room and position alone, so no pass depends on another
+ * @param level The level, sized
+ * @param settings The generator's settings
+*/
+static void generateRooms(Level &level, const LevelSettings &settings) {
+  unsigned int size = std::max(6u, settings.cellSize);
+  forEachBand(level.height, settings.threads, [&](unsigned int first, unsigned int last) {
+    for (unsigned int y = first; y < last; y++) {
+      unsigned int roomY = y / size, localY = y % size;
+      for (unsigned int x = 0; x < level.width; x++) {
+        unsigned int roomX = x / size, localX = x % size;
+        bool wall = false;
+        if (localX == 0 || localY == 0) {
+          // A quarter of the walls are left out, joining rooms into halls
+          bool left = localX == 0 && localY != 0, top = localY == 0 && localX != 0;
+          std::uint64_t room = hash(settings.seed, roomX, roomY, 1);
+          unsigned int door = 1 + (left ? room : room >> 32) % (size - 3);
+          unsigned int along = left ? localY : localX;
+          bool open = (left && (room >> 16) % 4 == 0) || (top && (room >> 48) % 4 == 0);
+          wall = !(left || top) || (!open && (along < door || along > door + 1));
+        } else if (localX > 1 && localY > 1 && localX < size - 1 && localY < size - 1) {
+          wall = unit(hash(settings.seed, x, y)) < settings.density;
+        }
+        level.walls[(std::size_t)y * level.width + x] = wall;
+      }
+    }
+  });
+}
+
+/**
+ * Carves a maze with the sidewinder algorithm, which decides each row of cells independently
+ * Note: Each run of cells joined eastwards opens one passage north, so every row connects to the top row, a single corridor
+ * @param level The level, sized
+ * @param settings The generator's settings
+*/
+static void generateMaze(Level &level, const LevelSettings &settings) {
+  unsigned int pitch = std::max(1u, settings.cellSize) + 1;
+  unsigned int columns = std::max(1u, (level.width - 1) / pitch), rows = std::max(1u, (level.height - 1) / pitch);
+  const std::uint8_t east = 1, north = 2;
+  std::vector<std::uint8_t> cells((std::size_t)columns * rows, 0);
+
+  forEachBand(rows, settings.threads, [&](unsigned int first, unsigned int last) {
+    for (unsigned int row = first; row < last; row++) {
+      std::uint8_t *cell = &cells[(std::size_t)row * columns];
+      std::mt19937 rng(hash(settings.seed, row, 0, 2));
+      unsigned int runStart = 0;
+      for (unsigned int column = 0; column < columns; column++) {
+        bool lastColumn = column + 1 == columns;
+        if (row == 0) {
+          if (!lastColumn) cell[column] |= east;
+        } else if (lastColumn || rng() % 2) {
+          cell[runStart + rng() % (column - runStart + 1)] |= north;
+          runStart = column + 1;
+        } else {
+          cell[column] |= east;
+        }
+      }
+    }
+  });
+
+  forEachBand(level.height, settings.threads, [&](unsigned int first, unsigned int last) {
+    for (unsigned int y = first; y < last; y++) {
+      unsigned int row = y / pitch, localY = y % pitch;
+      for (unsigned int x = 0; x < level.width; x++) {
+        unsigned int column = x / pitch, localX = x % pitch;
+        bool wall = true;
+        if (row < rows && column < columns && (localX != 0 || localY != 0)) {
+          if (localX == 0) wall = column == 0 || !(cells[(std::size_t)row * columns + column - 1] & east);
+          else if (localY == 0) wall = !(cells[(std::size_t)row * columns + column] & north);
+          else wall = false;
+        }
+        level.walls[(std::size_t)y * level.width + x] = wall;
+      }
+    }
+  });
+}
+
+/**
+ * Fills walls at the density, then repeatedly turns each pixel into a wall when most of its neighbourhood is, growing smooth caverns
+ * @param level The level, sized
+ * @param settings The generator's settings
+*/
+static void generateCave(Level &level, const LevelSettings &settings) {
+  generateNoise(level, settings);
+  std::vector<std::uint8_t> next(level.walls.size());
+  int width = level.width, height = level.height;
+  for (int i = 0; i < CAVE_ITERATIONS; i++) {
+    const std::uint8_t *walls = level.walls.data();
+    forEachBand(level.height, settings.threads, [&](unsigned int first, unsigned int last) {
+      // Each column's three pixels are summed once, then three column sums make each neighbourhood
+      // Pixels beyond the edge count as walls, closing the caverns off
+      std::vector<std::uint8_t> columns(width + 2, 3);
+      for (int y = first; y < (int)last; y++) {
+        const std::uint8_t *above = y > 0 ? walls + (std::size_t)(y - 1) * width : nullptr;
+        const std::uint8_t *row = walls + (std::size_t)y * width;
+        const std::uint8_t *below = y + 1 < height ? walls + (std::size_t)(y + 1) * width : nullptr;
+        for (int x = 0; x < width; x++) columns[x + 1] = (above ? above[x] : 1) + row[x] + (below ? below[x] : 1);
+        std::uint8_t *out = next.data() + (std::size_t)y * width;
+        for (int x = 0; x < width; x++) out[x] = columns[x] + columns[x + 1] + columns[x + 2] >= 5;
+      }
+    });
+    level.walls.swap(next);
+  }
+}
+
+/**
+ * Places the player on the floor pixel nearest the centre, searching outwards ring by ring
+ * @param level The level
+ * @return Whether a floor pixel was found
+*/
+static bool placePlayer(Level &level) {
+  int cx = level.width / 2, cy = level.height / 2;
+  int maxRadius = std::max(level.width, level.height);
+  for (int radius = 0; radius <= maxRadius; radius++) {
+    for (int y = cy - radius; y <= cy + radius; y++) {
+      if (y < 0 || y >= (int)level.height) continue;
+      int step = y == cy - radius || y == cy + radius ? 1 : 2 * radius;
+      for (int x = cx - radius; x <= cx + radius; x += std::max(step, 1)) {
+        if (x < 0 || x >= (int)level.width || level.isWall(x, y)) continue;
+        level.player = sf::Vector2u(x, y);
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+/**
+ * Generates a level, splitting the work across threads
+ * Note: The outermost pixels are always walls, and the same settings give the same level whatever the thread count
+ * @param settings The generator's settings
+ * @return The level
+*/
+Level generateLevel(const LevelSettings &settings) {
+  PROFILE_SCOPE("generateLevel");
+  MEMORY_TAG(MemoryTag::Level);
+  Level level;
+  level.width = std::max(3u, settings.width);
+  level.height = std::max(3u, settings.height);
+  level.walls.resize((std::size_t)level.width * level.height);
+  switch (settings.pattern) {
+    case LevelPattern::Noise: generateNoise(level, settings); break;
+    case LevelPattern::Rooms: generateRooms(level, settings); break;
+    case LevelPattern::Maze: generateMaze(level, settings); break;
+    case LevelPattern::Cave: generateCave(level, settings); break;
+  }
+
+  std::uint8_t *walls = level.walls.data();
+  std::size_t last = (std::size_t)(level.height - 1) * level.width;
+  std::fill(walls, walls + level.width, 1);
+  std::fill(walls + last, walls + last + level.width, 1);
+  for (unsigned int y = 0; y < level.height; y++) walls[(std::size_t)y * level.width] = walls[(std::size_t)y * level.width + level.width - 1] = 1;
+
+  // A level without any floor still gets a player, in place of the centre wall
+  if (!placePlayer(level)) {
+    level.player = sf::Vector2u(level.width / 2, level.height / 2);
+    walls[(std::size_t)level.player.y * level.width + level.player.x] = 0;
+  }
+
+  // Spawns are drawn from one stream after the layout, with a limited number of attempts on crowded levels
+  std::mt19937 rng(hash(settings.seed, 0, 0, 3));
+  for (std::uint64_t attempts = (std::uint64_t)settings.spawns * 16; level.spawns.size() < settings.spawns && attempts > 0; attempts--) {
+    sf::Vector2u spawn(rng() % level.width, rng() % level.height);
+    if (!level.isWall(spawn.x, spawn.y) && spawn != level.player) level.spawns.push_back(spawn);
+  }
+  return level;
+}
+
+/**
+ * Draws a level in the layout read by EntityManager::addFromImage: black walls, a blue player and red spawns on white
+ * @param level The level
+ * @return The image
+*/
+sf::Image toImage(const Level &level) {
+  PROFILE_SCOPE("toImage");
+  MEMORY_TAG(MemoryTag::Level);
+  sf::Image image;
+  image.create(level.width, level.height, sf::Color::White);
+  // Each band writes its own rows of pixels
+  forEachBand(level.height, 0, [&](unsigned int first, unsigned int last) {
+    for (unsigned int y = first; y < last; y++)
+      for (unsigned int x = 0; x < level.width; x++)
+        if (level.isWall(x, y)) image.setPixel(x, y, sf::Color::Black);
+  });
+  for (auto &spawn : level.spawns) image.setPixel(spawn.x, spawn.y, sf::Color::Red);
+  image.setPixel(level.player.x, level.player.y, sf::Color::Blue);
+  return image;
+}
+
+/**
+ * Writes a level in the compiled format, which loads without decoding an image and stores a wall in a single bit
+ * @param filename The .lvl file written
+ * @param level The level
+ * @return Whether the file was written
+*/
+bool writeCompiledLevel(const char *filename, const Level &level) {
+  std::ofstream file(filename, std::ios::binary);
+  if (!file) {
+    std::printf("Failed to write file: *%s*\n", filename);
+    return false;
+  }
+  LevelHeader header;
+  std::memcpy(header.magic, levelMagic, 4);
+  header.version = LEVEL_VERSION;
+  header.width = level.width;
+  header.height = level.height;
+  header.playerX = level.player.x;
+  header.playerY = level.player.y;
+  header.spawnCount = level.spawns.size();
+  file.write((const char*)&header, sizeof(header));
+  for (auto &spawn : level.spawns) {
+    std::uint32_t position[2] = {spawn.x, spawn.y};
+    file.write((const char*)position, sizeof(position));
+  }
+
+  std::size_t rowBytes = (level.width + 7) / 8;
+  std::vector<std::uint8_t> bits(rowBytes * level.height, 0);
+  forEachBand(level.height, 0, [&](unsigned int first, unsigned int last) {
+    for (unsigned int y = first; y < last; y++)
+      for (unsigned int x = 0; x < level.width; x++)
+        if (level.isWall(x, y)) bits[y * rowBytes + x / 8] |= 1 << (x % 8);
+  });
+  file.write((const char*)bits.data(), bits.size());
+  return (bool)file;
+}
+
+/**
+ * Reads a level written by writeCompiledLevel
+ * @param filename The .lvl file
+ * @param level The level read into
+ * @return Whether the file was a valid compiled level
+*/
+bool readCompiledLevel(const char *filename, Level &level) {
+  PROFILE_SCOPE("readCompiledLevel");
+  MEMORY_TAG(MemoryTag::Level);
+  std::ifstream file(filename, std::ios::binary);
+  LevelHeader header;
+  if (!file || !file.read((char*)&header, sizeof(header)) || std::memcmp(header.magic, levelMagic, 4) != 0 || header.version != LEVEL_VERSION
+      || header.width == 0 || header.height == 0 || header.width > LEVEL_MAX_SIZE || header.height > LEVEL_MAX_SIZE
+      || header.playerX >= header.width || header.playerY >= header.height || header.spawnCount > (std::uint64_t)header.width * header.height) {
+    std::printf("Failed to read level: *%s*\n", filename);
+    return false;
+  }
+  level.width = header.width;
+  level.height = header.height;
+  level.player = sf::Vector2u(header.playerX, header.playerY);
+  level.spawns.clear();
+  for (std::uint32_t i = 0; i < header.spawnCount; i++) {
+    std::uint32_t position[2];
+    if (!file.read((char*)position, sizeof(position))) break;
+    if (position[0] < level.width && position[1] < level.height) level.spawns.emplace_back(position[0], position[1]);
+  }
+
+  std::size_t rowBytes = (level.width + 7) / 8;
+  std::vector<std::uint8_t> bits(rowBytes * level.height);
+  if (!file.read((char*)bits.data(), bits.size())) {
+    std::printf("Failed to read level: *%s*\n", filename);
+    return false;
+  }
+  level.walls.resize((std::size_t)level.width * level.height);
+  forEachBand(level.height, 0, [&](unsigned int first, unsigned int last) {
+    for (unsigned int y = first; y < last; y++)
+      for (unsigned int x = 0; x < level.width; x++)
+        level.walls[(std::size_t)y * level.width + x] = bits[y * rowBytes + x / 8] >> (x % 8) & 1;
+  });
+  return true;
+}
+
+/**
+ * Loads a level image, converting compiled .lvl levels into the image layout
+ * @param filename The level image or .lvl file
+ * @param image The image loaded into
+ * @return Whether the level could be loaded
+*/
+bool loadLevel(const char *filename, sf::Image &image) {
+  std::size_t length = std::strlen(filename);
+  if (length < 4 || std::strcmp(filename + length - 4, ".lvl") != 0) return image.loadFromFile(filename);
+  Level level;
+  if (!readCompiledLevel(filename, level)) return false;
+  image = toImage(level);
+  return true;
+}
+
+/**
+ * Reads the generator's options
+ * Options: --size W H, --pattern noise|rooms|maze|cave, --density D, --cell N, --spawns N, --seed N, --threads N
+ * @param argc The argument count
+ * @param argv The arguments, starting with the program and --generate-level
+ * @param output Set to the output file, the first argument which is not an option
+ * @return The settings
+*/
+LevelSettings parseLevelArgs(int argc, char *argv[], const char **output) {
+  LevelSettings settings;
+  *output = nullptr;
+  for (int i = 2; i < argc; i++) {
+    bool value = i + 1 < argc;
+    if (std::strcmp(argv[i], "--size") == 0 && i + 2 < argc) {
+      settings.width = std::atoi(argv[++i]);
+      settings.height = std::atoi(argv[++i]);
+    } else if (std::strcmp(argv[i], "--pattern") == 0 && value) {
+      const char *pattern = argv[++i];
+      if (std::strcmp(pattern, "noise") == 0) settings.pattern = LevelPattern::Noise;
+      else if (std::strcmp(pattern, "rooms") == 0) settings.pattern = LevelPattern::Rooms;
+      else if (std::strcmp(pattern, "maze") == 0) settings.pattern = LevelPattern::Maze;
+      else if (std::strcmp(pattern, "cave") == 0) settings.pattern = LevelPattern::Cave;
+      else std::fprintf(stderr, "Unknown level pattern: *%s*\n", pattern);
+    } else if (std::strcmp(argv[i], "--density") == 0 && value) settings.density = std::atof(argv[++i]);
+    else if (std::strcmp(argv[i], "--cell") == 0 && value) settings.cellSize = std::atoi(argv[++i]);
+    else if (std::strcmp(argv[i], "--spawns") == 0 && value) settings.spawns = std::atoi(argv[++i]);
+    else if (std::strcmp(argv[i], "--seed") == 0 && value) settings.seed = std::atoi(argv[++i]);
+    else if (std::strcmp(argv[i], "--threads") == 0 && value) settings.threads = std::atoi(argv[++i]);
+    else if (!*output && argv[i][0] != '-') *output = argv[i];
+    else std::fprintf(stderr, "Unknown level option: *%s*\n", argv[i]);
+  }
+  return settings;
+}
+
+/**
+ * Generates a level and writes it as a compiled .lvl file or, for any other extension, as an image
+ * @param argc The argument count
+ * @param argv The arguments, starting with the program and --generate-level
+ * @return The process exit code
+*/
+int runLevelGenerator(int argc, char *argv[]) {
+  using Clock = std::chrono::steady_clock;
+  const char *output;
+  LevelSettings settings = parseLevelArgs(argc, argv, &output);
+  if (!output) {
+    std::printf("Usage: --generate-level <file.lvl|file.png> [--size W H] [--pattern noise|rooms|maze|cave] [--density D] [--cell N] [--spawns N] [--seed N] [--threads N]\n");
+    return 1;
+  }
+
+  Clock::time_point start = Clock::now();
+  Level level = generateLevel(settings);
+  double generated = std::chrono::duration<double>(Clock::now() - start).count();
+  std::size_t walls = 0;
+  for (std::uint8_t wall : level.walls) walls += wall;
+  std::printf("Generated %ux%u level in %.3f s: %zu walls (%.1f%%), %zu spawns\n", level.width, level.height, generated,
+              walls, 100.0 * walls / level.walls.size(), level.spawns.size());
+
+  start = Clock::now();
+  std::size_t length = std::strlen(output);
+  bool written = length >= 4 && std::strcmp(output + length - 4, ".lvl") == 0 ? writeCompiledLevel(output, level) : toImage(level).saveToFile(output);
+  if (!written) return 1;
+  std::printf("Wrote *%s* in %.3f s\n", output, std::chrono::duration<double>(Clock::now() - start).count());
+  return 0;
+}
@@ -0,0 +1,200 @@
+#include "Logger.hpp"
+
+#include <cctype>
+#include <chrono>
+
+static const char *levelNames[] = {"DEBUG", "INFO", "WARN", "ERROR"};
+static const char *categoryNames[] = {"general", "window", "input", "assets", "performance"};
+
+/**
+ * Returns the logger, starting its writer thread on first use
+ * @return The logger
+*/
+Logger& Logger::get() {
+  static Logger logger;
+  return logger;
+}
+
+Logger::Logger() : ring(new LogRecord[LOG_RING_SIZE]), start(now()) {
+  static_assert((LOG_RING_SIZE & (LOG_RING_SIZE - 1)) == 0, "LOG_RING_SIZE must be a power of two");
+  for (std::uint64_t i = 0; i < LOG_RING_SIZE; i++) ring[i].sequence.store(i, std::memory_order_relaxed);
+  writer = std::thread(&Logger::run, this);
+}
+
+/**
+ * Stops the writer thread once it has written every record
+*/
+Logger::~Logger() {
+  stopping = true;
+  writer.join();
+  delete[] ring;
+}
+
+/**
+ * Returns the steady clock's time
+ * @return The time in nanoseconds
+*/
+std::uint64_t Logger::now() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * Reserves the next record in the ring for the calling thread
+ * Note: A record is free once the writer has read it a lap earlier, so its sequence equals the position being claimed
+ * @param level The message's severity
+ * @param category The subsystem the message is from
+ * @return The record to fill, or nullptr if the ring is full
+*/
+LogRecord* Logger::claim(LogLevel level, LogCategory category) {
+  std::uint64_t position = writePosition.load(std::memory_order_relaxed);
+  LogRecord *record;
+  while (true) {
+    record = &ring[position & (LOG_RING_SIZE - 1)];
+    std::int64_t lap = (std::int64_t)(record->sequence.load(std::memory_order_acquire) - position);
+    if (lap == 0) {
+      if (writePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) break;
+    } else if (lap < 0) {
+      dropped.fetch_add(1, std::memory_order_relaxed);
+      return nullptr;
+    } else position = writePosition.load(std::memory_order_relaxed);
+  }
+  record->time = now() - start;
+  record->level = level;
+  record->category = category;
+  record->argCount = record->textUsed = 0;
+  return record;
+}
+
+/**
+ * Hands a filled record to the writer thread
+ * @param record The record
+*/
+void Logger::publish(LogRecord *record) {
+  record->sequence.store(record->sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+/**
+ * Formats a record's message, substituting its captured arguments into the format string
+ * Note: Each conversion's length modifier is replaced to match how the argument was captured, so %i and %zu both take 64 bit values
+ * @param record The record
+ * @param line The buffer written to
+ * @param size The buffer's size
+*/
+void Logger::format(const LogRecord &record, char *line, size_t size) const {
+  size_t used = 0;
+  int argument = 0;
+  auto append = [&](int written) { if (written > 0) used = std::min(size - 1, used + written); };
+  for (const char *c = record.format; *c && used < size - 1; c++) {
+    if (*c != '%') { line[used++] = *c; continue; }
+    if (c[1] == '%') { line[used++] = '%'; c++; continue; }
+
+    // Copy the flags, width and precision, skip the length modifier and read the conversion
+    char spec[32] = "%";
+    size_t specLength = 1;
+    c++;
+    while (*c && std::strchr("-+ #0123456789.", *c) && specLength < sizeof(spec) - 4) spec[specLength++] = *c++;
+    while (*c && std::strchr("hlLqjzt", *c)) c++;
+    if (!*c) break;
+    char conversion = *c;
+    if (argument >= record.argCount) { append(std::snprintf(line + used, size - used, "<missing>")); continue; }
+    LogType type = record.types[argument];
+    LogValue value = record.values[argument++];
+
+    if (std::strchr("diuoxX", conversion)) { spec[specLength++] = 'l'; spec[specLength++] = 'l'; }
+    spec[specLength++] = conversion;
+    spec[specLength] = '\0';
+    switch (conversion) {
+      case 'd': case 'i':
+        append(std::snprintf(line + used, size - used, spec, type == LogType::Double ? (long long)value.d : value.i));
+        break;
+      case 'u': case 'o': case 'x': case 'X':
+        append(std::snprintf(line + used, size - used, spec, type == LogType::Double ? (unsigned long long)value.d : value.u));
+        break;
+      case 'c':
+        append(std::snprintf(line + used, size - used, spec, (int)value.i));
+        break;
+      case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+        append(std::snprintf(line + used, size - used, spec, type == LogType::Double ? value.d : type == LogType::Signed ? (double)value.i : (double)value.u));
+        break;
+      case 's':
+        append(std::snprintf(line + used, size - used, spec, type == LogType::Text ? record.text + value.u : "<not text>"));
+        break;
+      case 'p':
+        append(std::snprintf(line + used, size - used, spec, (void*)(std::uintptr_t)value.u));
+        break;
+      default:
+        append(std::snprintf(line + used, size - used, "<%%%c?>", conversion));
+        break;
+    }
+  }
+  line[used] = '\0';
+}
+
+/**
+ * Writes every record published so far, then flushes the output once
+ * @return Whether any record was written
+*/
+bool Logger::drain() {
+  FILE *file = output.load();
+  char line[LOG_LINE_BYTES], message[LOG_LINE_BYTES];
+  std::uint64_t position = readPosition.load(std::memory_order_relaxed), first = position;
+  while (true) {
+    LogRecord &record = ring[position & (LOG_RING_SIZE - 1)];
+    if (record.sequence.load(std::memory_order_acquire) != position + 1) break;
+    format(record, message, sizeof(message));
+    int length = std::snprintf(line, sizeof(line), "[%10.3f] %-5s %-11s %s\n", record.time * 1e-9, levelNames[(int)record.level],
+                               categoryNames[(int)record.category], message);
+    std::fwrite(line, 1, std::min<size_t>(length, sizeof(line) - 1), file);
+    record.sequence.store(position + LOG_RING_SIZE, std::memory_order_release);
+    readPosition.store(++position, std::memory_order_release);
+  }
+
+  static std::uint64_t reported = 0;
+  std::uint64_t lost = dropped.load(std::memory_order_relaxed);
+  bool wrote = position != first || lost != reported;
+  if (lost != reported) {
+    std::fprintf(file, "Log ring full, dropped %llu records\n", (unsigned long long)(lost - reported));
+    reported = lost;
+  }
+  if (wrote) std::fflush(file);
+  return wrote;
+}
+
+/**
+ * Runs the writer thread, sleeping whenever the ring is empty so writing never has to wake it
+*/
+void Logger::run() {
+  while (true) {
+    bool stop = stopping.load();
+    if (!drain()) {
+      if (stop) break;
+      std::this_thread::sleep_for(std::chrono::milliseconds(LOG_POLL_MS));
+    }
+  }
+}
+
+/**
+ * Waits until every record written before the call has been written out
+*/
+void Logger::flush() {
+  std::uint64_t target = writePosition.load(std::memory_order_acquire);
+  while (readPosition.load(std::memory_order_acquire) < target) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+}
+
+/**
+ * Parses a severity's name, as printed in the log
+ * @param name The name, in any case: debug, info, warn or error
+ * @param level The severity, set if the name is known
+ * @return Whether the name is known
+*/
+bool parseLogLevel(const char *name, LogLevel &level) {
+  for (int i = 0; i < 4; i++) {
+    int c = 0;
+    while (name[c] && std::toupper((unsigned char)name[c]) == levelNames[i][c]) c++;
+    if (!name[c] && !levelNames[i][c]) {
+      level = (LogLevel)i;
+      return true;
+    }
+  }
+  return false;
+}
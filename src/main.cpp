@@ -1,7 +1,39 @@
 #include "Header.hpp"
 
-int main()
+int main(int argc, char *argv[])
 {
+  // Command line modes which run without opening a window
+  if (argc > 1 && std::strcmp(argv[1], "--benchmark") == 0) {
+    const char *filter = argc > 2 && std::strcmp(argv[2], "--json") != 0 ? argv[2] : "";
+    const char *json = nullptr;
+    for (int i = 2; i + 1 < argc; i++)
+      if (std::strcmp(argv[i], "--json") == 0) json = argv[i + 1];
+    return runBenchmarks(filter, json);
+  }
+  if (argc > 2 && std::strcmp(argv[1], "--generate-lods") == 0) {
+    std::vector<float> ratios;
+    for (int i = 3; i < argc; i++) ratios.push_back(std::atof(argv[i]));
+    if (ratios.empty()) ratios = DEFAULT_LOD_RATIOS;
+    return generateLODFiles(argv[2], ratios);
+  }
+  if (argc > 3 && std::strcmp(argv[1], "--bake-impostor") == 0) {
+    ImpostorSettings settings;
+    if (argc > 4) settings.frames = std::atoi(argv[4]);
+    if (argc > 5) settings.frameSize = std::atoi(argv[5]);
+    return bakeImpostorFile(argv[2], argv[3], settings);
+  }
+  if (argc > 1 && std::strcmp(argv[1], "--headless") == 0)
+    return runHeadless(parseHeadlessArgs(argc, argv));
+  if (argc > 1 && std::strcmp(argv[1], "--generate-level") == 0)
+    return runLevelGenerator(argc, argv);
+  if (argc > 2 && std::strcmp(argv[1], "--regress") == 0)
+    return runRegression(parseRegressionArgs(argc, argv));
+  if (argc > 3 && std::strcmp(argv[1], "--pack") == 0)
+    return packArchive(argv[2], argv[3], argc > 4 && std::strcmp(argv[4], "--lz4") == 0);
+
+  // Zones are only recorded when built with -DENABLE_PROFILER
+  PROFILE_THREAD("Main");
+
   // Simple circle rendering
   int width = 1280, height = 960;
   sf::RenderWindow window(sf::VideoMode(width, height), "SFML App");
@@ -9,61 +41,211 @@ int main()
   sf::CircleShape shape(100.f);
   shape.setFillColor(sf::Color::Green);
 
+  // Assets are decoded on worker threads and finished by loader.update() within the loop
+  // The cache shares each asset between its users so every file is only loaded once
+  // Assets are read from res.pak when it has been packed, falling back to loose files otherwise
+  AssetArchive archive;
+  AssetLoader loader;
+  AssetCache assets;
+  if (archive.open("res.pak")) {
+    loader.mount(&archive);
+    assets.mount(&archive);
+  }
+
   // Create texture
-  sf::Texture texture;
-  texture.loadFromFile("res/Tile.png");
-  texture.setRepeated(true);
-  sf::Sprite sprite(texture);
+  sf::Sprite sprite;
   sprite.setPosition(sf::Vector2f(width / 2, height / 2));
+  AssetFuture<sf::Texture> texture = assets.loadTexture("res/Tile.png", loader, [&](std::shared_ptr<sf::Texture> loaded) {
+    if (!loaded) return;
+    loaded->setRepeated(true);
+    sprite.setTexture(*loaded);
+  });
 
-  // Create text
+  // Create the HUD, whose widgets only re-render into its cached texture when their content changes
   int textSize = 32;
   sf::Vector2i pos = sf::Mouse::getPosition();
   char buffer[100];
-  std::sprintf(buffer, "Mouse Position: (%.3f, %.3f)", pos.x, pos.y);
+  BitmapFont hudFont;
+  Hud hud;
+  hud.create(420, 290);
+  HudText &frameText = hud.add<HudText>(sf::Vector2f(10, 40), 24, sf::Color::Red);
+  HudText &mouseText = hud.add<HudText>(sf::Vector2f(10, 80), 40, sf::Color::Red);
+  HudGraph &frameGraph = hud.add<HudGraph>(sf::FloatRect(10, 100, 400, 80), 60, 0.f, 50.f);
+  HudBar &loadingBar = hud.add<HudBar>(sf::FloatRect(10, 190, 400, 12));
+  HudText &drawText = hud.add<HudText>(sf::Vector2f(10, 240), 40, sf::Color::Red);
+  HudText &memoryText = hud.add<HudText>(sf::Vector2f(10, 280), 40, sf::Color::Red);
+  AssetFuture<sf::Font> font = assets.loadFont("res/arial.ttf", loader, [&](std::shared_ptr<sf::Font> loaded) {
+    if (loaded && hudFont.bake(*loaded, textSize)) hud.setFont(hudFont);
+  });
 
-  sf::Font font;
-  font.loadFromFile("res/arial.ttf");
+  // Render 3D mesh
+  AssetFuture<Mesh> newMesh = assets.loadMesh("res/Person_model.obj", loader);
 
-  sf::Text text;
-  text.setFont(font);
-  text.setFillColor(sf::Color::Red);
-  text.setString(buffer);
-  text.setCharacterSize(textSize);
-  text.setStyle(sf::Text::Bold);
-  text.setPosition(sf::Vector2f(width / 2, height / 2));
+  // Dust follows the mouse, drawn above the entities in one call; 400 a second living up to 1.5 s never exceeds 1024 at once
+  ParticleSystem particles(1024);
+  EmitterSettings dust;
+  dust.rate = 400;
+  dust.startColor = sf::Color(255, 200, 120);
+  dust.endColor = sf::Color(120, 60, 20, 0);
+  dust.blend = ParticleBlend::Add;
+  particles.setGravity(sf::Vector2f(0, 60));
+  particles.setDrag(1.5f);
+  int dustEmitter = particles.addEmitter(dust);
 
-  // Render 3D mesh
-  Mesh newMesh("res/Person_model.obj");
+  // Lights are blocked by the level's walls; the first follows the mouse
+  WallMap walls;
+  LightMap lightMap;
+  lightMap.create(width, height);
+  std::vector<Light> lights(3);
+  std::vector<std::vector<sf::Vector2f>> lightPolygons;
+  lights[0].color = sf::Color(255, 230, 180);
+  lights[1].position = sf::Vector2f(200, 200);
+  lights[1].color = sf::Color(120, 160, 255);
+  lights[2].position = sf::Vector2f(width - 200, height - 200);
+  lights[2].color = sf::Color(255, 120, 120);
+
+  // The main camera follows the player; the minimap shows the whole level in the top right corner
+  Camera camera(sf::FloatRect(0, 0, width, height));
+  Camera minimap(sf::FloatRect(0, 0, width, height));
+  camera.setDeadZone(sf::Vector2f(64, 48));
+  minimap.setViewport(sf::FloatRect(0.75f, 0, 0.25f, 0.25f));
+  minimap.setZoomLimits(1, 64);
 
   // Define Entity Manager
   EntityManager entityManager;
+  entityManager.setLayerStatic(WALL_LAYER, true);
   long long int counter = 1;
-  entityManager.addFromFile("res/simpleScene.png");
-  std::cout << "Length: " << entityManager.size() << std::endl;
+  loader.loadImage("res/simpleScene.png", [&](std::shared_ptr<sf::Image> level) {
+    PROFILE_SCOPE("Level load");
+    if (level) {
+      entityManager.addFromImage(*level);
+      walls.build(*level);
+      sf::Vector2f levelSize = sf::Vector2f(level->getSize()) * 32.f;
+      camera.setBounds(sf::FloatRect(sf::Vector2f(0, 0), levelSize));
+      camera.follow(entityManager.getPlayer());
+      minimap.setZoom(std::max(levelSize.x / width, levelSize.y / height), true);
+      minimap.setCenter(levelSize / 2.f);
+    }
+    LOG_INFO(LogCategory::Assets, "Length: %zu", entityManager.size());
+  });
+
+  // Frames are paced by sleeping while assets load, then by sleeping and spinning for consistent frame times
+  FramePacer pacer(TARGET_FPS, PacingMode::Sleep);
+
+  // Frame times are tracked as percentiles since averages hide hitches; a frame half again longer than paced is over budget
+  FrameHistogram secondFrames(1500.0 / TARGET_FPS), sessionFrames(1500.0 / TARGET_FPS);
+  FILE *frameCsv = nullptr;
+  unsigned long long frameNumber = 0;
+
+  // Heap use is tracked per subsystem when built with -DENABLE_MEMORY_TRACKING
+  std::uint64_t secondAllocations = 0, secondFrameCount = 0;
+  memoryText.setText(memoryTrackingEnabled() ? "Heap: measuring" : "Heap: untracked");
+
+  // Run with --alloc-guard to report the call sites which allocate once assets have loaded, or --alloc-trap to abort at the first
+  // Messages are logged from info upwards; run with --log-level debug to also log every input event
+  // Run with --frame-csv <file> to also write every frame's time for offline analysis
+  for (int i = 1; i < argc; i++) {
+    LogLevel level;
+    if (std::strcmp(argv[i], "--frame-csv") == 0 && i + 1 < argc && !frameCsv) {
+      frameCsv = std::fopen(argv[i + 1], "w");
+      if (frameCsv) std::fprintf(frameCsv, "frame,milliseconds\n");
+    } else if (std::strcmp(argv[i], "--alloc-guard") == 0) setAllocationGuard(AllocationGuardMode::Report);
+    else if (std::strcmp(argv[i], "--alloc-trap") == 0) setAllocationGuard(AllocationGuardMode::Trap);
+    else if (std::strcmp(argv[i], "--log-level") == 0 && i + 1 < argc && parseLogLevel(argv[i + 1], level)) Logger::get().setLevel(level);
+  }
+  std::uint64_t secondGuarded = 0;
 
-  int frames = 0;
-  sf::Clock clock;
+  int requested = loader.getPending();
+  sf::Clock clock, frameClock, presentClock;
   clock.restart();
   while (window.isOpen())
   {
-    // Support events
-    manageEvents(window);
+    bool guardFrame = getAllocationGuard() != AllocationGuardMode::Off && !loader.getPending();
+    if (guardFrame) beginGuardedFrame();
+
+    // Support events and finish any assets which have loaded
+    manageEvents(window, &camera);
+    loader.update();
+
+    // Update the HUD, which re-renders only the widgets whose content changed
+    pos = sf::Mouse::getPosition(window);
+    std::snprintf(buffer, sizeof(buffer), "Mouse: %i, %i", pos.x, pos.y);
+    mouseText.setText(buffer);
+    loadingBar.setValue(requested ? 1 - (float)loader.getPending() / requested : 1);
+    hud.update();
+    float dt = frameClock.restart().asSeconds();
+    camera.update(dt);
+    sf::Vector2f cursor = window.mapPixelToCoords(pos, camera.getView());
+    particles.setEmitterPosition(dustEmitter, cursor);
+    particles.update(dt);
+    lights[0].position = cursor;
+    computeVisibility(walls, lights, lightPolygons);
+    lightMap.update(lights, lightPolygons, camera.getView());
 
-    // Clear screen, render items, and display new buffer
+    // Clear screen, render each camera's visible items, draw the HUD over the window, and display new buffer
     window.clear(bgColor);
-    entityManager.render(window);
-    window.display();
+    entityManager.render(window, camera.getView());
+    window.draw(lightMap);
+    window.draw(particles);
+    entityManager.render(window, minimap.getView());
+    window.setView(window.getDefaultView());
+    window.draw(hud);
+    pacer.setMode(loader.getPending() ? PacingMode::Sleep : PacingMode::Hybrid);
+    pacer.present(window);
+    if (guardFrame) secondGuarded += endGuardedFrame();
+    FrameArena::local().reset();
+    PROFILE_FRAME();
+    double frameTime = presentClock.restart().asMicroseconds() * 1e-3;
+    secondFrames.record(frameTime);
+    if (frameCsv) std::fprintf(frameCsv, "%llu,%.3f\n", frameNumber, frameTime);
+    frameNumber++;
+    secondAllocations += endMemoryFrame().allocations;
+    secondFrameCount++;
 
     // Continuous troubleshooting
-    ++frames;
     if (clock.getElapsedTime().asSeconds() >= 1) { 
-      std::cout << "FPS: " << frames << std::endl;
-      std::cout << "Mouse position: " << pos.x << ", " << pos.y << std::endl;
+      secondFrames.log("Last second");
+      FrameStats stats = pacer.getStats();
+      LOG_INFO(LogCategory::Performance, "Frame: %.3f ms +/- %.3f ms (max %.3f ms, work %.3f ms, spin %.3f ms, present %.3f ms)",
+               stats.mean, stats.deviation, stats.max, stats.work, stats.spin, stats.present);
+      std::snprintf(buffer, sizeof(buffer), "p99: %.2f ms", secondFrames.percentile(99));
+      frameText.setText(buffer);
+      frameGraph.push(secondFrames.percentile(99));
+      sessionFrames.merge(secondFrames);
+      secondFrames.reset();
+      const RenderQueue &queue = entityManager.getRenderQueue();
+      std::snprintf(buffer, sizeof(buffer), "Draws: %i of %i", queue.getDrawCalls(), queue.getCommandCount());
+      drawText.setText(buffer);
+      if (memoryTrackingEnabled()) {
+        std::snprintf(buffer, sizeof(buffer), "Heap: %.1f MB, %.0f allocs/frame", getTotalMemoryStats().liveBytes / 1048576.0,
+                      (double)secondAllocations / std::max<std::uint64_t>(secondFrameCount, 1));
+        memoryText.setText(buffer);
+        logMemoryStats();
+      }
+      secondAllocations = secondFrameCount = 0;
+      const FrameArenaStats &arena = FrameArena::local().getStats();
+      LOG_INFO(LogCategory::Performance, "Frame arena: %.1f KB last frame, %.1f KB high water of %.1f KB, %llu overflows", arena.framePeak / 1024.0,
+               arena.highWater / 1024.0, arena.capacity / 1024.0, arena.overflows);
+      if (secondGuarded) LOG_WARN(LogCategory::Performance, "Guarded frames allocated %llu times in the last second", secondGuarded);
+      secondGuarded = 0;
+#ifdef ENABLE_PROFILER
+      Profiler::get().logLastFrame();
+#endif
+      LOG_INFO(LogCategory::Input, "Mouse position: %i, %i", pos.x, pos.y);
       clock.restart();
-      frames = 0;
     }
   }
 
+  sessionFrames.merge(secondFrames);
+  sessionFrames.log("Session");
+  if (frameCsv) std::fclose(frameCsv);
+  if (getAllocationGuard() != AllocationGuardMode::Off) printAllocationSites();
+
+#ifdef ENABLE_PROFILER
+  // Export the last frames before exit for chrome://tracing or Perfetto
+  std::uint64_t lastFrame = Profiler::get().getFrame();
+  if (lastFrame > 0) Profiler::get().exportChromeTrace("profile.json", lastFrame > PROFILE_EXPORT_FRAMES ? lastFrame - PROFILE_EXPORT_FRAMES : 0, lastFrame - 1);
+#endif
+
   return 0;
 }
\ No newline at end of file
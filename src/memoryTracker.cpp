@@ -0,0 +1,373 @@
+#include "MemoryTracker.hpp"
+#include "Logger.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#elif defined(__GLIBC__) || defined(__APPLE__)
+#include <execinfo.h>
+#define HAS_BACKTRACE
+#endif
+
+#define TAG_COUNT ((int)MemoryTag::Count)
+// The total is kept in the slot after the tags
+#define TOTAL TAG_COUNT
+
+/**
+ * Defines one tag's counters, which are constant initialised so allocations made before main are counted
+*/
+struct MemoryCounters {
+  std::atomic<std::int64_t> liveBytes{0}, liveAllocations{0}, peakBytes{0};
+  std::atomic<std::uint64_t> allocations{0}, allocatedBytes{0};
+};
+
+static MemoryCounters counters[TAG_COUNT + 1];
+static thread_local MemoryTag currentTag = MemoryTag::Untagged;
+static std::uint64_t frameAllocations = 0, frameBytes = 0;
+
+/**
+ * Defines a distinct stack which allocated inside a guarded frame
+*/
+struct AllocationSite {
+  void *frames[ALLOCATION_STACK_DEPTH];
+  int depth = 0;
+  std::uint64_t allocations = 0, bytes = 0;
+};
+
+// Only the thread which begins a guarded frame is guarded, and only it writes the guard's counts and sites
+static AllocationGuardMode guardMode = AllocationGuardMode::Off;
+static thread_local bool guarded = false;
+static std::uint64_t guardedFrame = 0, guardedTotal = 0;
+static AllocationSite sites[ALLOCATION_SITE_LIMIT];
+static int siteCount = 0;
+static std::uint64_t unrecordedSites = 0;
+
+/**
+ * Sets the tag allocations on this thread are charged to
+ * @param tag The tag
+*/
+MemoryScope::MemoryScope(MemoryTag tag) : previous(currentTag) {
+  currentTag = tag;
+}
+
+/**
+ * Restores the tag in use before this scope
+*/
+MemoryScope::~MemoryScope() {
+  currentTag = previous;
+}
+
+/**
+ * Prints a captured stack to stderr, as module offsets on Windows for addr2line, without allocating
+ * @param frames The return addresses
+ * @param depth The number of frames
+*/
+static void printStack(void *const *frames, int depth) {
+#ifdef _WIN32
+  for (int i = 0; i < depth; i++) {
+    HMODULE module = nullptr;
+    char path[MAX_PATH] = "?";
+    if (GetModuleHandleExA(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS | GET_MODULE_HANDLE_EX_FLAG_UNCHANGED_REFCOUNT, (LPCSTR)frames[i], &module))
+      GetModuleFileNameA(module, path, MAX_PATH);
+    std::fprintf(stderr, "    #%-2i %s+0x%llx\n", i, path, (unsigned long long)((char*)frames[i] - (char*)module));
+  }
+#elif defined(HAS_BACKTRACE)
+  std::fflush(stderr);
+  backtrace_symbols_fd(frames, depth, 2);
+#else
+  std::fprintf(stderr, "    (stack traces are unavailable on this platform)\n");
+#endif
+}
+
+#ifdef ENABLE_MEMORY_TRACKING
+// Set while a guarded allocation's stack is captured, so the capture's own allocations are not recorded
+static thread_local bool capturing = false;
+
+/**
+ * Captures the calling thread's stack
+ * @param frames The return addresses captured
+ * @return The number of frames captured
+*/
+static int captureStack(void **frames) {
+#ifdef _WIN32
+  return CaptureStackBackTrace(1, ALLOCATION_STACK_DEPTH, frames, nullptr);
+#elif defined(HAS_BACKTRACE)
+  return backtrace(frames, ALLOCATION_STACK_DEPTH);
+#else
+  return 0;
+#endif
+}
+
+/**
+ * Defines the header placed before every allocation, recording what is needed to uncharge it when freed
+*/
+struct alignas(alignof(std::max_align_t)) AllocationHeader {
+  std::size_t size;
+  std::uint32_t offset;  // from the start of the malloc'd block to the allocation, which is further on for over-aligned types
+  MemoryTag tag;
+};
+
+/**
+ * Records an allocation inside a guarded frame, by its call site when reporting
+ * Note: Capturing can itself allocate the first time, which is ignored rather than recursing
+ * @param size The allocation's size
+*/
+static void guardAllocation(std::size_t size) {
+  guardedFrame++;
+  guardedTotal++;
+  if (guardMode == AllocationGuardMode::Count) return;
+  capturing = true;
+  AllocationSite site;
+  site.depth = captureStack(site.frames);
+  if (guardMode == AllocationGuardMode::Trap) {
+    std::fprintf(stderr, "Heap allocation of %zu bytes inside a guarded frame:\n", size);
+    printStack(site.frames, site.depth);
+    std::abort();
+  }
+  int found = 0;
+  while (found < siteCount && (sites[found].depth != site.depth || std::memcmp(sites[found].frames, site.frames, site.depth * sizeof(void*)) != 0)) found++;
+  if (found == siteCount && siteCount < ALLOCATION_SITE_LIMIT) sites[siteCount++] = site;
+  if (found < siteCount) {
+    sites[found].allocations++;
+    sites[found].bytes += size;
+  } else {
+    unrecordedSites++;
+  }
+  capturing = false;
+}
+
+/**
+ * Adds an allocation to a slot's counters, raising its peak if exceeded
+ * @param slot The counters
+ * @param size The allocation's size
+*/
+static inline void charge(MemoryCounters &slot, std::size_t size) {
+  std::int64_t live = slot.liveBytes.fetch_add(size, std::memory_order_relaxed) + size;
+  slot.liveAllocations.fetch_add(1, std::memory_order_relaxed);
+  slot.allocations.fetch_add(1, std::memory_order_relaxed);
+  slot.allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+  std::int64_t peak = slot.peakBytes.load(std::memory_order_relaxed);
+  while (live > peak && !slot.peakBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) { }
+}
+
+/**
+ * Allocates memory with a header in front, charged to the current tag
+ * @param size The bytes requested
+ * @param alignment The alignment required
+ * @return The allocation, or null on failure
+*/
+static void* allocate(std::size_t size, std::size_t alignment) {
+  alignment = alignment > alignof(AllocationHeader) ? alignment : alignof(AllocationHeader);
+  std::size_t extra = sizeof(AllocationHeader) + alignment - alignof(AllocationHeader);
+  char *block = (char*)std::malloc(size + extra);
+  if (!block) return nullptr;
+  std::uintptr_t start = (std::uintptr_t)block + sizeof(AllocationHeader);
+  char *memory = (char*)((start + alignment - 1) / alignment * alignment);
+  AllocationHeader *header = (AllocationHeader*)memory - 1;
+  header->size = size;
+  header->offset = memory - block;
+  header->tag = currentTag;
+  charge(counters[(int)header->tag], size);
+  charge(counters[TOTAL], size);
+  if (guarded && !capturing) guardAllocation(size);
+  return memory;
+}
+
+/**
+ * Frees memory from allocate, uncharging its tag
+ * @param memory The allocation, or null
+*/
+static void release(void *memory) {
+  if (!memory) return;
+  AllocationHeader *header = (AllocationHeader*)memory - 1;
+  for (int slot : {(int)header->tag, TOTAL}) {
+    counters[slot].liveBytes.fetch_sub(header->size, std::memory_order_relaxed);
+    counters[slot].liveAllocations.fetch_sub(1, std::memory_order_relaxed);
+  }
+  std::free((char*)memory - header->offset);
+}
+
+/**
+ * Allocates memory, throwing when none is left
+ * @param size The bytes requested
+ * @param alignment The alignment required
+ * @return The allocation
+*/
+static void* allocateOrThrow(std::size_t size, std::size_t alignment) {
+  void *memory = allocate(size, alignment);
+  if (!memory) throw std::bad_alloc();
+  return memory;
+}
+
+void* operator new(std::size_t size) { return allocateOrThrow(size, alignof(std::max_align_t)); }
+void* operator new[](std::size_t size) { return allocateOrThrow(size, alignof(std::max_align_t)); }
+void* operator new(std::size_t size, std::align_val_t alignment) { return allocateOrThrow(size, (std::size_t)alignment); }
+void* operator new[](std::size_t size, std::align_val_t alignment) { return allocateOrThrow(size, (std::size_t)alignment); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return allocate(size, alignof(std::max_align_t)); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return allocate(size, alignof(std::max_align_t)); }
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept { return allocate(size, (std::size_t)alignment); }
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept { return allocate(size, (std::size_t)alignment); }
+
+void operator delete(void *memory) noexcept { release(memory); }
+void operator delete[](void *memory) noexcept { release(memory); }
+void operator delete(void *memory, std::size_t) noexcept { release(memory); }
+void operator delete[](void *memory, std::size_t) noexcept { release(memory); }
+void operator delete(void *memory, std::align_val_t) noexcept { release(memory); }
+void operator delete[](void *memory, std::align_val_t) noexcept { release(memory); }
+void operator delete(void *memory, std::size_t, std::align_val_t) noexcept { release(memory); }
+void operator delete[](void *memory, std::size_t, std::align_val_t) noexcept { release(memory); }
+void operator delete(void *memory, const std::nothrow_t&) noexcept { release(memory); }
+void operator delete[](void *memory, const std::nothrow_t&) noexcept { release(memory); }
+void operator delete(void *memory, std::align_val_t, const std::nothrow_t&) noexcept { release(memory); }
+void operator delete[](void *memory, std::align_val_t, const std::nothrow_t&) noexcept { release(memory); }
+#endif
+
+/**
+ * Returns whether allocations are being tracked, which requires building with -DENABLE_MEMORY_TRACKING
+ * @return Whether allocations are tracked
+*/
+bool memoryTrackingEnabled() {
+#ifdef ENABLE_MEMORY_TRACKING
+  return true;
+#else
+  return false;
+#endif
+}
+
+/**
+ * Names a tag
+ * @param tag The tag
+ * @return The name
+*/
+const char* memoryTagName(MemoryTag tag) {
+  static const char *names[TAG_COUNT] = {"untagged", "entities", "mesh", "assets", "level"};
+  return (int)tag < TAG_COUNT ? names[(int)tag] : "total";
+}
+
+/**
+ * Copies a slot's counters
+ * @param slot The counters
+ * @return The statistics
+*/
+static MemoryStats snapshot(const MemoryCounters &slot) {
+  MemoryStats stats;
+  stats.liveBytes = slot.liveBytes.load(std::memory_order_relaxed);
+  stats.liveAllocations = slot.liveAllocations.load(std::memory_order_relaxed);
+  stats.peakBytes = slot.peakBytes.load(std::memory_order_relaxed);
+  stats.allocations = slot.allocations.load(std::memory_order_relaxed);
+  stats.allocatedBytes = slot.allocatedBytes.load(std::memory_order_relaxed);
+  return stats;
+}
+
+/**
+ * Returns the heap use charged to a tag
+ * @param tag The tag
+ * @return The statistics, all zero when tracking is disabled
+*/
+MemoryStats getMemoryStats(MemoryTag tag) {
+  return snapshot(counters[(int)tag < TAG_COUNT ? (int)tag : TOTAL]);
+}
+
+/**
+ * Returns the heap use of every tag together
+ * Note: The peak is the highest the total reached, which can be lower than the sum of each tag's peak
+ * @return The statistics, all zero when tracking is disabled
+*/
+MemoryStats getTotalMemoryStats() {
+  return snapshot(counters[TOTAL]);
+}
+
+/**
+ * Ends a frame, returning the allocations made on every thread since the previous call
+ * Note: Should be called once a frame from one thread
+ * @return The frame's allocations
+*/
+FrameAllocations endMemoryFrame() {
+  MemoryStats total = getTotalMemoryStats();
+  FrameAllocations frame;
+  frame.allocations = total.allocations - frameAllocations;
+  frame.bytes = total.allocatedBytes - frameBytes;
+  frameAllocations = total.allocations;
+  frameBytes = total.allocatedBytes;
+  return frame;
+}
+
+/**
+ * Logs each tag's live and peak heap use
+*/
+void logMemoryStats() {
+  if (!memoryTrackingEnabled()) {
+    LOG_WARN(LogCategory::Performance, "Memory tracking is disabled, build with -DENABLE_MEMORY_TRACKING");
+    return;
+  }
+  LOG_INFO(LogCategory::Performance, "%-10s %12s %12s %12s %14s", "Memory", "live KB", "live allocs", "peak KB", "allocations");
+  for (int tag = 0; tag <= TAG_COUNT; tag++) {
+    MemoryStats stats = snapshot(counters[tag]);
+    LOG_INFO(LogCategory::Performance, "%-10s %12.1f %12lld %12.1f %14llu", memoryTagName((MemoryTag)tag), stats.liveBytes / 1024.0,
+             (long long)stats.liveAllocations, stats.peakBytes / 1024.0, (unsigned long long)stats.allocations);
+  }
+}
+
+/**
+ * Sets what happens to heap allocations inside guarded frames
+ * Note: The guard relies on the tracking allocator, so it does nothing unless built with -DENABLE_MEMORY_TRACKING
+ * @param mode The mode
+*/
+void setAllocationGuard(AllocationGuardMode mode) {
+  if (mode != AllocationGuardMode::Off && !memoryTrackingEnabled())
+    std::printf("The allocation guard needs memory tracking, build with -DENABLE_MEMORY_TRACKING\n");
+  guardMode = mode;
+}
+
+/**
+ * Returns what happens to heap allocations inside guarded frames
+ * @return The mode
+*/
+AllocationGuardMode getAllocationGuard() {
+  return guardMode;
+}
+
+/**
+ * Begins a frame in which the calling thread should not allocate
+*/
+void beginGuardedFrame() {
+  guardedFrame = 0;
+  guarded = guardMode != AllocationGuardMode::Off;
+}
+
+/**
+ * Ends a guarded frame
+ * @return The heap allocations the calling thread made during the frame
+*/
+std::uint64_t endGuardedFrame() {
+  guarded = false;
+  return guardedFrame;
+}
+
+/**
+ * Returns the heap allocations made in every guarded frame so far
+ * @return The allocations
+*/
+std::uint64_t getGuardedAllocations() {
+  return guardedTotal;
+}
+
+/**
+ * Prints each call site which allocated inside a guarded frame, with its stack, to stderr
+*/
+void printAllocationSites() {
+  std::fprintf(stderr, "%llu heap allocations inside guarded frames from %i call sites\n", (unsigned long long)guardedTotal, siteCount);
+  for (int i = 0; i < siteCount; i++) {
+    std::fprintf(stderr, "  Site %i: %llu allocations, %llu bytes\n", i + 1, (unsigned long long)sites[i].allocations, (unsigned long long)sites[i].bytes);
+    printStack(sites[i].frames, sites[i].depth);
+  }
+  if (unrecordedSites) std::fprintf(stderr, "  %llu allocations from further sites\n", (unsigned long long)unrecordedSites);
+}
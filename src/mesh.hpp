@@ -2,8 +2,14 @@
 #define MESH
 
 #include <iostream>
+#include <string>
 #include <vector>
 
+#include "VertexPipeline.hpp"
+
+// Triangle ratios of the levels generated when a mesh has none, relative to the full mesh
+#define DEFAULT_LOD_RATIOS {0.5f, 0.25f, 0.1f}
+
 /**
  * Defines a simple struct for storing 3D vectors and vertices
 */
@@ -23,6 +29,17 @@ struct Face {
   void print() { std::cout << "(" << vertex << ", " << texture << ", " << normal << "), "; }
 };
 
+/**
+ * Defines a single simplified level of detail of a mesh
+*/
+struct LODLevel {
+  std::vector<Point> vertices;
+  std::vector<unsigned int> triangles; // three vertex indices per triangle
+  VertexStream stream;
+  float ratio = 1;  // triangle count relative to the full detail mesh
+  float error = 0;  // largest quadric error of any collapse, as a distance
+};
+
 /**
  * Defines a mesh object for rendering 3D meshes from .obj files
 */
@@ -36,12 +53,48 @@ class Mesh {
     std::vector<Point> normals;
     // Faces define the points and normal vector comprising a face
     std::vector<std::vector<Face>> faces;
+    // Stream defines a structure-of-arrays copy of the vertices for batch transforms
+    VertexStream stream;
+    // Triangles define the faces fanned into triangles, as zero based vertex indices
+    std::vector<unsigned int> triangles;
+    // Bounds define the bounding sphere enclosing all vertices
+    Point boundsCenter = Point(0, 0, 0);
+    float boundsRadius = 0;
+    // LODs define progressively simplified copies of the mesh, coarsest last
+    std::vector<LODLevel> lods;
+
+    void parse(std::istream&);
+    void buildDerivedData();
+    void resetLODs();
     
   public:
+    Mesh() { };
     Mesh(const char*);
+    Mesh(const std::vector<Point>&, const std::vector<unsigned int>&);
     void readFromFile(const char*);
+    void readFromMemory(const char*, size_t);
     void troubleshoot();
+    const std::vector<Point>& getVertices() const { return vertices; };
+    const VertexStream& getVertexStream() const { return stream; };
+    const std::vector<unsigned int>& getTriangles() const { return triangles; };
+    float getBoundsRadius() const { return boundsRadius; };
+    const Point& getBoundsCenter() const { return boundsCenter; };
+    void transform(const Matrix4&, const Viewport&, ScreenVertices&, bool clipCodes=false) const;
+    size_t memoryUsage() const;
+
+    void generateLODs(const std::vector<float>&);
+    bool addLOD(const Mesh&);
+    int loadLODs(const char*);
+    bool generateMissingLODs();
+    int getLODCount() const { return lods.size(); };
+    const LODLevel& getLOD(int level) const { return lods[level]; };
+    int selectLOD(const Matrix4&, const Matrix4&, const Viewport&, float fullDetailRadius=300) const;
+    bool writeLOD(int, const char*) const;
+    void reportLODs() const;
     // void render();
 };
 
+std::string lodFilename(const std::string&, int);
+int generateLODFiles(const char*, const std::vector<float>&);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,448 @@
+#include "Mesh.hpp"
+#include "MemoryTracker.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <limits>
+#include <queue>
+#include <string>
+#include <vector>
+
+// Boundary edges are held in place by planes weighted this much heavier than surface planes
+#define BOUNDARY_WEIGHT 100.0
+#define NO_VERTEX 0xFFFFFFFFu
+
+/**
+ * Defines a symmetric 4x4 error quadric stored as its upper triangle
+*/
+struct Quadric {
+  double a[10] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+
+  Quadric() { };
+  Quadric(double x, double y, double z, double d, double weight) {
+    a[0] = x*x; a[1] = x*y; a[2] = x*z; a[3] = x*d;
+    a[4] = y*y; a[5] = y*z; a[6] = y*d;
+    a[7] = z*z; a[8] = z*d;
+    a[9] = d*d;
+    for (double &term : a) term *= weight;
+  }
+  void operator+=(const Quadric &other) { for (int i = 0; i < 10; i++) a[i] += other.a[i]; }
+
+  double error(double x, double y, double z) const {
+    return a[0]*x*x + 2*a[1]*x*y + 2*a[2]*x*z + 2*a[3]*x
+         + a[4]*y*y + 2*a[5]*y*z + 2*a[6]*y
+         + a[7]*z*z + 2*a[8]*z
+         + a[9];
+  }
+
+  // Solves for the position minimising the error, failing when the system is near singular
+  bool optimal(double &x, double &y, double &z) const {
+    double det = a[0]*(a[4]*a[7] - a[5]*a[5]) - a[1]*(a[1]*a[7] - a[5]*a[2]) + a[2]*(a[1]*a[5] - a[4]*a[2]);
+    if (std::fabs(det) < 1e-12) return false;
+    double bx = -a[3], by = -a[6], bz = -a[8];
+    x = (bx*(a[4]*a[7] - a[5]*a[5]) - a[1]*(by*a[7] - a[5]*bz) + a[2]*(by*a[5] - a[4]*bz)) / det;
+    y = (a[0]*(by*a[7] - bz*a[5]) - bx*(a[1]*a[7] - a[5]*a[2]) + a[2]*(a[1]*bz - by*a[2])) / det;
+    z = (a[0]*(a[4]*bz - a[5]*by) - a[1]*(a[1]*bz - by*a[2]) + bx*(a[1]*a[5] - a[4]*a[2])) / det;
+    return true;
+  }
+};
+
+/**
+ * Defines a candidate edge collapse, invalidated whenever either vertex changes
+*/
+struct Collapse {
+  double cost;
+  unsigned int from, to;
+  unsigned int fromVersion, toVersion;
+  float x, y, z;
+  bool operator>(const Collapse &other) const { return cost > other.cost; }
+};
+
+/**
+ * Simplifies a triangle mesh through repeated lowest-error edge collapses
+*/
+class QuadricSimplifier {
+  private:
+    std::vector<Point> positions;
+    std::vector<unsigned int> indices;
+    std::vector<Quadric> quadrics;
+    std::vector<std::vector<unsigned int>> vertexTriangles;
+    std::vector<unsigned int> versions;
+    std::vector<bool> vertexAlive, triangleAlive;
+    std::priority_queue<Collapse, std::vector<Collapse>, std::greater<Collapse>> heap;
+    size_t liveTriangles = 0;
+    double maxError = 0;
+
+    Point normal(unsigned int, unsigned int, const Point&) const;
+    bool flips(unsigned int, unsigned int, const Point&) const;
+    void pushEdge(unsigned int, unsigned int);
+    void collapse(const Collapse&);
+
+  public:
+    QuadricSimplifier(const std::vector<Point>&, const std::vector<unsigned int>&);
+    void simplify(size_t);
+    void snapshot(LODLevel&) const;
+    size_t triangleCount() const { return liveTriangles; };
+};
+
+static Point subtract(const Point &a, const Point &b) { return Point(a.x - b.x, a.y - b.y, a.z - b.z); }
+static Point cross(const Point &a, const Point &b) { return Point(a.y*b.z - a.z*b.y, a.z*b.x - a.x*b.z, a.x*b.y - a.y*b.x); }
+static float dot(const Point &a, const Point &b) { return a.x*b.x + a.y*b.y + a.z*b.z; }
+
+/**
+ * Accumulates the area weighted plane quadrics of every triangle and queues every edge
+ * @param points The vertices of the full detail mesh
+ * @param triangles Three vertex indices per triangle
+*/
+QuadricSimplifier::QuadricSimplifier(const std::vector<Point> &points, const std::vector<unsigned int> &triangles)
+    : positions(points), indices(triangles), quadrics(points.size()), vertexTriangles(points.size()),
+      versions(points.size(), 0), vertexAlive(points.size(), true), triangleAlive(triangles.size() / 3, true) {
+  liveTriangles = triangleAlive.size();
+  std::vector<std::pair<unsigned int, unsigned int>> edges;
+
+  for (unsigned int t = 0; t < triangleAlive.size(); t++) {
+    unsigned int *corner = &indices[t * 3];
+    Point n = cross(subtract(positions[corner[1]], positions[corner[0]]), subtract(positions[corner[2]], positions[corner[0]]));
+    float area = std::sqrt(dot(n, n));
+    if (area > 0) {
+      n = Point(n.x / area, n.y / area, n.z / area);
+      Quadric plane(n.x, n.y, n.z, -dot(n, positions[corner[0]]), area);
+      for (int c = 0; c < 3; c++) quadrics[corner[c]] += plane;
+    }
+    for (int c = 0; c < 3; c++) {
+      vertexTriangles[corner[c]].push_back(t);
+      unsigned int a = corner[c], b = corner[(c + 1) % 3];
+      edges.emplace_back(std::min(a, b), std::max(a, b));
+    }
+  }
+
+  // Edges used by a single triangle lie on a boundary and are pinned by a perpendicular plane
+  std::sort(edges.begin(), edges.end());
+  for (size_t i = 0; i < edges.size();) {
+    size_t j = i;
+    while (j < edges.size() && edges[j] == edges[i]) j++;
+    if (j - i == 1) {
+      unsigned int a = edges[i].first, b = edges[i].second;
+      for (unsigned int t : vertexTriangles[a]) {
+        unsigned int *corner = &indices[t * 3];
+        if (corner[0] != b && corner[1] != b && corner[2] != b) continue;
+        Point edge = subtract(positions[b], positions[a]);
+        Point perpendicular = cross(edge, normal(t, NO_VERTEX, positions[a]));
+        float length = std::sqrt(dot(perpendicular, perpendicular));
+        if (length == 0) break;
+        perpendicular = Point(perpendicular.x / length, perpendicular.y / length, perpendicular.z / length);
+        Quadric plane(perpendicular.x, perpendicular.y, perpendicular.z, -dot(perpendicular, positions[a]), BOUNDARY_WEIGHT * dot(edge, edge));
+        quadrics[a] += plane;
+        quadrics[b] += plane;
+        break;
+      }
+    }
+    pushEdge(edges[i].first, edges[i].second);
+    i = j;
+  }
+}
+
+/**
+ * Computes the unit normal of a triangle with one of its vertices moved
+ * @param t The triangle index
+ * @param moved The vertex being moved, or a vertex outside the triangle to leave it as is
+ * @param position The new position of the moved vertex
+ * @return The unit normal, or zero for degenerate triangles
+*/
+Point QuadricSimplifier::normal(unsigned int t, unsigned int moved, const Point &position) const {
+  Point corner[3] = {positions[indices[t*3]], positions[indices[t*3 + 1]], positions[indices[t*3 + 2]]};
+  for (int c = 0; c < 3; c++) if (indices[t*3 + c] == moved) corner[c] = position;
+  Point n = cross(subtract(corner[1], corner[0]), subtract(corner[2], corner[0]));
+  float length = std::sqrt(dot(n, n));
+  return length > 0 ? Point(n.x / length, n.y / length, n.z / length) : Point(0, 0, 0);
+}
+
+/**
+ * Checks whether moving a vertex would fold any surviving triangle over
+ * @param vertex The vertex being moved
+ * @param other The vertex it is collapsing with, whose shared triangles disappear
+ * @param position The new position
+ * @return Whether any triangle would flip
+*/
+bool QuadricSimplifier::flips(unsigned int vertex, unsigned int other, const Point &position) const {
+  for (unsigned int t : vertexTriangles[vertex]) {
+    if (!triangleAlive[t]) continue;
+    const unsigned int *corner = &indices[t * 3];
+    if (corner[0] == other || corner[1] == other || corner[2] == other) continue;
+    Point before = normal(t, vertex, positions[vertex]);
+    Point after = normal(t, vertex, position);
+    if (dot(before, before) > 0 && dot(before, after) < 0.2f) return true;
+  }
+  return false;
+}
+
+/**
+ * Queues the cheapest collapse of an edge
+ * @param a The first vertex of the edge
+ * @param b The second vertex of the edge
+*/
+void QuadricSimplifier::pushEdge(unsigned int a, unsigned int b) {
+  Quadric combined = quadrics[a];
+  combined += quadrics[b];
+  double x, y, z;
+
+  // Fall back on the cheapest of the endpoints and midpoint when the optimum is undefined, or the midpoint if every cost is NaN
+  if (!combined.optimal(x, y, z)) {
+    const Point &pa = positions[a], &pb = positions[b];
+    Point candidates[3] = {pa, pb, Point((pa.x + pb.x) / 2, (pa.y + pb.y) / 2, (pa.z + pb.z) / 2)};
+    x = candidates[2].x; y = candidates[2].y; z = candidates[2].z;
+    double best = std::numeric_limits<double>::max();
+    for (auto &candidate : candidates) {
+      double cost = combined.error(candidate.x, candidate.y, candidate.z);
+      if (cost < best) { best = cost; x = candidate.x; y = candidate.y; z = candidate.z; }
+    }
+  }
+
+  double cost = std::max(0.0, combined.error(x, y, z));
+  heap.push(Collapse{cost, b, a, versions[b], versions[a], (float)x, (float)y, (float)z});
+}
+
+/**
+ * Merges one vertex into another, removing the triangles which become degenerate
+ * @param edge The collapse being applied
+*/
+void QuadricSimplifier::collapse(const Collapse &edge) {
+  unsigned int from = edge.from, to = edge.to;
+  positions[to] = Point(edge.x, edge.y, edge.z);
+  quadrics[to] += quadrics[from];
+  vertexAlive[from] = false;
+  versions[to]++;
+  maxError = std::max(maxError, edge.cost);
+
+  for (unsigned int t : vertexTriangles[from]) {
+    if (!triangleAlive[t]) continue;
+    unsigned int *corner = &indices[t * 3];
+    if (corner[0] == to || corner[1] == to || corner[2] == to) {
+      triangleAlive[t] = false;
+      liveTriangles--;
+      continue;
+    }
+    for (int c = 0; c < 3; c++) if (corner[c] == from) corner[c] = to;
+    vertexTriangles[to].push_back(t);
+  }
+  vertexTriangles[from].clear();
+
+  // Drop dead triangles and requeue every edge around the merged vertex
+  auto &around = vertexTriangles[to];
+  around.erase(std::remove_if(around.begin(), around.end(), [&](unsigned int t) { return !triangleAlive[t]; }), around.end());
+  std::vector<unsigned int> neighbours;
+  for (unsigned int t : around)
+    for (int c = 0; c < 3; c++) if (indices[t*3 + c] != to) neighbours.push_back(indices[t*3 + c]);
+  std::sort(neighbours.begin(), neighbours.end());
+  neighbours.erase(std::unique(neighbours.begin(), neighbours.end()), neighbours.end());
+  for (unsigned int neighbour : neighbours) pushEdge(to, neighbour);
+}
+
+/**
+ * Collapses edges in order of increasing error until the triangle budget is met
+ * @param targetTriangles The number of triangles to stop at
+*/
+void QuadricSimplifier::simplify(size_t targetTriangles) {
+  while (liveTriangles > targetTriangles && !heap.empty()) {
+    Collapse edge = heap.top();
+    heap.pop();
+    if (!vertexAlive[edge.from] || !vertexAlive[edge.to]) continue;
+    if (versions[edge.from] != edge.fromVersion || versions[edge.to] != edge.toVersion) continue;
+
+    Point position(edge.x, edge.y, edge.z);
+    if (flips(edge.from, edge.to, position) || flips(edge.to, edge.from, position)) continue;
+    collapse(edge);
+  }
+}
+
+/**
+ * Copies the surviving geometry into a compacted level of detail
+ * @param level The level being written, keeping its ratio
+*/
+void QuadricSimplifier::snapshot(LODLevel &level) const {
+  std::vector<int> remap(positions.size(), -1);
+  level.vertices.clear();
+  level.triangles.clear();
+  for (size_t t = 0; t < triangleAlive.size(); t++) {
+    if (!triangleAlive[t]) continue;
+    for (int c = 0; c < 3; c++) {
+      unsigned int vertex = indices[t*3 + c];
+      if (remap[vertex] < 0) {
+        remap[vertex] = level.vertices.size();
+        level.vertices.push_back(positions[vertex]);
+      }
+      level.triangles.push_back(remap[vertex]);
+    }
+  }
+  level.stream.assign(level.vertices);
+  level.error = std::sqrt(maxError);
+}
+
+/**
+ * Generates a chain of simplified meshes through quadric error edge collapse
+ * Note: Levels are produced by one continuous simplification so each is derived from the last
+ * @param ratios The triangle ratios of each level relative to the full mesh, e.g. {0.5, 0.25, 0.1}
+*/
+void Mesh::generateLODs(const std::vector<float> &ratios) {
+  MEMORY_TAG(MemoryTag::Mesh);
+  resetLODs();
+
+  std::vector<float> sorted(ratios);
+  std::sort(sorted.begin(), sorted.end(), std::greater<float>());
+  QuadricSimplifier simplifier(vertices, triangles);
+  size_t fullCount = triangles.size() / 3;
+
+  for (float ratio : sorted) {
+    if (ratio >= 1 || ratio <= 0) continue;
+    simplifier.simplify((size_t)(fullCount * ratio));
+    LODLevel level;
+    simplifier.snapshot(level);
+    level.ratio = fullCount ? (float)simplifier.triangleCount() / fullCount : 0;
+    lods.push_back(level);
+  }
+}
+
+/**
+ * Replaces the levels of detail with the full detail mesh alone, as level 0
+*/
+void Mesh::resetLODs() {
+  lods.clear();
+  LODLevel full;
+  full.vertices = vertices;
+  full.triangles = triangles;
+  full.stream = stream;
+  lods.push_back(full);
+}
+
+/**
+ * Appends a simplified copy of the mesh as the next coarser level of detail
+ * Note: The full detail mesh becomes level 0 on the first call
+ * @param level The simplified mesh, such as one read from a file written by generateLODFiles
+ * @return Whether both meshes held triangles, so the level was added
+*/
+bool Mesh::addLOD(const Mesh &level) {
+  if (triangles.empty() || level.triangles.empty()) return false;
+  MEMORY_TAG(MemoryTag::Mesh);
+  if (lods.empty()) resetLODs();
+  LODLevel lod;
+  lod.vertices = level.vertices;
+  lod.triangles = level.triangles;
+  lod.stream = level.stream;
+  lod.ratio = (float)level.triangles.size() / triangles.size();
+  lods.push_back(std::move(lod));
+  return true;
+}
+
+/**
+ * Loads the levels of detail written beside an .obj file, stopping at the first one missing
+ * @param filename The full detail .obj file
+ * @return The number of levels loaded
+*/
+int Mesh::loadLODs(const char *filename) {
+  int loaded = 0;
+  for (int level = 1; ; level++) {
+    std::string path = lodFilename(filename, level);
+    if (!std::ifstream(path) || !addLOD(Mesh(path.c_str()))) return loaded;
+    loaded++;
+  }
+}
+
+/**
+ * Generates the levels of DEFAULT_LOD_RATIOS when none were loaded, such as for meshes without name_lodN.obj files
+ * @return Whether levels were generated
+*/
+bool Mesh::generateMissingLODs() {
+  if (!lods.empty() || triangles.empty()) return false;
+  generateLODs(DEFAULT_LOD_RATIOS);
+  return true;
+}
+
+/**
+ * Picks the level of detail whose triangle density suits the projected size of the mesh
+ * Note: An orthographic projection keeps the same size at any depth, so only its scale is used
+ * @param modelView The transform from model space into view space
+ * @param projection The projection matrix, whose vertical focal length or scale sizes the bounds
+ * @param viewport The screen rectangle being rendered to
+ * @param fullDetailRadius The projected radius in pixels at which the full mesh is used @def{300}
+ * @return The selected level, where 0 is the full detail mesh
+*/
+int Mesh::selectLOD(const Matrix4 &modelView, const Matrix4 &projection, const Viewport &viewport, float fullDetailRadius) const {
+  if (lods.size() < 2) return 0;
+  const float *m = modelView.m;
+  float scale = std::sqrt(m[0]*m[0] + m[4]*m[4] + m[8]*m[8]);
+  float screenRadius = boundsRadius * scale * projection.m[5] * viewport.height / 2;
+  if (projection.m[14] != 0) {
+    float depth = -(m[8]*boundsCenter.x + m[9]*boundsCenter.y + m[10]*boundsCenter.z + m[11]);
+    if (depth <= boundsRadius * scale) return 0;
+    screenRadius /= depth;
+  }
+
+  // Keep the triangles per pixel roughly constant, so the ratio falls with projected area
+  int selected = 0;
+  for (size_t i = 1; i < lods.size(); i++)
+    if (screenRadius <= fullDetailRadius * std::sqrt(lods[i].ratio)) selected = i;
+  return selected;
+}
+
+/**
+ * Writes a level of detail as an .obj file
+ * @param level The level being written
+ * @param filename The output path
+ * @return Whether the file was written
+*/
+bool Mesh::writeLOD(int level, const char *filename) const {
+  std::ofstream file(filename);
+  if (!file || level < 0 || level >= (int)lods.size()) return false;
+  const LODLevel &lod = lods[level];
+  file << "# LOD " << level << ": " << lod.triangles.size() / 3 << " triangles, error " << lod.error << "\n";
+  for (auto &vertex : lod.vertices) file << "v " << vertex.x << " " << vertex.y << " " << vertex.z << "\n";
+  for (size_t i = 0; i + 2 < lod.triangles.size(); i += 3)
+    file << "f " << lod.triangles[i] + 1 << " " << lod.triangles[i + 1] + 1 << " " << lod.triangles[i + 2] + 1 << "\n";
+  return true;
+}
+
+/**
+ * Prints the vertex count, triangle count and error of each level of detail
+*/
+void Mesh::reportLODs() const {
+  for (size_t i = 0; i < lods.size(); i++) {
+    std::printf("LOD %zu: %8zu vertices %8zu triangles  ratio %.3f  error %.5f\n",
+      i, lods[i].vertices.size(), lods[i].triangles.size() / 3, lods[i].ratio, lods[i].error);
+  }
+}
+
+/**
+ * Names the file a level of detail is written to beside its source
+ * @param filename The full detail .obj file
+ * @param level The level of detail
+ * @return The path, as name_lodN.obj
+*/
+std::string lodFilename(const std::string &filename, int level) {
+  std::string base(filename);
+  if (base.size() > 4 && base.compare(base.size() - 4, 4, ".obj") == 0) base.resize(base.size() - 4);
+  return base + "_lod" + std::to_string(level) + ".obj";
+}
+
+/**
+ * Generates levels of detail offline, writing each beside the source as name_lodN.obj
+ * @param filename The .obj file being simplified
+ * @param ratios The triangle ratios of each level relative to the full mesh
+ * @return The process exit code
+*/
+int generateLODFiles(const char *filename, const std::vector<float> &ratios) {
+  Mesh mesh(filename);
+  if (mesh.getTriangles().empty()) return 1;
+  mesh.generateLODs(ratios);
+  mesh.reportLODs();
+
+  for (int level = 1; level < mesh.getLODCount(); level++) {
+    std::string output = lodFilename(filename, level);
+    if (!mesh.writeLOD(level, output.c_str())) {
+      std::cout << "Failed to write file: *" << output << "*" << std::endl;
+      return 1;
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,230 @@
+#include "ParticleSystem.hpp"
+#include "Profiler.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define PARTICLE_SSE
+#endif
+
+/**
+ * Allocates room for a number of particles plus the SIMD padding
+ * @param particles The most particles the pool holds
+*/
+void ParticlePool::reserve(size_t particles) {
+  size_t padded = particles + PARTICLE_PADDING;
+  for (auto *array : {&x, &y, &vx, &vy, &life, &invLife, &size}) array->resize(padded, 0.f);
+  startColor.resize(padded);
+  endColor.resize(padded);
+}
+
+/**
+ * Moves every particle along its velocity, applies gravity and drag, and ages it
+ * Note: Padding lanes are integrated too, which is harmless since they are never drawn
+ * @param dt The time step in seconds
+ * @param gravity The acceleration applied to every particle
+ * @param drag The fraction of velocity lost per second
+*/
+void ParticlePool::integrate(float dt, sf::Vector2f gravity, float drag) {
+  size_t padded = paddedCount();
+  float damping = std::max(0.f, 1.f - drag * dt), gx = gravity.x * dt, gy = gravity.y * dt;
+  float *px = x.data(), *py = y.data(), *pvx = vx.data(), *pvy = vy.data(), *plife = life.data();
+
+#if defined(__AVX2__)
+  __m256 step = _mm256_set1_ps(dt), damp = _mm256_set1_ps(damping), ax = _mm256_set1_ps(gx), ay = _mm256_set1_ps(gy);
+  for (size_t i = 0; i < padded; i += 8) {
+    __m256 velocityX = _mm256_loadu_ps(pvx + i), velocityY = _mm256_loadu_ps(pvy + i);
+    _mm256_storeu_ps(px + i, _mm256_add_ps(_mm256_loadu_ps(px + i), _mm256_mul_ps(velocityX, step)));
+    _mm256_storeu_ps(py + i, _mm256_add_ps(_mm256_loadu_ps(py + i), _mm256_mul_ps(velocityY, step)));
+    _mm256_storeu_ps(pvx + i, _mm256_add_ps(_mm256_mul_ps(velocityX, damp), ax));
+    _mm256_storeu_ps(pvy + i, _mm256_add_ps(_mm256_mul_ps(velocityY, damp), ay));
+    _mm256_storeu_ps(plife + i, _mm256_sub_ps(_mm256_loadu_ps(plife + i), step));
+  }
+#elif defined(PARTICLE_SSE)
+  __m128 step = _mm_set1_ps(dt), damp = _mm_set1_ps(damping), ax = _mm_set1_ps(gx), ay = _mm_set1_ps(gy);
+  for (size_t i = 0; i < padded; i += 4) {
+    __m128 velocityX = _mm_loadu_ps(pvx + i), velocityY = _mm_loadu_ps(pvy + i);
+    _mm_storeu_ps(px + i, _mm_add_ps(_mm_loadu_ps(px + i), _mm_mul_ps(velocityX, step)));
+    _mm_storeu_ps(py + i, _mm_add_ps(_mm_loadu_ps(py + i), _mm_mul_ps(velocityY, step)));
+    _mm_storeu_ps(pvx + i, _mm_add_ps(_mm_mul_ps(velocityX, damp), ax));
+    _mm_storeu_ps(pvy + i, _mm_add_ps(_mm_mul_ps(velocityY, damp), ay));
+    _mm_storeu_ps(plife + i, _mm_sub_ps(_mm_loadu_ps(plife + i), step));
+  }
+#else
+  for (size_t i = 0; i < padded; i++) {
+    px[i] += pvx[i] * dt;
+    py[i] += pvy[i] * dt;
+    pvx[i] = pvx[i] * damping + gx;
+    pvy[i] = pvy[i] * damping + gy;
+    plife[i] -= dt;
+  }
+#endif
+}
+
+/**
+ * Removes expired particles by moving the last live particle into each gap, so order is not preserved
+*/
+void ParticlePool::removeDead() {
+  size_t i = 0;
+  while (i < count) {
+    if (life[i] > 0) {
+      i++;
+      continue;
+    }
+    size_t last = --count;
+    x[i] = x[last];
+    y[i] = y[last];
+    vx[i] = vx[last];
+    vy[i] = vy[last];
+    life[i] = life[last];
+    invLife[i] = invLife[last];
+    size[i] = size[last];
+    startColor[i] = startColor[last];
+    endColor[i] = endColor[last];
+  }
+}
+
+/**
+ * Writes a square of two triangles per particle, fading its colour from start to end over its lifetime
+*/
+void ParticlePool::buildVertices() {
+  vertices.resize(count * VERTICES_PER_PARTICLE);
+  if (count == 0) return;
+  sf::Vertex *out = &vertices[0];
+  for (size_t i = 0; i < count; i++, out += VERTICES_PER_PARTICLE) {
+    float t = std::clamp(life[i] * invLife[i], 0.f, 1.f);
+    const sf::Color &from = endColor[i], &to = startColor[i];
+    sf::Color color(from.r + (to.r - from.r) * t, from.g + (to.g - from.g) * t, from.b + (to.b - from.b) * t, from.a + (to.a - from.a) * t);
+    float half = size[i] * 0.5f, left = x[i] - half, right = x[i] + half, top = y[i] - half, bottom = y[i] + half;
+    // Fields are written directly since sf::Vertex's constructors are not inline
+    out[0].position.x = left;  out[0].position.y = top;
+    out[1].position.x = right; out[1].position.y = top;
+    out[2].position.x = left;  out[2].position.y = bottom;
+    out[3].position.x = left;  out[3].position.y = bottom;
+    out[4].position.x = right; out[4].position.y = top;
+    out[5].position.x = right; out[5].position.y = bottom;
+    for (int v = 0; v < VERTICES_PER_PARTICLE; v++) out[v].color = color;
+  }
+}
+
+/**
+ * Constructs a particle system
+ * @param capacity The most particles each blend mode can hold at once @def{DEFAULT_PARTICLE_CAPACITY}
+*/
+ParticleSystem::ParticleSystem(size_t capacity) {
+  for (auto &pool : pools) pool.reserve(capacity);
+}
+
+/**
+ * Adds an emitter which spawns particles continuously at its rate
+ * @param settings The emitter settings
+ * @return The index of the emitter
+*/
+int ParticleSystem::addEmitter(const EmitterSettings &settings) {
+  Emitter emitter;
+  emitter.settings = settings;
+  emitters.push_back(emitter);
+  return emitters.size() - 1;
+}
+
+/**
+ * Spawns particles from an emitter's settings, dropping any beyond the pool's capacity
+ * @param settings The emitter settings
+ * @param particles The number of particles spawned
+*/
+void ParticleSystem::spawn(const EmitterSettings &settings, int particles) {
+  ParticlePool &pool = pools[(int)settings.blend];
+  std::uniform_real_distribution<float> angle(settings.angle - settings.spread / 2, settings.angle + settings.spread / 2);
+  std::uniform_real_distribution<float> speed(settings.minSpeed, settings.maxSpeed);
+  std::uniform_real_distribution<float> lifetime(settings.minLife, std::max(settings.minLife, settings.maxLife));
+
+  for (int n = 0; n < particles && pool.count < pool.capacity(); n++) {
+    size_t i = pool.count++;
+    float direction = angle(rng), velocity = speed(rng), life = std::max(lifetime(rng), 1e-3f);
+    pool.x[i] = settings.position.x;
+    pool.y[i] = settings.position.y;
+    pool.vx[i] = std::cos(direction) * velocity;
+    pool.vy[i] = std::sin(direction) * velocity;
+    pool.life[i] = life;
+    pool.invLife[i] = 1 / life;
+    pool.size[i] = settings.size;
+    pool.startColor[i] = settings.startColor;
+    pool.endColor[i] = settings.endColor;
+  }
+}
+
+/**
+ * Spawns from the emitters, simulates every particle and rebuilds the vertex arrays
+ * @param dt The time step in seconds
+*/
+void ParticleSystem::update(float dt) {
+  PROFILE_SCOPE("ParticleSystem::update");
+  for (auto &emitter : emitters) {
+    if (!emitter.active || emitter.settings.rate <= 0) continue;
+    emitter.accumulator += emitter.settings.rate * dt;
+    int particles = emitter.accumulator;
+    emitter.accumulator -= particles;
+    spawn(emitter.settings, particles);
+  }
+  simulate(dt);
+  buildVertices();
+}
+
+/**
+ * Integrates every particle and removes those which expired
+ * @param dt The time step in seconds
+*/
+void ParticleSystem::simulate(float dt) {
+  for (auto &pool : pools) {
+    pool.integrate(dt, gravity, drag);
+    pool.removeDead();
+  }
+}
+
+/**
+ * Rebuilds the vertex array of every pool
+*/
+void ParticleSystem::buildVertices() {
+  for (auto &pool : pools) pool.buildVertices();
+}
+
+/**
+ * Returns the number of live particles across every pool
+ * @return The particle count
+*/
+size_t ParticleSystem::getCount() const {
+  size_t total = 0;
+  for (auto &pool : pools) total += pool.count;
+  return total;
+}
+
+/**
+ * Draws each pool with one call in its blend mode
+*/
+void ParticleSystem::draw(sf::RenderTarget &target, sf::RenderStates states) const {
+  static const sf::BlendMode modes[] = {sf::BlendAlpha, sf::BlendAdd};
+  for (int i = 0; i < (int)ParticleBlend::Count; i++) {
+    if (pools[i].count == 0) continue;
+    states.blendMode = modes[i];
+    target.draw(pools[i].vertices, states);
+  }
+}
+
+/**
+ * Returns the instruction set the particle kernel was compiled for
+ * @return The name of the instruction set
+*/
+const char* particleInstructionSet() {
+#if defined(__AVX2__)
+  return "AVX2";
+#elif defined(PARTICLE_SSE)
+  return "SSE2";
+#else
+  return "scalar";
+#endif
+}
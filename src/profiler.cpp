@@ -0,0 +1,191 @@
+#include "Profiler.hpp"
+#include "Logger.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+/**
+ * Constructs the profiler, starting the first frame now
+*/
+Profiler::Profiler() {
+  frameStarts[0] = now();
+}
+
+/**
+ * Returns the profiler shared by every thread
+ * @return The profiler
+*/
+Profiler& Profiler::get() {
+  static Profiler profiler;
+  return profiler;
+}
+
+/**
+ * Returns the current time on the steady clock
+ * @return The time in nanoseconds
+*/
+std::uint64_t Profiler::now() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * Creates the zone ring of the calling thread, kept until exit so traces can include threads which have finished
+ * @return The thread's ring
+*/
+ProfileThread* Profiler::registerThread() {
+  std::lock_guard<std::mutex> lock(threadMutex);
+  threads.push_back(std::make_unique<ProfileThread>());
+  ProfileThread *created = threads.back().get();
+  created->id = threads.size() - 1;
+  created->name = "Thread " + std::to_string(created->id);
+  return created;
+}
+
+/**
+ * Names the calling thread in exported traces
+ * @param name The thread's name
+*/
+void Profiler::setThreadName(const char *name) {
+  ProfileThread &current = thread();
+  std::lock_guard<std::mutex> lock(threadMutex);
+  current.name = name;
+}
+
+/**
+ * Copies a thread's zones which started within a time range
+ * Note: Zones are recorded as they end, so the scan walks back from the newest until zones ended before the range.
+ * Any zone the thread may have overwritten during the copy is discarded
+ * @param thread The thread's ring
+ * @param from The start of the range in nanoseconds
+ * @param to The end of the range in nanoseconds
+ * @param out The vector the zones are appended to
+*/
+void Profiler::collect(const ProfileThread &thread, std::uint64_t from, std::uint64_t to, std::vector<ProfileEvent> &out) const {
+  std::uint64_t written = thread.written.load(std::memory_order_acquire);
+  std::uint64_t oldest = written > PROFILE_RING_SIZE ? written - PROFILE_RING_SIZE : 0;
+  size_t first = out.size();
+  std::uint64_t index = written;
+  for (; index > oldest; index--) {
+    const ProfileEvent &event = thread.events[(index - 1) & (PROFILE_RING_SIZE - 1)];
+    if (event.end < from) break;
+    if (event.start >= from && event.start < to) out.push_back(event);
+  }
+
+  std::uint64_t rewritten = thread.written.load(std::memory_order_acquire);
+  if (rewritten - oldest <= PROFILE_RING_SIZE) return;
+  // Zones are appended newest first, so those at risk are at the tail
+  std::uint64_t safe = rewritten - PROFILE_RING_SIZE, kept = written > safe ? written - safe : 0;
+  out.resize(std::min(out.size(), first + (size_t)kept));
+}
+
+/**
+ * Ends the current frame, aggregating the calling thread's zones within it into a call tree
+ * Note: Calls of the same zone under the same parent are merged, summing their times
+*/
+void Profiler::endFrame() {
+  std::uint64_t end = now(), start = frameStarts[frame % PROFILE_FRAME_HISTORY];
+  std::vector<ProfileEvent> events;
+  collect(thread(), start, end, events);
+  std::sort(events.begin(), events.end(), [](const ProfileEvent &a, const ProfileEvent &b) {
+    return a.start != b.start ? a.start < b.start : a.depth < b.depth;
+  });
+
+  lastFrame.clear();
+  std::uint32_t base = events.empty() ? 0 : events.front().depth;
+  std::vector<int> stack;
+  for (auto &event : events) {
+    int depth = std::max<int>(0, event.depth - base);
+    stack.resize(std::min<size_t>(stack.size(), depth));
+    int parent = stack.empty() ? -1 : stack.back();
+    int node = -1;
+    for (int i = parent + 1; i < (int)lastFrame.size() && node < 0; i++)
+      if (lastFrame[i].parent == parent && lastFrame[i].name == event.name) node = i;
+    if (node < 0) {
+      lastFrame.push_back(ProfileNode{event.name, parent, (int)stack.size()});
+      node = lastFrame.size() - 1;
+    }
+    lastFrame[node].milliseconds += (event.end - event.start) * 1e-6;
+    lastFrame[node].calls++;
+    stack.push_back(node);
+  }
+
+  frame++;
+  frameStarts[frame % PROFILE_FRAME_HISTORY] = end;
+}
+
+/**
+ * Logs a node of the last frame's call tree and its children, indented by depth
+ * Note: The logger takes no field widths from arguments, so the indented name is formatted here
+ * @param node The index of the node
+*/
+void Profiler::logNode(int node) const {
+  const ProfileNode &zone = lastFrame[node];
+  char name[64];
+  std::snprintf(name, sizeof(name), "%*s%s", zone.depth * 2, "", zone.name);
+  LOG_INFO(LogCategory::Performance, "%-40s %9.3f ms %6i calls", name, zone.milliseconds, zone.calls);
+  for (int i = node + 1; i < (int)lastFrame.size(); i++)
+    if (lastFrame[i].parent == node) logNode(i);
+}
+
+/**
+ * Logs the call tree of the last frame
+*/
+void Profiler::logLastFrame() const {
+  LOG_INFO(LogCategory::Performance, "Profile of frame %llu", (unsigned long long)frame - 1);
+  for (int i = 0; i < (int)lastFrame.size(); i++)
+    if (lastFrame[i].parent < 0) logNode(i);
+}
+
+/**
+ * Writes every thread's zones within a range of finished frames as a Chrome trace, viewable in chrome://tracing or Perfetto
+ * @param filename The .json file written
+ * @param first The first frame exported, clamped to those still held
+ * @param last The last frame exported, clamped to the last finished frame
+ * @return Whether any frame was exported
+*/
+bool Profiler::exportChromeTrace(const char *filename, std::uint64_t first, std::uint64_t last) const {
+  if (frame == 0) return false;
+  std::uint64_t oldest = frame > PROFILE_FRAME_HISTORY - 1 ? frame - (PROFILE_FRAME_HISTORY - 1) : 0;
+  first = std::max(first, oldest);
+  last = std::min(last, frame - 1);
+  if (first > last) return false;
+
+  FILE *file = std::fopen(filename, "w");
+  if (!file) {
+    std::printf("Failed to write file: *%s*\n", filename);
+    return false;
+  }
+
+  std::uint64_t from = frameStarts[first % PROFILE_FRAME_HISTORY], to = frameStarts[(last + 1) % PROFILE_FRAME_HISTORY];
+  std::fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+  bool separate = false;
+  for (std::uint64_t f = first; f <= last; f++) {
+    double at = (frameStarts[f % PROFILE_FRAME_HISTORY] - from) * 1e-3;
+    std::fprintf(file, "%s{\"name\":\"Frame %llu\",\"ph\":\"i\",\"s\":\"g\",\"pid\":0,\"tid\":0,\"ts\":%.3f}", separate ? ",\n" : "", (unsigned long long)f, at);
+    separate = true;
+  }
+
+  std::lock_guard<std::mutex> lock(threadMutex);
+  std::vector<ProfileEvent> events;
+  for (auto &thread : threads) {
+    std::fprintf(file, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%u,\"args\":{\"name\":\"%s\"}}", thread->id, thread->name.c_str());
+    events.clear();
+    collect(*thread, from, to, events);
+    for (auto &event : events) {
+      // Zone names are literals in the source, so only quotes and backslashes need escaping
+      std::string name;
+      for (const char *c = event.name; *c; c++) {
+        if (*c == '"' || *c == '\\') name += '\\';
+        name += *c;
+      }
+      std::fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":0,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+                   name.c_str(), thread->id, (event.start - from) * 1e-3, (event.end - event.start) * 1e-3);
+    }
+  }
+  std::fprintf(file, "\n]}\n");
+  std::fclose(file);
+  return true;
+}
@@ -0,0 +1,243 @@
+#include "Regression.hpp"
+#include "Benchmark.hpp"
+#include "Headless.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Scales the median absolute deviation to the standard deviation of normally distributed noise
+#define MAD_TO_SIGMA 1.4826
+
+// Sections of the benchmark suite checked by default; any other section can be checked alone with --filter
+static const char *DEFAULT_SECTIONS[] = {"entities", "manager", "mesh", "particles", "visibility"};
+
+/**
+ * Returns the median of some values, reordering them
+ * @param values The values
+ * @return The median, or 0 for none
+*/
+static double medianOf(std::vector<double> &values) {
+  if (values.empty()) return 0;
+  std::sort(values.begin(), values.end());
+  size_t middle = values.size() / 2;
+  return values.size() % 2 ? values[middle] : (values[middle - 1] + values[middle]) / 2;
+}
+
+/**
+ * Summarises repeated timings by their median and median absolute deviation, which a few outliers cannot skew
+ * @param name The metric's name
+ * @param samples The timings in milliseconds
+ * @return The metric
+*/
+RegressionMetric summarise(const std::string &name, std::vector<double> samples) {
+  RegressionMetric metric;
+  metric.name = name;
+  metric.samples = samples.size();
+  metric.median = medianOf(samples);
+  for (auto &sample : samples) sample = std::fabs(sample - metric.median);
+  metric.mad = medianOf(samples);
+  return metric;
+}
+
+/**
+ * Reads the metrics of a baseline written by writeBaseline
+ * @param filename The baseline's .json file
+ * @param metrics The vector the metrics are read into
+ * @return Whether the file could be read
+*/
+bool readBaseline(const char *filename, std::vector<RegressionMetric> &metrics) {
+  std::ifstream file(filename);
+  if (!file) return false;
+  std::string text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+  // Each metric is an object holding its name, then its statistics
+  auto number = [&](const char *key, size_t from, size_t to) {
+    size_t found = text.find(key, from);
+    return found < to ? std::strtod(text.c_str() + found + std::strlen(key), nullptr) : 0.0;
+  };
+  const char *nameKey = "\"name\": \"";
+  metrics.clear();
+  for (size_t at = text.find(nameKey); at != std::string::npos;) {
+    RegressionMetric metric;
+    size_t i = at + std::strlen(nameKey);
+    for (; i < text.size() && text[i] != '"'; i++) {
+      if (text[i] == '\\' && i + 1 < text.size()) i++;
+      metric.name += text[i];
+    }
+    size_t next = text.find(nameKey, i), end = std::min(next, text.size());
+    metric.median = number("\"median_ms\":", i, end);
+    metric.mad = number("\"mad_ms\":", i, end);
+    metric.samples = number("\"samples\":", i, end);
+    metrics.push_back(metric);
+    at = next;
+  }
+  return true;
+}
+
+/**
+ * Writes metrics as a baseline
+ * @param filename The .json file written
+ * @param metrics The metrics
+ * @return Whether the file was written
+*/
+bool writeBaseline(const char *filename, const std::vector<RegressionMetric> &metrics) {
+  std::ofstream file(filename);
+  if (!file) {
+    std::printf("Failed to write file: *%s*\n", filename);
+    return false;
+  }
+  file << "{\n  \"note\": \"Recorded with --regress --update on the reference machine; timings from other machines are not comparable\",\n";
+  file << "  \"metrics\": [\n";
+  for (size_t i = 0; i < metrics.size(); i++) {
+    std::string name;
+    for (char c : metrics[i].name) {
+      if (c == '"' || c == '\\') name += '\\';
+      name += c;
+    }
+    char line[512];
+    std::snprintf(line, sizeof(line), "    {\"name\": \"%s\", \"median_ms\": %.6f, \"mad_ms\": %.6f, \"samples\": %i}%s\n",
+                  name.c_str(), metrics[i].median, metrics[i].mad, metrics[i].samples, i + 1 < metrics.size() ? "," : "");
+    file << line;
+  }
+  file << "  ]\n}\n";
+  return true;
+}
+
+/**
+ * Runs the benchmark sections and headless scenarios, summarising each timing
+ * @param settings The check's settings
+ * @return The metrics
+*/
+static std::vector<RegressionMetric> collectMetrics(const RegressionSettings &settings) {
+  std::vector<RegressionMetric> metrics;
+  if (settings.filter) runBenchmarks(settings.filter);
+  else for (const char *section : DEFAULT_SECTIONS) runBenchmarks(section);
+  for (auto &[name, result] : getRecordedResults()) {
+    std::vector<double> samples;
+    for (double seconds : result.samples) samples.push_back(seconds * 1e3);
+    metrics.push_back(summarise(name, samples));
+  }
+  if (settings.filter && std::strcmp(settings.filter, "headless") != 0) return metrics;
+
+  // Each scenario's phases are averaged per run, and the runs then summarised, so the noise between whole runs is measured
+  struct Scenario {
+    const char *name;
+    HeadlessSettings settings;
+  };
+  std::vector<Scenario> scenarios(3);
+  scenarios[0].name = "headless/10k entities";
+  scenarios[0].settings.entities = 10000;
+  scenarios[0].settings.ticks = scenarios[0].settings.frames = 300;
+  scenarios[1].name = "headless/100k entities";
+  scenarios[1].settings.entities = 100000;
+  scenarios[1].settings.ticks = scenarios[1].settings.frames = 60;
+  scenarios[2].name = "headless/256x256 random level";
+  scenarios[2].settings.randomLevel = 256;
+  scenarios[2].settings.ticks = scenarios[2].settings.frames = 120;
+
+  for (auto &scenario : scenarios) {
+    std::printf("%s\n", scenario.name);
+    std::vector<double> update, cull, build, submit, frame;
+    for (int run = 0; run < REGRESSION_RUNS; run++) {
+      HeadlessReport report = measureHeadless(scenario.settings);
+      update.push_back(report.update.getMean());
+      cull.push_back(report.cull.getMean());
+      build.push_back(report.build.getMean());
+      submit.push_back(report.submit.getMean());
+      frame.push_back(report.frame.percentile(50));
+    }
+    std::string prefix = std::string(scenario.name) + "/";
+    metrics.push_back(summarise(prefix + "update mean", update));
+    metrics.push_back(summarise(prefix + "cull mean", cull));
+    metrics.push_back(summarise(prefix + "build mean", build));
+    metrics.push_back(summarise(prefix + "submit mean", submit));
+    metrics.push_back(summarise(prefix + "frame p50", frame));
+  }
+  return metrics;
+}
+
+/**
+ * Measures the suite and compares it against a baseline, or records a new baseline when asked to
+ * Note: A metric regresses only when its median slows past the threshold and past the noise of both runs,
+ * so a noisy metric needs a larger change before it fails
+ * @param settings The check's settings
+ * @return 0 when nothing regressed, 1 when a metric regressed, 2 when the baseline could not be used
+*/
+int runRegression(const RegressionSettings &settings) {
+  if (!settings.baseline) {
+    std::printf("Usage: --regress <baseline.json> [--update] [--threshold percent] [--filter section]\n");
+    return 2;
+  }
+  std::vector<RegressionMetric> baseline;
+  if (!settings.update && !readBaseline(settings.baseline, baseline)) {
+    std::printf("No baseline at *%s*; record one deliberately on the reference machine with --update\n", settings.baseline);
+    return 2;
+  }
+
+  std::vector<RegressionMetric> metrics = collectMetrics(settings);
+  if (settings.update) {
+    if (!writeBaseline(settings.baseline, metrics)) return 2;
+    std::printf("Baseline *%s* updated with %zu metrics\n", settings.baseline, metrics.size());
+    return 0;
+  }
+
+  std::unordered_map<std::string, const RegressionMetric*> previous;
+  for (auto &metric : baseline) previous[metric.name] = &metric;
+  int regressed = 0, improved = 0, added = 0;
+  std::printf("\n%-70s %12s %12s %9s  %s\n", "Metric", "Baseline ms", "Current ms", "Change", "Result");
+  for (auto &metric : metrics) {
+    auto found = previous.find(metric.name);
+    if (found == previous.end()) {
+      std::printf("%-70s %12s %12.4f %9s  new\n", metric.name.c_str(), "-", metric.median, "-");
+      added++;
+      continue;
+    }
+    const RegressionMetric &before = *found->second;
+    previous.erase(found);
+    double change = metric.median - before.median;
+    double allowed = std::max(settings.threshold / 100 * before.median, REGRESSION_NOISE_SIGMAS * MAD_TO_SIGMA * std::max(before.mad, metric.mad));
+    const char *result = "ok";
+    if (change > allowed) {
+      result = "REGRESSED";
+      regressed++;
+    } else if (-change > allowed) {
+      result = "improved";
+      improved++;
+    }
+    std::printf("%-70s %12.4f %12.4f %+8.1f%%  %s\n", metric.name.c_str(), before.median, metric.median,
+                before.median > 0 ? change / before.median * 100 : 0.0, result);
+  }
+  // Metrics outside a filtered run were simply not measured
+  if (!settings.filter)
+    for (auto &[name, metric] : previous) std::printf("%-70s %12.4f %12s %9s  missing\n", name.c_str(), metric->median, "-", "-");
+
+  std::printf("\n%zu metrics: %i regressed, %i improved, %i new (threshold %.1f%%, noise %i sigma)\n",
+              metrics.size(), regressed, improved, added, settings.threshold, REGRESSION_NOISE_SIGMAS);
+  return regressed ? 1 : 0;
+}
+
+/**
+ * Reads the options following --regress
+ * @param argc The argument count
+ * @param argv The arguments, starting with the program and --regress
+ * @return The settings
+*/
+RegressionSettings parseRegressionArgs(int argc, char *argv[]) {
+  RegressionSettings settings;
+  for (int i = 2; i < argc; i++) {
+    if (std::strcmp(argv[i], "--update") == 0) settings.update = true;
+    else if (std::strcmp(argv[i], "--threshold") == 0 && i + 1 < argc) settings.threshold = std::atof(argv[++i]);
+    else if (std::strcmp(argv[i], "--filter") == 0 && i + 1 < argc) settings.filter = argv[++i];
+    else if (!settings.baseline) settings.baseline = argv[i];
+  }
+  return settings;
+}
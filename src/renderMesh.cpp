@@ -1,36 +1,14 @@
 #include "Mesh.hpp"
+#include "Profiler.hpp"
+#include "MemoryTracker.hpp"
 
 #include <iostream>
 #include <fstream>
 #include <sstream>
 #include <string>
-
-// Splits string by delimiter an typecasts to specific value
-template <class T>
-std::vector<T> split(const std::string &ref, const char delimiter = ' ') {
-  int start = 0, index = 0;
-  std::vector<T> result;
-  T tempValue;
-
-  // Extract terms separated by delimiter
-  do {
-    if (ref[index] == delimiter || ref[index] == '\0') {
-      if (start == index) tempValue = -1;
-      else {
-        std::stringstream typeCast(ref.substr(start, index));
-        typeCast >> tempValue;
-      }
-      result.emplace_back(tempValue);
-      start = index + 1;
-    }
-  } while (++index < ref.length());
-
-  // Add final term to results
-  std::stringstream typeCast(ref.substr(start, index));
-  typeCast >> tempValue;
-  result.emplace_back(tempValue);
-  return result;
-}
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
 
 Point readPoint(const std::string &line) {
   std::istringstream stream(line);
@@ -40,44 +18,128 @@ Point readPoint(const std::string &line) {
   return Point(x, y, z);
 }
 
-std::vector<Face> readFace(const std::string &line) {
+/**
+ * Reads the vertex, texture and normal indices of each corner of a face
+ * Note: Negative indices count back from the latest element read, so they are resolved against the counts at this line
+ * @param line The face line
+ * @param counts The number of vertices, textures and normals read before the line
+ * @return The corners with one based indices, where missing terms are -1 and indices before the first element are 0
+*/
+std::vector<Face> readFace(const std::string &line, const int (&counts)[3]) {
   std::istringstream stream(line);
   std::vector<Face> formation;
   std::string substring;
-  std::vector<int> indecies;
-  int v, t, n; // vertex, texture, normal
   stream >> substring;
 
-  while (stream) {
-    stream >> substring;
-    indecies = split<int>(substring, '/');
+  // Texture and normal indices are optional, so pad any missing terms
+  while (stream >> substring) {
+    int indecies[3] = {-1, -1, -1};
+    size_t start = 0;
+    for (int term = 0; term < 3 && start <= substring.size(); term++) {
+      size_t end = std::min(substring.find('/', start), substring.size());
+      if (end > start) {
+        int index = std::atoi(substring.c_str() + start);
+        indecies[term] = index < 0 ? std::max(counts[term] + index + 1, 0) : index;
+      }
+      start = end + 1;
+    }
     formation.emplace_back(Face(indecies[0], indecies[1], indecies[2]));
   }
 
   return formation;
 }
 
+/**
+ * Defines a read-only stream buffer over memory owned elsewhere, so parsing needs no copy
+*/
+struct MemoryBuffer : std::streambuf {
+  MemoryBuffer(const char *data, size_t size) {
+    char *begin = const_cast<char*>(data);
+    setg(begin, begin, begin + size);
+  }
+};
+
 void Mesh::readFromFile(const char* filename) {
-  std::string line;
   std::ifstream file(filename);
 
   if (!file) {
     std::cout << "Failed to read file: *" << filename << "*" << std::endl;
   } else {
-    while (getline(file, line)) {
-      if (line[0] == 'v') {
-        if (line[1] == 't') {
-          textures.emplace_back(readPoint(line));
-        } else if (line[1] == 'n') {
-          normals.emplace_back(readPoint(line));
-        } else if (line[1] == ' ') {
-          vertices.emplace_back(readPoint(line));
-        }
-      } else if (line[0] == 'f') {
-        faces.emplace_back(readFace(line));
+    parse(file);
+    file.close();
+  }
+}
+
+/**
+ * Reads the mesh from the contents of an .obj file already in memory, such as an archive entry
+ * @param data The file contents
+ * @param size The number of bytes
+*/
+void Mesh::readFromMemory(const char* data, size_t size) {
+  MemoryBuffer buffer(data, size);
+  std::istream stream(&buffer);
+  parse(stream);
+}
+
+/**
+ * Parses vertices and faces line by line from .obj text
+ * @param file The stream being parsed
+*/
+void Mesh::parse(std::istream &file) {
+  PROFILE_SCOPE("Mesh::parse");
+  MEMORY_TAG(MemoryTag::Mesh);
+  std::string line;
+  while (getline(file, line)) {
+    if (line[0] == 'v') {
+      if (line[1] == 't') {
+        textures.emplace_back(readPoint(line));
+      } else if (line[1] == 'n') {
+        normals.emplace_back(readPoint(line));
+      } else if (line[1] == ' ') {
+        vertices.emplace_back(readPoint(line));
       }
+    } else if (line[0] == 'f') {
+      int counts[3] = {(int)vertices.size(), (int)textures.size(), (int)normals.size()};
+      faces.emplace_back(readFace(line, counts));
     }
-    file.close();
+  }
+  buildDerivedData();
+}
+
+/**
+ * Rebuilds the vertex stream, triangle list and bounds from the loaded vertices and faces
+ * Note: Polygons are fanned from their first vertex, and corners outside the vertices read are skipped
+*/
+void Mesh::buildDerivedData() {
+  MEMORY_TAG(MemoryTag::Mesh);
+  stream.assign(vertices);
+
+  triangles.clear();
+  int vertexCount = vertices.size();
+  for (auto &polygon : faces) {
+    std::vector<unsigned int> indices;
+    for (auto &face : polygon) {
+      int index = face.vertex - 1;
+      if (index >= 0 && index < vertexCount) indices.push_back(index);
+    }
+    for (size_t i = 2; i < indices.size(); i++) {
+      triangles.push_back(indices[0]);
+      triangles.push_back(indices[i - 1]);
+      triangles.push_back(indices[i]);
+    }
+  }
+
+  if (vertices.empty()) return;
+  Point low = vertices[0], high = vertices[0];
+  for (auto &vertex : vertices) {
+    low = Point(std::min(low.x, vertex.x), std::min(low.y, vertex.y), std::min(low.z, vertex.z));
+    high = Point(std::max(high.x, vertex.x), std::max(high.y, vertex.y), std::max(high.z, vertex.z));
+  }
+  boundsCenter = Point((low.x + high.x) / 2, (low.y + high.y) / 2, (low.z + high.z) / 2);
+  boundsRadius = 0;
+  for (auto &vertex : vertices) {
+    float dx = vertex.x - boundsCenter.x, dy = vertex.y - boundsCenter.y, dz = vertex.z - boundsCenter.z;
+    boundsRadius = std::max(boundsRadius, std::sqrt(dx*dx + dy*dy + dz*dz));
   }
 }
 
@@ -95,6 +157,48 @@ void Mesh::troubleshoot() {
   }
 }
 
+/**
+ * Projects every vertex of the mesh onto the viewport
+ * @param mvp The combined model-view-projection matrix
+ * @param viewport The screen rectangle being mapped onto
+ * @param out The screen space vertices
+ * @param clipCodes Whether per-vertex clip codes should be written for culling @def{false}
+*/
+void Mesh::transform(const Matrix4 &mvp, const Viewport &viewport, ScreenVertices &out, bool clipCodes) const {
+  transformVertices(stream, mvp, viewport, out, clipCodes);
+}
+
+/**
+ * Estimates the heap memory held by the mesh and its levels of detail
+ * @return The number of bytes allocated
+*/
+size_t Mesh::memoryUsage() const {
+  size_t bytes = (vertices.capacity() + textures.capacity() + normals.capacity()) * sizeof(Point);
+  bytes += faces.capacity() * sizeof(std::vector<Face>) + triangles.capacity() * sizeof(unsigned int);
+  for (auto &polygon : faces) bytes += polygon.capacity() * sizeof(Face);
+  bytes += (stream.x.capacity() + stream.y.capacity() + stream.z.capacity()) * sizeof(float);
+  for (auto &lod : lods) {
+    bytes += lod.vertices.capacity() * sizeof(Point) + lod.triangles.capacity() * sizeof(unsigned int);
+    bytes += (lod.stream.x.capacity() + lod.stream.y.capacity() + lod.stream.z.capacity()) * sizeof(float);
+  }
+  return bytes;
+}
+
 Mesh::Mesh(const char* filename) {
   readFromFile(filename);
 }
+
+/**
+ * Constructs a mesh from generated geometry
+ * @param points The vertices comprising the mesh
+ * @param indices Three zero based vertex indices per triangle
+*/
+Mesh::Mesh(const std::vector<Point> &points, const std::vector<unsigned int> &indices) : vertices(points) {
+  MEMORY_TAG(MemoryTag::Mesh);
+  for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+    faces.emplace_back(std::vector<Face>{
+      Face(indices[i] + 1, -1, -1), Face(indices[i + 1] + 1, -1, -1), Face(indices[i + 2] + 1, -1, -1)
+    });
+  }
+  buildDerivedData();
+}
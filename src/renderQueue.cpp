@@ -0,0 +1,275 @@
+#include "RenderQueue.hpp"
+#include "Profiler.hpp"
+#include "FrameAllocator.hpp"
+
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#include <SFML/Graphics.hpp>
+
+#define RADIX_BITS 8
+#define RADIX_BUCKETS (1 << RADIX_BITS)
+
+/**
+ * Returns a small identifier for a texture or shader, stable across frames, with 0 for none
+*/
+std::uint32_t RenderQueue::idOf(const void *state) {
+  if (!state) return 0;
+  auto found = stateIds.find(state);
+  if (found != stateIds.end()) return found->second;
+  std::uint32_t id = stateIds.size() + 1;
+  stateIds.emplace(state, id);
+  return id;
+}
+
+/**
+ * Packs the layer, depth, render states and sequence into a key whose order is the draw order
+ * @param layer The layer, drawn back to front from 0
+ * @param depth The depth within the layer, drawn back to front from 0
+ * @param texture The texture, or null
+ * @param blend The blend mode
+ * @param shader The shader, or null
+ * @param sequence The submission order tiebreak, such as the entity's creation order
+ * @return The sort key
+*/
+std::uint64_t RenderQueue::makeKey(unsigned int layer, unsigned int depth, const sf::Texture *texture, const sf::BlendMode &blend,
+                                   const sf::Shader *shader, unsigned int sequence) {
+  std::uint64_t blendId = blend == sf::BlendAlpha ? 0 : blend == sf::BlendAdd ? 1 : blend == sf::BlendMultiply ? 2 : 3;
+  std::uint64_t key = std::min<std::uint64_t>(layer, (1 << KEY_LAYER_BITS) - 1);
+  key = (key << KEY_DEPTH_BITS) | std::min<std::uint64_t>(depth, (1 << KEY_DEPTH_BITS) - 1);
+  key = (key << KEY_SHADER_BITS) | (idOf(shader) & ((1 << KEY_SHADER_BITS) - 1));
+  key = (key << KEY_BLEND_BITS) | blendId;
+  key = (key << KEY_TEXTURE_BITS) | (idOf(texture) & ((1 << KEY_TEXTURE_BITS) - 1));
+  key = (key << KEY_SEQUENCE_BITS) | (sequence & ((1 << KEY_SEQUENCE_BITS) - 1));
+  return key;
+}
+
+/**
+ * Appends a command for the given states
+*/
+RenderCommand& RenderQueue::push(unsigned int layer, unsigned int depth, unsigned int sequence, const sf::RenderStates &states) {
+  commands.emplace_back();
+  RenderCommand &command = commands.back();
+  command.key = makeKey(layer, depth, states.texture, states.blendMode, states.shader, sequence);
+  command.texture = states.texture;
+  command.shader = states.shader;
+  command.blend = states.blendMode;
+  command.first = vertices.size();
+  return command;
+}
+
+/**
+ * Submits a triangle list, transformed into world space now so it can be merged with other draws
+ * @param triangles The vertices, three per triangle
+ * @param count The number of vertices
+ * @param states The texture, shader, blend mode and transform
+ * @param layer The layer, drawn back to front from 0
+ * @param depth The depth within the layer, drawn back to front from 0
+ * @param sequence The tiebreak between draws with the same key
+*/
+void RenderQueue::submit(const sf::Vertex *triangles, size_t count, const sf::RenderStates &states,
+                         unsigned int layer, unsigned int depth, unsigned int sequence) {
+  RenderCommand &command = push(layer, depth, sequence, states);
+  for (size_t i = 0; i < count; i++) {
+    vertices.push_back(triangles[i]);
+    vertices.back().position = states.transform.transformPoint(triangles[i].position);
+  }
+  command.count = count;
+}
+
+/**
+ * Submits a sprite as two triangles
+ * @param sprite The sprite
+ * @param layer The layer, drawn back to front from 0
+ * @param depth The depth within the layer, drawn back to front from 0
+ * @param sequence The tiebreak between draws with the same key
+*/
+void RenderQueue::submit(const sf::Sprite &sprite, unsigned int layer, unsigned int depth, unsigned int sequence) {
+  const sf::IntRect &rect = sprite.getTextureRect();
+  float width = std::abs(rect.width), height = std::abs(rect.height);
+  float u0 = rect.left, v0 = rect.top, u1 = rect.left + rect.width, v1 = rect.top + rect.height;
+  sf::Color color = sprite.getColor();
+  sf::Vertex quad[6] = {
+    sf::Vertex(sf::Vector2f(0, 0), color, sf::Vector2f(u0, v0)),
+    sf::Vertex(sf::Vector2f(width, 0), color, sf::Vector2f(u1, v0)),
+    sf::Vertex(sf::Vector2f(0, height), color, sf::Vector2f(u0, v1)),
+    sf::Vertex(sf::Vector2f(0, height), color, sf::Vector2f(u0, v1)),
+    sf::Vertex(sf::Vector2f(width, 0), color, sf::Vector2f(u1, v0)),
+    sf::Vertex(sf::Vector2f(width, height), color, sf::Vector2f(u1, v1))
+  };
+  sf::RenderStates states(sprite.getTransform());
+  states.texture = sprite.getTexture();
+  submit(quad, 6, states, layer, depth, sequence);
+}
+
+/**
+ * Returns the unit normal of an edge
+*/
+static sf::Vector2f edgeNormal(const sf::Vector2f &p1, const sf::Vector2f &p2) {
+  sf::Vector2f normal(p1.y - p2.y, p2.x - p1.x);
+  float length = std::sqrt(normal.x * normal.x + normal.y * normal.y);
+  return length != 0 ? normal / length : normal;
+}
+
+/**
+ * Submits a convex shape as a triangle fan for its fill followed by a strip of triangles for its outline
+ * Note: Matches the geometry sf::Shape builds, including its mitred outline
+ * @param shape The shape
+ * @param layer The layer, drawn back to front from 0
+ * @param depth The depth within the layer, drawn back to front from 0
+ * @param sequence The tiebreak between draws with the same key
+*/
+void RenderQueue::submit(const sf::Shape &shape, unsigned int layer, unsigned int depth, unsigned int sequence) {
+  size_t count = shape.getPointCount();
+  if (count < 3) return;
+  // The points and outline only live for this call, so they come from the frame arena
+  FrameArenaScope scratch;
+  std::pmr::vector<sf::Vector2f> points(count, &scratch.get());
+  sf::Vector2f minimum = shape.getPoint(0), maximum = minimum;
+  for (size_t i = 0; i < count; i++) {
+    points[i] = shape.getPoint(i);
+    minimum = sf::Vector2f(std::min(minimum.x, points[i].x), std::min(minimum.y, points[i].y));
+    maximum = sf::Vector2f(std::max(maximum.x, points[i].x), std::max(maximum.y, points[i].y));
+  }
+  sf::Vector2f center = (minimum + maximum) / 2.f, extent = maximum - minimum;
+  const sf::Transform &transform = shape.getTransform();
+  sf::RenderStates states(shape.getTexture());
+
+  if (shape.getFillColor().a > 0) {
+    // Texture coordinates stretch the texture rectangle over the bounds of the points
+    const sf::IntRect &rect = shape.getTextureRect();
+    RenderCommand &fill = push(layer, depth, sequence, states);
+    for (size_t i = 1; i + 1 < count; i++) {
+      for (size_t corner : {(size_t)0, i, i + 1}) {
+        const sf::Vector2f &p = points[corner];
+        float u = extent.x > 0 ? (p.x - minimum.x) / extent.x : 0, v = extent.y > 0 ? (p.y - minimum.y) / extent.y : 0;
+        vertices.emplace_back(transform.transformPoint(p), shape.getFillColor(), sf::Vector2f(rect.left + rect.width * u, rect.top + rect.height * v));
+      }
+    }
+    fill.count = vertices.size() - fill.first;
+  }
+
+  float thickness = shape.getOutlineThickness();
+  if (thickness == 0 || shape.getOutlineColor().a == 0) return;
+  std::pmr::vector<sf::Vector2f> strip(count * 2 + 2, &scratch.get());
+  for (size_t i = 0; i < count; i++) {
+    const sf::Vector2f &p0 = points[(i + count - 1) % count], &p1 = points[i], &p2 = points[(i + 1) % count];
+    sf::Vector2f n1 = edgeNormal(p0, p1), n2 = edgeNormal(p1, p2);
+    // Normals must point away from the centre whatever the winding
+    if (n1.x * (center.x - p1.x) + n1.y * (center.y - p1.y) > 0) n1 = -n1;
+    if (n2.x * (center.x - p1.x) + n2.y * (center.y - p1.y) > 0) n2 = -n2;
+    float factor = 1.f + (n1.x * n2.x + n1.y * n2.y);
+    strip[i * 2] = p1;
+    strip[i * 2 + 1] = p1 + (n1 + n2) / factor * thickness;
+  }
+  strip[count * 2] = strip[0];
+  strip[count * 2 + 1] = strip[1];
+
+  // The outline is untextured but keeps the fill's key so it stays directly after its fill
+  RenderCommand &outline = push(layer, depth, sequence, states);
+  outline.texture = nullptr;
+  for (size_t i = 0; i + 2 < strip.size(); i++)
+    for (size_t corner = i; corner < i + 3; corner++)
+      vertices.emplace_back(transform.transformPoint(strip[corner]), shape.getOutlineColor());
+  outline.count = vertices.size() - outline.first;
+}
+
+/**
+ * Submits any drawable, which is drawn on its own rather than merged
+ * @param drawable The drawable, which must stay alive until the flush
+ * @param states The render states
+ * @param layer The layer, drawn back to front from 0
+ * @param depth The depth within the layer, drawn back to front from 0
+ * @param sequence The tiebreak between draws with the same key
+*/
+void RenderQueue::submit(const sf::Drawable &drawable, const sf::RenderStates &states, unsigned int layer, unsigned int depth, unsigned int sequence) {
+  RenderCommand &command = push(layer, depth, sequence, states);
+  command.drawable = &drawable;
+  command.transform = states.transform;
+}
+
+/**
+ * Sorts the commands by key with a stable least significant digit radix sort, skipping digits every key shares
+ * @param order Set to the sorted keys and command indices
+ * @param scratch The buffer each pass scatters into
+*/
+void RenderQueue::sort(RenderOrder &order, RenderOrder &scratch) {
+  order.resize(commands.size());
+  scratch.resize(commands.size());
+  for (size_t i = 0; i < commands.size(); i++) order[i] = std::make_pair(commands[i].key, (std::uint32_t)i);
+
+  size_t counts[RADIX_BUCKETS];
+  for (int shift = 0; shift < 64; shift += RADIX_BITS) {
+    std::memset(counts, 0, sizeof(counts));
+    for (auto &entry : order) counts[(entry.first >> shift) & (RADIX_BUCKETS - 1)]++;
+    if (order.empty() || counts[(order[0].first >> shift) & (RADIX_BUCKETS - 1)] == order.size()) continue;
+
+    size_t offset = 0;
+    for (size_t &count : counts) {
+      size_t next = offset + count;
+      count = offset;
+      offset = next;
+    }
+    for (auto &entry : order) scratch[counts[(entry.first >> shift) & (RADIX_BUCKETS - 1)]++] = entry;
+    order.swap(scratch);
+  }
+}
+
+/**
+ * Sorts the submitted commands, draws consecutive commands sharing states as one triangle list, then empties the queue
+ * @param target The render target
+*/
+void RenderQueue::flush(sf::RenderTarget &target) {
+  PROFILE_SCOPE("RenderQueue::flush");
+  commandCount = commands.size();
+  drawCalls = 0;
+  FrameArenaScope arena;
+  RenderOrder order(&arena.get()), scratch(&arena.get());
+  sort(order, scratch);
+
+  const RenderCommand *current = nullptr;
+  auto drawBatch = [&]() {
+    if (batch.empty()) return;
+    sf::RenderStates states(current->blend, sf::Transform::Identity, current->texture, current->shader);
+    target.draw(batch.data(), batch.size(), sf::Triangles, states);
+    batch.clear();
+    drawCalls++;
+  };
+
+  for (auto &entry : order) {
+    const RenderCommand &command = commands[entry.second];
+    if (command.drawable) {
+      drawBatch();
+      target.draw(*command.drawable, sf::RenderStates(command.blend, command.transform, command.texture, command.shader));
+      drawCalls++;
+      continue;
+    }
+    if (current && (command.texture != current->texture || command.shader != current->shader || command.blend != current->blend)) drawBatch();
+    current = &command;
+    batch.insert(batch.end(), vertices.begin() + command.first, vertices.begin() + command.first + command.count);
+  }
+  drawBatch();
+  clear();
+}
+
+/**
+ * Reserves room for a frame's commands and vertices, so submitting up to that many never allocates
+ * @param commandCount The most commands submitted between flushes
+ * @param vertexCount The most triangle vertices submitted between flushes
+*/
+void RenderQueue::reserve(size_t commandCount, size_t vertexCount) {
+  commands.reserve(commandCount);
+  vertices.reserve(vertexCount);
+  batch.reserve(vertexCount);
+}
+
+/**
+ * Discards the submitted commands without drawing them
+*/
+void RenderQueue::clear() {
+  commands.clear();
+  vertices.clear();
+  // Identifiers only order draws, so they can be reassigned once too many textures have come and gone
+  if (stateIds.size() >= (1u << KEY_TEXTURE_BITS)) stateIds.clear();
+}
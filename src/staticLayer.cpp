@@ -0,0 +1,81 @@
+#include "StaticLayer.hpp"
+
+#include <cmath>
+#include <memory>
+
+#include <SFML/Graphics.hpp>
+
+/**
+ * Marks every chunk overlapping a region for re-rendering, creating chunks as geometry reaches them
+ * @param region The world space area which changed
+*/
+void StaticLayer::markDirty(const sf::FloatRect &region) {
+  int left = std::floor(region.left / chunkSize), top = std::floor(region.top / chunkSize);
+  int right = std::floor((region.left + region.width) / chunkSize), bottom = std::floor((region.top + region.height) / chunkSize);
+  for (int x = left; x <= right; x++)
+    for (int y = top; y <= bottom; y++)
+      chunks[keyOf(x, y)].dirty = true;
+}
+
+/**
+ * Marks every existing chunk for re-rendering
+*/
+void StaticLayer::markAllDirty() {
+  for (auto &pair : chunks) pair.second.dirty = true;
+}
+
+/**
+ * Re-renders the dirty chunks, dropping any left empty
+ * Note: Dirty chunks outside the visible area stay dirty until a camera sees them
+ * @param draw The function submitting every entity of the layer overlapping a world space region
+ * @param visible The world area being rendered, or null to re-render every dirty chunk @def{nullptr}
+ * @return The number of chunks re-rendered
+*/
+int StaticLayer::update(const std::function<void(const sf::FloatRect&, RenderQueue&)> &draw, const sf::FloatRect *visible) {
+  int rendered = 0;
+  for (auto it = chunks.begin(); it != chunks.end();) {
+    Chunk &chunk = it->second;
+    if (!chunk.dirty) {
+      it++;
+      continue;
+    }
+    int x = (std::int32_t)(it->first >> 32), y = (std::int32_t)(it->first & 0xFFFFFFFF);
+    sf::FloatRect area(x * (float)chunkSize, y * (float)chunkSize, chunkSize, chunkSize);
+    if (visible && !visible->intersects(area)) {
+      it++;
+      continue;
+    }
+    draw(area, queue);
+    chunk.dirty = false;
+    rendered++;
+
+    if (queue.empty()) {
+      it = chunks.erase(it);
+      continue;
+    }
+    if (!chunk.texture) {
+      chunk.texture = std::make_unique<sf::RenderTexture>();
+      chunk.texture->create(chunkSize, chunkSize);
+      chunk.sprite.setTexture(chunk.texture->getTexture(), true);
+      chunk.sprite.setPosition(area.left, area.top);
+    }
+    chunk.texture->setView(sf::View(area));
+    chunk.texture->clear(sf::Color::Transparent);
+    queue.flush(*chunk.texture);
+    chunk.texture->display();
+    it++;
+  }
+  return rendered;
+}
+
+/**
+ * Submits a quad per chunk to be composited with the rest of the frame
+ * @param target The queue of the frame
+ * @param layer The layer the chunks are drawn on
+ * @param visible The world area being rendered, or null to submit every chunk @def{nullptr}
+*/
+void StaticLayer::submit(RenderQueue &target, unsigned int layer, const sf::FloatRect *visible) const {
+  for (auto &pair : chunks)
+    if (pair.second.texture && (!visible || visible->intersects(pair.second.sprite.getGlobalBounds())))
+      target.submit(pair.second.sprite, layer, 0, 0);
+}
@@ -0,0 +1,294 @@
+#include "VertexPipeline.hpp"
+#include "Mesh.hpp"
+
+#include <vector>
+#include <cmath>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define VERTEX_PIPELINE_SSE
+#endif
+
+// Vertices with a clip space w at or below this are treated as degenerate
+#define MIN_CLIP_W 1e-6f
+
+/**
+ * Creates the identity matrix
+ * @return The identity matrix
+*/
+Matrix4 Matrix4::identity() {
+  return Matrix4{{1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1}};
+}
+
+/**
+ * Creates a translation matrix
+ * @param x The translation along the x axis
+ * @param y The translation along the y axis
+ * @param z The translation along the z axis
+ * @return The translation matrix
+*/
+Matrix4 Matrix4::translation(float x, float y, float z) {
+  return Matrix4{{1, 0, 0, x, 0, 1, 0, y, 0, 0, 1, z, 0, 0, 0, 1}};
+}
+
+/**
+ * Creates a non-uniform scale matrix
+ * @param x The scale factor along the x axis
+ * @param y The scale factor along the y axis
+ * @param z The scale factor along the z axis
+ * @return The scale matrix
+*/
+Matrix4 Matrix4::scale(float x, float y, float z) {
+  return Matrix4{{x, 0, 0, 0, 0, y, 0, 0, 0, 0, z, 0, 0, 0, 0, 1}};
+}
+
+/**
+ * Creates a rotation about the x axis
+ * @param angle The rotation in radians
+ * @return The rotation matrix
+*/
+Matrix4 Matrix4::rotationX(float angle) {
+  float c = std::cos(angle), s = std::sin(angle);
+  return Matrix4{{1, 0, 0, 0, 0, c, -s, 0, 0, s, c, 0, 0, 0, 0, 1}};
+}
+
+/**
+ * Creates a rotation about the y axis
+ * @param angle The rotation in radians
+ * @return The rotation matrix
+*/
+Matrix4 Matrix4::rotationY(float angle) {
+  float c = std::cos(angle), s = std::sin(angle);
+  return Matrix4{{c, 0, s, 0, 0, 1, 0, 0, -s, 0, c, 0, 0, 0, 0, 1}};
+}
+
+/**
+ * Creates a right-handed perspective projection looking down the negative z axis
+ * @param fovY The vertical field of view in radians
+ * @param aspect The viewport width divided by its height
+ * @param zNear The distance to the near clip plane
+ * @param zFar The distance to the far clip plane
+ * @return The projection matrix
+*/
+Matrix4 Matrix4::perspective(float fovY, float aspect, float zNear, float zFar) {
+  float f = 1.f / std::tan(fovY / 2);
+  return Matrix4{{
+    f / aspect, 0, 0, 0,
+    0, f, 0, 0,
+    0, 0, (zFar + zNear) / (zNear - zFar), 2 * zFar * zNear / (zNear - zFar),
+    0, 0, -1, 0
+  }};
+}
+
+/**
+ * Creates an orthographic projection of the given view volume
+ * @return The projection matrix
+*/
+Matrix4 Matrix4::orthographic(float left, float right, float bottom, float top, float zNear, float zFar) {
+  return Matrix4{{
+    2 / (right - left), 0, 0, -(right + left) / (right - left),
+    0, 2 / (top - bottom), 0, -(top + bottom) / (top - bottom),
+    0, 0, -2 / (zFar - zNear), -(zFar + zNear) / (zFar - zNear),
+    0, 0, 0, 1
+  }};
+}
+
+/**
+ * Composes two matrices such that the right hand side is applied first
+ * @param other The matrix applied before this one
+ * @return The combined matrix
+*/
+Matrix4 Matrix4::operator*(const Matrix4 &other) const {
+  Matrix4 result;
+  for (int row = 0; row < 4; row++) {
+    for (int col = 0; col < 4; col++) {
+      float sum = 0;
+      for (int k = 0; k < 4; k++) sum += m[row*4 + k] * other.m[k*4 + col];
+      result.m[row*4 + col] = sum;
+    }
+  }
+  return result;
+}
+
+/**
+ * Copies vertices into separate coordinate arrays padded to the SIMD width
+ * @param points The vertices being copied
+*/
+void VertexStream::assign(const std::vector<Point> &points) {
+  count = points.size();
+  size_t padded = (count + VERTEX_STREAM_PADDING - 1) / VERTEX_STREAM_PADDING * VERTEX_STREAM_PADDING;
+  x.assign(padded, 0.f);
+  y.assign(padded, 0.f);
+  z.assign(padded, 0.f);
+  for (size_t i = 0; i < count; i++) {
+    x[i] = points[i].x;
+    y[i] = points[i].y;
+    z[i] = points[i].z;
+  }
+}
+
+/**
+ * Transforms a single vertex through the full pipeline
+ * Note: This is the reference every SIMD kernel must agree with
+*/
+static inline void transformVertex(float px, float py, float pz, const Matrix4 &mat, const Viewport &viewport,
+                                   ScreenVertices &out, size_t i, bool clipCodes) {
+  const float *m = mat.m;
+  float cx = m[0]*px + m[1]*py + m[2]*pz + m[3];
+  float cy = m[4]*px + m[5]*py + m[6]*pz + m[7];
+  float cz = m[8]*px + m[9]*py + m[10]*pz + m[11];
+  float cw = m[12]*px + m[13]*py + m[14]*pz + m[15];
+
+  if (clipCodes) {
+    unsigned char code = 0;
+    if (cx < -cw) code |= CLIP_LEFT;
+    if (cx > cw) code |= CLIP_RIGHT;
+    if (cy < -cw) code |= CLIP_BOTTOM;
+    if (cy > cw) code |= CLIP_TOP;
+    if (cz < -cw) code |= CLIP_NEAR;
+    if (cz > cw) code |= CLIP_FAR;
+    out.clipCodes[i] = code;
+  }
+
+  float invW = cw > MIN_CLIP_W ? 1.f / cw : 0.f;
+  float halfWidth = viewport.width / 2, halfHeight = viewport.height / 2;
+  out.x[i] = viewport.x + halfWidth + cx * invW * halfWidth;
+  out.y[i] = viewport.y + halfHeight - cy * invW * halfHeight;
+  out.depth[i] = 0.5f + cz * invW * 0.5f;
+}
+
+/**
+ * Sizes the output buffers for a given number of padded vertices
+*/
+static void prepareOutput(ScreenVertices &out, size_t count, size_t padded, bool clipCodes) {
+  out.count = count;
+  out.x.resize(padded);
+  out.y.resize(padded);
+  out.depth.resize(padded);
+  if (clipCodes) out.clipCodes.resize(padded);
+}
+
+/**
+ * Transforms, projects and maps a vertex stream onto the viewport using the widest available instruction set
+ * @param stream The source vertices
+ * @param mvp The combined model-view-projection matrix
+ * @param viewport The screen rectangle being mapped onto
+ * @param out The screen space vertices
+ * @param clipCodes Whether per-vertex clip codes should be written for culling @def{false}
+*/
+void transformVertices(const VertexStream &stream, const Matrix4 &mvp, const Viewport &viewport, ScreenVertices &out, bool clipCodes) {
+  size_t padded = stream.paddedCount();
+  prepareOutput(out, stream.count, padded, clipCodes);
+  const float *m = mvp.m;
+  float halfWidth = viewport.width / 2, halfHeight = viewport.height / 2;
+  size_t i = 0;
+
+#if defined(__AVX2__)
+  __m256 m0 = _mm256_set1_ps(m[0]), m1 = _mm256_set1_ps(m[1]), m2 = _mm256_set1_ps(m[2]), m3 = _mm256_set1_ps(m[3]);
+  __m256 m4 = _mm256_set1_ps(m[4]), m5 = _mm256_set1_ps(m[5]), m6 = _mm256_set1_ps(m[6]), m7 = _mm256_set1_ps(m[7]);
+  __m256 m8 = _mm256_set1_ps(m[8]), m9 = _mm256_set1_ps(m[9]), m10 = _mm256_set1_ps(m[10]), m11 = _mm256_set1_ps(m[11]);
+  __m256 m12 = _mm256_set1_ps(m[12]), m13 = _mm256_set1_ps(m[13]), m14 = _mm256_set1_ps(m[14]), m15 = _mm256_set1_ps(m[15]);
+  __m256 centerX = _mm256_set1_ps(viewport.x + halfWidth), scaleX = _mm256_set1_ps(halfWidth);
+  __m256 centerY = _mm256_set1_ps(viewport.y + halfHeight), scaleY = _mm256_set1_ps(-halfHeight);
+  __m256 half = _mm256_set1_ps(0.5f), one = _mm256_set1_ps(1.f), minW = _mm256_set1_ps(MIN_CLIP_W);
+  __m256 zero = _mm256_setzero_ps();
+
+  for (; i < padded; i += 8) {
+    __m256 px = _mm256_loadu_ps(&stream.x[i]), py = _mm256_loadu_ps(&stream.y[i]), pz = _mm256_loadu_ps(&stream.z[i]);
+    __m256 cx = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(m0, px), _mm256_mul_ps(m1, py)), _mm256_add_ps(_mm256_mul_ps(m2, pz), m3));
+    __m256 cy = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(m4, px), _mm256_mul_ps(m5, py)), _mm256_add_ps(_mm256_mul_ps(m6, pz), m7));
+    __m256 cz = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(m8, px), _mm256_mul_ps(m9, py)), _mm256_add_ps(_mm256_mul_ps(m10, pz), m11));
+    __m256 cw = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(m12, px), _mm256_mul_ps(m13, py)), _mm256_add_ps(_mm256_mul_ps(m14, pz), m15));
+
+    if (clipCodes) {
+      __m256 negW = _mm256_sub_ps(zero, cw);
+      __m256i code = _mm256_and_si256(_mm256_castps_si256(_mm256_cmp_ps(cx, negW, _CMP_LT_OQ)), _mm256_set1_epi32(CLIP_LEFT));
+      code = _mm256_or_si256(code, _mm256_and_si256(_mm256_castps_si256(_mm256_cmp_ps(cx, cw, _CMP_GT_OQ)), _mm256_set1_epi32(CLIP_RIGHT)));
+      code = _mm256_or_si256(code, _mm256_and_si256(_mm256_castps_si256(_mm256_cmp_ps(cy, negW, _CMP_LT_OQ)), _mm256_set1_epi32(CLIP_BOTTOM)));
+      code = _mm256_or_si256(code, _mm256_and_si256(_mm256_castps_si256(_mm256_cmp_ps(cy, cw, _CMP_GT_OQ)), _mm256_set1_epi32(CLIP_TOP)));
+      code = _mm256_or_si256(code, _mm256_and_si256(_mm256_castps_si256(_mm256_cmp_ps(cz, negW, _CMP_LT_OQ)), _mm256_set1_epi32(CLIP_NEAR)));
+      code = _mm256_or_si256(code, _mm256_and_si256(_mm256_castps_si256(_mm256_cmp_ps(cz, cw, _CMP_GT_OQ)), _mm256_set1_epi32(CLIP_FAR)));
+      __m128i packed = _mm_packs_epi32(_mm256_castsi256_si128(code), _mm256_extracti128_si256(code, 1));
+      _mm_storel_epi64((__m128i*)&out.clipCodes[i], _mm_packus_epi16(packed, packed));
+    }
+
+    __m256 valid = _mm256_cmp_ps(cw, minW, _CMP_GT_OQ);
+    __m256 invW = _mm256_and_ps(_mm256_div_ps(one, cw), valid);
+    _mm256_storeu_ps(&out.x[i], _mm256_add_ps(centerX, _mm256_mul_ps(_mm256_mul_ps(cx, invW), scaleX)));
+    _mm256_storeu_ps(&out.y[i], _mm256_add_ps(centerY, _mm256_mul_ps(_mm256_mul_ps(cy, invW), scaleY)));
+    _mm256_storeu_ps(&out.depth[i], _mm256_add_ps(half, _mm256_mul_ps(_mm256_mul_ps(cz, invW), half)));
+  }
+#elif defined(VERTEX_PIPELINE_SSE)
+  __m128 m0 = _mm_set1_ps(m[0]), m1 = _mm_set1_ps(m[1]), m2 = _mm_set1_ps(m[2]), m3 = _mm_set1_ps(m[3]);
+  __m128 m4 = _mm_set1_ps(m[4]), m5 = _mm_set1_ps(m[5]), m6 = _mm_set1_ps(m[6]), m7 = _mm_set1_ps(m[7]);
+  __m128 m8 = _mm_set1_ps(m[8]), m9 = _mm_set1_ps(m[9]), m10 = _mm_set1_ps(m[10]), m11 = _mm_set1_ps(m[11]);
+  __m128 m12 = _mm_set1_ps(m[12]), m13 = _mm_set1_ps(m[13]), m14 = _mm_set1_ps(m[14]), m15 = _mm_set1_ps(m[15]);
+  __m128 centerX = _mm_set1_ps(viewport.x + halfWidth), scaleX = _mm_set1_ps(halfWidth);
+  __m128 centerY = _mm_set1_ps(viewport.y + halfHeight), scaleY = _mm_set1_ps(-halfHeight);
+  __m128 half = _mm_set1_ps(0.5f), one = _mm_set1_ps(1.f), minW = _mm_set1_ps(MIN_CLIP_W);
+  __m128 zero = _mm_setzero_ps();
+
+  for (; i < padded; i += 4) {
+    __m128 px = _mm_loadu_ps(&stream.x[i]), py = _mm_loadu_ps(&stream.y[i]), pz = _mm_loadu_ps(&stream.z[i]);
+    __m128 cx = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m0, px), _mm_mul_ps(m1, py)), _mm_add_ps(_mm_mul_ps(m2, pz), m3));
+    __m128 cy = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m4, px), _mm_mul_ps(m5, py)), _mm_add_ps(_mm_mul_ps(m6, pz), m7));
+    __m128 cz = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m8, px), _mm_mul_ps(m9, py)), _mm_add_ps(_mm_mul_ps(m10, pz), m11));
+    __m128 cw = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m12, px), _mm_mul_ps(m13, py)), _mm_add_ps(_mm_mul_ps(m14, pz), m15));
+
+    if (clipCodes) {
+      __m128 negW = _mm_sub_ps(zero, cw);
+      __m128i code = _mm_and_si128(_mm_castps_si128(_mm_cmplt_ps(cx, negW)), _mm_set1_epi32(CLIP_LEFT));
+      code = _mm_or_si128(code, _mm_and_si128(_mm_castps_si128(_mm_cmpgt_ps(cx, cw)), _mm_set1_epi32(CLIP_RIGHT)));
+      code = _mm_or_si128(code, _mm_and_si128(_mm_castps_si128(_mm_cmplt_ps(cy, negW)), _mm_set1_epi32(CLIP_BOTTOM)));
+      code = _mm_or_si128(code, _mm_and_si128(_mm_castps_si128(_mm_cmpgt_ps(cy, cw)), _mm_set1_epi32(CLIP_TOP)));
+      code = _mm_or_si128(code, _mm_and_si128(_mm_castps_si128(_mm_cmplt_ps(cz, negW)), _mm_set1_epi32(CLIP_NEAR)));
+      code = _mm_or_si128(code, _mm_and_si128(_mm_castps_si128(_mm_cmpgt_ps(cz, cw)), _mm_set1_epi32(CLIP_FAR)));
+      __m128i packed = _mm_packs_epi32(code, code);
+      int bytes = _mm_cvtsi128_si32(_mm_packus_epi16(packed, packed));
+      unsigned char *dest = &out.clipCodes[i];
+      for (int lane = 0; lane < 4; lane++) dest[lane] = (unsigned char)(bytes >> (lane * 8));
+    }
+
+    __m128 valid = _mm_cmpgt_ps(cw, minW);
+    __m128 invW = _mm_and_ps(_mm_div_ps(one, cw), valid);
+    _mm_storeu_ps(&out.x[i], _mm_add_ps(centerX, _mm_mul_ps(_mm_mul_ps(cx, invW), scaleX)));
+    _mm_storeu_ps(&out.y[i], _mm_add_ps(centerY, _mm_mul_ps(_mm_mul_ps(cy, invW), scaleY)));
+    _mm_storeu_ps(&out.depth[i], _mm_add_ps(half, _mm_mul_ps(_mm_mul_ps(cz, invW), half)));
+  }
+#endif
+
+  // Scalar fallback for targets without SSE
+  for (; i < padded; i++)
+    transformVertex(stream.x[i], stream.y[i], stream.z[i], mvp, viewport, out, i, clipCodes);
+}
+
+/**
+ * Transforms vertices one at a time straight from the mesh points
+ * Note: Kept as the baseline the SIMD kernels are benchmarked and verified against
+ * @param points The source vertices
+ * @param mvp The combined model-view-projection matrix
+ * @param viewport The screen rectangle being mapped onto
+ * @param out The screen space vertices
+ * @param clipCodes Whether per-vertex clip codes should be written for culling @def{false}
+*/
+void transformVerticesNaive(const std::vector<Point> &points, const Matrix4 &mvp, const Viewport &viewport, ScreenVertices &out, bool clipCodes) {
+  prepareOutput(out, points.size(), points.size(), clipCodes);
+  for (size_t i = 0; i < points.size(); i++)
+    transformVertex(points[i].x, points[i].y, points[i].z, mvp, viewport, out, i, clipCodes);
+}
+
+/**
+ * Names the instruction set the batch kernel was compiled for
+ * @return The instruction set name
+*/
+const char* vertexPipelineInstructionSet() {
+#if defined(__AVX2__)
+  return "AVX2";
+#elif defined(VERTEX_PIPELINE_SSE)
+  return "SSE2";
+#else
+  return "scalar";
+#endif
+}
@@ -0,0 +1,365 @@
+#include "Visibility.hpp"
+#include "Profiler.hpp"
+#include "MemoryTracker.hpp"
+#include "FrameAllocator.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <SFML/Graphics.hpp>
+
+#define TWO_PI 6.28318531f
+// Rays either side of each endpoint, so one stops at the corner and the other slips past to whatever lies behind
+#define CORNER_EPSILON 1e-4f
+// Edges are stretched by this fraction so rays cannot leak through the seam where two walls meet
+#define SEAM_EPSILON 1e-3f
+
+static inline float cross(const sf::Vector2f &a, const sf::Vector2f &b) { return a.x * b.y - a.y * b.x; }
+
+/**
+ * Builds the walls from a level image, merging black pixels into rectangles
+ * Note: Uses the same pixel layout as EntityManager::addFromImage
+ * @param img The level image
+ * @param pixelSize The size of each pixel in the world @def{32}
+ * @param offset The world position of the image's top left corner @def{(0,0)}
+*/
+void WallMap::build(const sf::Image &img, float pixelSize, sf::Vector2f offset) {
+  PROFILE_SCOPE("WallMap::build");
+  MEMORY_TAG(MemoryTag::Level);
+  sf::Vector2u size = img.getSize();
+  std::vector<sf::FloatRect> merged;
+
+  // Horizontal runs of wall pixels are extended downwards while the next row has an identical run
+  std::map<std::pair<int, int>, int> open, next;
+  for (int y = 0; y <= (int)size.y; y++) {
+    next.clear();
+    for (int x = 0; y < (int)size.y && x < (int)size.x; x++) {
+      if (img.getPixel(x, y) != sf::Color::Black) continue;
+      int start = x;
+      while (x < (int)size.x && img.getPixel(x, y) == sf::Color::Black) x++;
+      auto run = std::make_pair(start, x);
+      auto found = open.find(run);
+      next[run] = found == open.end() ? y : found->second;
+      if (found != open.end()) open.erase(found);
+    }
+    for (auto &closed : open) {
+      const std::pair<int, int> &run = closed.first;
+      merged.emplace_back(offset.x + run.first * pixelSize, offset.y + closed.second * pixelSize,
+                          (run.second - run.first) * pixelSize, (y - closed.second) * pixelSize);
+    }
+    open.swap(next);
+  }
+  build(merged);
+}
+
+/**
+ * Builds the walls from rectangles
+ * @param rects The wall rectangles
+*/
+void WallMap::build(const std::vector<sf::FloatRect> &rects) {
+  walls = rects;
+  segments.clear();
+  for (auto &rect : walls) {
+    sf::Vector2f topLeft(rect.left, rect.top), topRight(rect.left + rect.width, rect.top);
+    sf::Vector2f bottomLeft(rect.left, rect.top + rect.height), bottomRight(rect.left + rect.width, rect.top + rect.height);
+    segments.push_back({topLeft, topRight});
+    segments.push_back({topRight, bottomRight});
+    segments.push_back({bottomRight, bottomLeft});
+    segments.push_back({bottomLeft, topLeft});
+  }
+  buildGrid();
+}
+
+/**
+ * Indexes every segment in each grid cell its bounding box touches
+*/
+void WallMap::buildGrid() {
+  columns = rows = 0;
+  cellStart.assign(1, 0);
+  cellSegments.clear();
+  if (segments.empty()) return;
+
+  sf::Vector2f minimum = segments[0].a, maximum = minimum;
+  for (auto &segment : segments) {
+    for (auto &p : {segment.a, segment.b}) {
+      minimum = sf::Vector2f(std::min(minimum.x, p.x), std::min(minimum.y, p.y));
+      maximum = sf::Vector2f(std::max(maximum.x, p.x), std::max(maximum.y, p.y));
+    }
+  }
+  origin = minimum;
+  columns = (int)((maximum.x - minimum.x) / cellSize) + 1;
+  rows = (int)((maximum.y - minimum.y) / cellSize) + 1;
+
+  // Counted first, then filled, so every cell's segments are contiguous
+  auto forCells = [&](const WallSegment &segment, auto visit) {
+    int x0 = (std::min(segment.a.x, segment.b.x) - origin.x) / cellSize, x1 = (std::max(segment.a.x, segment.b.x) - origin.x) / cellSize;
+    int y0 = (std::min(segment.a.y, segment.b.y) - origin.y) / cellSize, y1 = (std::max(segment.a.y, segment.b.y) - origin.y) / cellSize;
+    for (int y = y0; y <= y1; y++)
+      for (int x = x0; x <= x1; x++) visit(y * columns + x);
+  };
+  cellStart.assign(columns * rows + 1, 0);
+  for (auto &segment : segments) forCells(segment, [&](int cell) { cellStart[cell + 1]++; });
+  for (size_t i = 1; i < cellStart.size(); i++) cellStart[i] += cellStart[i - 1];
+  cellSegments.resize(cellStart.back());
+  std::vector<unsigned int> fill(cellStart.begin(), cellStart.end() - 1);
+  for (unsigned int i = 0; i < segments.size(); i++) forCells(segments[i], [&](int cell) { cellSegments[fill[cell]++] = i; });
+}
+
+/**
+ * Finds the segments in every grid cell overlapping an area
+ * @param area The world space area
+ * @param out The indices of the segments, each listed once
+*/
+void WallMap::query(const sf::FloatRect &area, std::pmr::vector<unsigned int> &out) const {
+  out.clear();
+  if (columns == 0) return;
+  int x0 = std::max(0, (int)std::floor((area.left - origin.x) / cellSize));
+  int y0 = std::max(0, (int)std::floor((area.top - origin.y) / cellSize));
+  int x1 = std::min(columns - 1, (int)std::floor((area.left + area.width - origin.x) / cellSize));
+  int y1 = std::min(rows - 1, (int)std::floor((area.top + area.height - origin.y) / cellSize));
+  for (int y = y0; y <= y1; y++)
+    for (int x = x0; x <= x1; x++)
+      out.insert(out.end(), cellSegments.begin() + cellStart[y * columns + x], cellSegments.begin() + cellStart[y * columns + x + 1]);
+  std::sort(out.begin(), out.end());
+  out.erase(std::unique(out.begin(), out.end()), out.end());
+}
+
+/**
+ * Computes the area visible from a point within a radius
+ * Note: Casts rays just either side of every nearby segment endpoint and around the radius, keeping the
+ *       nearest hit of each; the rays are sorted by angle so the result is a triangle fan
+ * @param center The point being seen from
+ * @param radius The furthest distance seen
+ * @param polygon The visible outline in angular order around the center
+*/
+void WallMap::visibility(sf::Vector2f center, float radius, std::vector<sf::Vector2f> &polygon) const {
+  // The query results and ray angles are released when this returns, as each light is computed
+  FrameArenaScope scratch;
+  std::pmr::vector<unsigned int> nearby(&scratch.get());
+  std::pmr::vector<float> angles(&scratch.get());
+  query(sf::FloatRect(center.x - radius, center.y - radius, radius * 2, radius * 2), nearby);
+
+  // Only edges facing the center can be the first thing a ray hits, and only those within the radius matter
+  size_t kept = 0;
+  for (unsigned int index : nearby) {
+    const WallSegment &segment = segments[index];
+    sf::Vector2f edge = segment.b - segment.a, toCenter = center - segment.a;
+    if (edge.y * toCenter.x - edge.x * toCenter.y <= 0) continue;
+    float length = edge.x * edge.x + edge.y * edge.y;
+    float along = length > 0 ? std::clamp((toCenter.x * edge.x + toCenter.y * edge.y) / length, 0.f, 1.f) : 0;
+    sf::Vector2f closest = toCenter - edge * along;
+    if (closest.x * closest.x + closest.y * closest.y > radius * radius) continue;
+    nearby[kept++] = index;
+  }
+  nearby.resize(kept);
+
+  angles.reserve(CIRCLE_SAMPLES + nearby.size() * 4);
+  for (int i = 0; i < CIRCLE_SAMPLES; i++) angles.push_back(TWO_PI * i / CIRCLE_SAMPLES);
+  for (unsigned int index : nearby) {
+    for (auto &p : {segments[index].a, segments[index].b}) {
+      sf::Vector2f d = p - center;
+      if (d.x * d.x + d.y * d.y > radius * radius) continue;
+      float angle = std::atan2(d.y, d.x);
+      angles.insert(angles.end(), {angle - CORNER_EPSILON, angle + CORNER_EPSILON});
+    }
+  }
+  std::sort(angles.begin(), angles.end());
+
+  polygon.clear();
+  for (float angle : angles) {
+    sf::Vector2f direction(std::cos(angle), std::sin(angle));
+    float nearest = radius;
+    for (unsigned int index : nearby) {
+      const WallSegment &segment = segments[index];
+      sf::Vector2f edge = segment.b - segment.a, toStart = segment.a - center;
+      float denominator = cross(direction, edge);
+      if (std::fabs(denominator) < 1e-9f) continue;
+      float t = cross(toStart, edge) / denominator, u = cross(toStart, direction) / denominator;
+      if (t >= 0 && t < nearest && u >= -SEAM_EPSILON && u <= 1 + SEAM_EPSILON) nearest = t;
+    }
+    polygon.push_back(center + direction * nearest);
+  }
+}
+
+/**
+ * Checks whether the straight line between two points crosses any wall
+ * @param from The start point
+ * @param to The end point
+ * @return Whether the points can see each other
+*/
+bool WallMap::lineOfSight(sf::Vector2f from, sf::Vector2f to) const {
+  FrameArenaScope scratch;
+  std::pmr::vector<unsigned int> nearby(&scratch.get());
+  query(sf::FloatRect(std::min(from.x, to.x), std::min(from.y, to.y), std::fabs(to.x - from.x), std::fabs(to.y - from.y)), nearby);
+  sf::Vector2f line = to - from;
+  for (unsigned int index : nearby) {
+    const WallSegment &segment = segments[index];
+    sf::Vector2f edge = segment.b - segment.a, toStart = segment.a - from;
+    float denominator = cross(line, edge);
+    if (std::fabs(denominator) < 1e-9f) continue;
+    float t = cross(toStart, edge) / denominator, u = cross(toStart, line) / denominator;
+    if (t > 0 && t < 1 && u >= 0 && u <= 1) return false;
+  }
+  return true;
+}
+
+/**
+ * Defines the threads sharing visibility polygons with the caller, started once so no thread is created per frame
+*/
+class VisibilityWorkers {
+  private:
+    std::vector<std::thread> threads;
+    std::mutex mutex;
+    std::condition_variable wake, finished;
+    const WallMap *map = nullptr;
+    const std::vector<Light> *lights = nullptr;
+    std::vector<std::vector<sf::Vector2f>> *polygons = nullptr;
+    unsigned int stride = 1, running = 0;
+    std::uint64_t generation = 0;
+    bool stopping = false;
+
+    /**
+     * Computes every stride-th light from the first given
+    */
+    void share(unsigned int first) {
+      for (size_t i = first; i < lights->size(); i += stride) map->visibility((*lights)[i].position, (*lights)[i].radius, (*polygons)[i]);
+    }
+
+    /**
+     * Waits for each call, taking a share if the call uses this worker
+     * Note: Each worker's frame arena lives as long as the worker, and is reset after each share so a share that overflowed grows it
+    */
+    void work(unsigned int index) {
+      std::uint64_t seen = 0;
+      std::unique_lock<std::mutex> lock(mutex);
+      while (true) {
+        wake.wait(lock, [&]() { return stopping || generation != seen; });
+        if (stopping) return;
+        seen = generation;
+        if (index + 1 >= stride) continue;
+        lock.unlock();
+        share(index + 1);
+        FrameArena::local().reset();
+        lock.lock();
+        if (--running == 0) finished.notify_one();
+      }
+    }
+
+  public:
+    VisibilityWorkers(unsigned int count) {
+      for (unsigned int i = 0; i < count; i++) threads.emplace_back(&VisibilityWorkers::work, this, i);
+    }
+
+    ~VisibilityWorkers() {
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+      }
+      wake.notify_all();
+      for (auto &thread : threads) thread.join();
+    }
+
+    size_t size() const { return threads.size(); }
+
+    /**
+     * Computes every light's polygon on the given number of threads, the caller taking the first share rather than waiting idle
+    */
+    void run(const WallMap &wallMap, const std::vector<Light> &allLights, std::vector<std::vector<sf::Vector2f>> &allPolygons, unsigned int count) {
+      if (count <= 1) {
+        for (size_t i = 0; i < allLights.size(); i++) wallMap.visibility(allLights[i].position, allLights[i].radius, allPolygons[i]);
+        return;
+      }
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        map = &wallMap;
+        lights = &allLights;
+        polygons = &allPolygons;
+        stride = count;
+        running = count - 1;
+        generation++;
+      }
+      wake.notify_all();
+      share(0);
+      std::unique_lock<std::mutex> lock(mutex);
+      finished.wait(lock, [&]() { return running == 0; });
+    }
+};
+
+/**
+ * Computes the visibility polygon of every light, splitting the lights across threads
+ * Note: The threads are started on the first call and kept, so they are woken rather than created each frame
+ * @param map The walls
+ * @param lights The lights
+ * @param polygons The polygon of each light, in the same order
+ * @param threads The number of threads, or 0 to use one per hardware thread @def{0}
+*/
+void computeVisibility(const WallMap &map, const std::vector<Light> &lights, std::vector<std::vector<sf::Vector2f>> &polygons, unsigned int threads) {
+  PROFILE_SCOPE("computeVisibility");
+  polygons.resize(lights.size());
+  static VisibilityWorkers workers(std::max(1u, std::thread::hardware_concurrency()) - 1);
+  if (threads == 0) threads = workers.size() + 1;
+  threads = std::min<unsigned int>({threads, (unsigned int)workers.size() + 1, (unsigned int)lights.size()});
+  workers.run(map, lights, polygons, std::max(threads, 1u));
+}
+
+/**
+ * Creates the texture the lights are accumulated in
+ * @param width The width in pixels
+ * @param height The height in pixels
+ * @return Whether the texture was created
+*/
+bool LightMap::create(unsigned int width, unsigned int height) {
+  if (!target.create(width, height)) return false;
+  sprite.setTexture(target.getTexture(), true);
+  return true;
+}
+
+/**
+ * Rebuilds each light's mask as a triangle fan fading with distance, and accumulates them over the ambient colour
+ * @param lights The lights
+ * @param polygons The visibility polygon of each light
+ * @param view The world area the light map covers, normally the window's view
+*/
+void LightMap::update(const std::vector<Light> &lights, const std::vector<std::vector<sf::Vector2f>> &polygons, const sf::View &view) {
+  PROFILE_SCOPE("LightMap::update");
+  masks.resize(lights.size());
+  for (size_t i = 0; i < lights.size(); i++) {
+    const Light &light = lights[i];
+    const std::vector<sf::Vector2f> &polygon = polygons[i];
+    sf::VertexArray &mask = masks[i];
+    mask.setPrimitiveType(sf::TriangleFan);
+    mask.resize(polygon.empty() ? 0 : polygon.size() + 2);
+    if (polygon.empty()) continue;
+
+    mask[0] = sf::Vertex(light.position, light.color);
+    for (size_t p = 0; p <= polygon.size(); p++) {
+      const sf::Vector2f &point = polygon[p % polygon.size()];
+      sf::Vector2f d = point - light.position;
+      float falloff = std::max(0.f, 1 - std::sqrt(d.x * d.x + d.y * d.y) / light.radius);
+      mask[p + 1] = sf::Vertex(point, sf::Color(light.color.r * falloff, light.color.g * falloff, light.color.b * falloff));
+    }
+  }
+
+  target.setView(view);
+  target.clear(ambient);
+  for (auto &mask : masks) target.draw(mask, sf::BlendAdd);
+  target.display();
+
+  sf::Vector2u size = target.getSize();
+  sprite.setPosition(view.getCenter() - view.getSize() / 2.f);
+  sprite.setScale(view.getSize().x / size.x, view.getSize().y / size.y);
+}
+
+/**
+ * Multiplies the accumulated light over the scene
+*/
+void LightMap::draw(sf::RenderTarget &window, sf::RenderStates states) const {
+  states.blendMode = sf::BlendMultiply;
+  window.draw(sprite, states);
+}